@@ -0,0 +1,24 @@
+#ifndef BSP_H
+#define BSP_H
+#include <stdint.h>
+
+/*
+ * Board support: everything the control code needs from the hardware, so
+ * that it builds and runs anywhere the functions below exist. bsp_stm32.c
+ * is the board (TIM3 input capture, the SPI encoder, TIM2 PWM, the DWT
+ * counter and the ILC flash page); host/bsp_host.c is a plant a Linux
+ * program sets and reads (make host).
+ */
+
+/** @brief Bytes bspStore() holds **/
+#define BSP_STORE_BYTES 1024
+
+void bspInit(void);
+uint16_t bspArmCapture(void);
+uint16_t bspPendEncoder(void);
+void bspPwm(uint16_t a, uint16_t b, uint16_t c);
+uint32_t bspCycles(void);
+const void * bspStore(void);
+uint8_t bspStoreWrite(const void * data, uint16_t len);
+
+#endif
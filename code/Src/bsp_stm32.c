@@ -0,0 +1,194 @@
+#include "bsp.h"
+#include "stm32f1xx_hal.h"
+#include "cmsis_os.h"
+
+/*
+ * Board support for the STM32F103 board, see bsp.h. The peripherals are
+ * set up by the MX_*_Init() functions in main.c; this only starts and
+ * uses them.
+ *
+ *    arm capture   TIM3 channel 2, captured motor position, read directly
+ *    pendulum      magnetic encoder on SPI1, chip select PA15
+ *    motor         TIM2 channels 1 to 3, one per phase
+ *    cycles        DWT->CYCCNT, started by clockInit()
+ *    store         the ILC page the linker script reserves in flash
+ */
+
+extern TIM_HandleTypeDef htim2;
+extern TIM_HandleTypeDef htim3;
+extern SPI_HandleTypeDef hspi1;
+
+/** @brief Start of the ILC region, the last flash page **/
+extern const uint16_t _silc[];
+
+/** @brief Address of the control register  **/
+#define CTRL 0x1E //2 bytes 
+/** @brief address of the Angle register**/
+#define ANG 0x20 //2 bytes 
+/** @brief address of the status register**/
+#define STA 0x22 //2 bytes 
+/** @brief address of the field strength register**/
+#define FIELD 0x2A //2 bytes 
+/** @brief key needed to start running spi encoder**/
+#define CDS_KEYCODE 0x46 
+
+
+
+//-------------------------------------------------------------------------------------
+/** @brief   Writes val to the addr via SPI
+ *  @details This function sets SS pin low, transmits the 16 bits
+ *           (0x4000 | addr << 8 | val) and then releases SS pin.
+ *           it returns the data recieved via spi.
+ *  @param   addr The address to write to
+ *  @param   val The value to put in the address
+ *  @return   The data recieved via spi
+ */
+static uint16_t spiWrite(uint8_t addr, uint8_t val) {
+   uint16_t num = 0x4000 | addr << 8 | val;
+   uint16_t rxData;
+   HAL_GPIO_WritePin(GPIOA, GPIO_PIN_15, GPIO_PIN_RESET);
+   HAL_SPI_TransmitReceive(&hspi1, (uint8_t *)&num, (uint8_t *)&rxData, 1, 0xFF);
+   HAL_GPIO_WritePin(GPIOA, GPIO_PIN_15, GPIO_PIN_SET);
+   return rxData;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Reads the value at the given address
+ *  @details Transmits the address to read, then transmits again to
+ *           get the response. This function then returns the value
+ *           recieved via spi
+ *  @param   addr The address to read from the spi encoder
+ *  @return   The value at the given address
+ */
+static uint16_t spiRead(uint8_t addr) {
+   uint16_t num = addr << 8;
+   uint16_t pRxData;
+   HAL_GPIO_WritePin(GPIOA, GPIO_PIN_15, GPIO_PIN_RESET);
+   HAL_SPI_TransmitReceive(&hspi1, (uint8_t *)&num, (uint8_t *)&pRxData, 1, 0xFF);
+   HAL_GPIO_WritePin(GPIOA, GPIO_PIN_15, GPIO_PIN_SET);
+
+   num = 0;
+   HAL_GPIO_WritePin(GPIOA, GPIO_PIN_15, GPIO_PIN_RESET);
+   HAL_SPI_TransmitReceive(&hspi1, (uint8_t *)&num, (uint8_t *)&pRxData, 1, 0xFF);
+   HAL_GPIO_WritePin(GPIOA, GPIO_PIN_15, GPIO_PIN_SET);
+   return pRxData;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Start the capture, the PWM with the motor off and the encoder
+ *  @details From a task, waits 100 ms for the encoder to come up.
+ */
+void bspInit(void) {
+   //Start capture, CCR2 is read directly so no interrupt
+   HAL_TIM_IC_Start(&htim3, TIM_CHANNEL_2);
+   HAL_TIM_IC_Start(&htim3, TIM_CHANNEL_1);
+
+   HAL_TIM_PWM_Start(&htim2, TIM_CHANNEL_1); 
+   HAL_TIM_PWM_Start(&htim2, TIM_CHANNEL_2);
+   HAL_TIM_PWM_Start(&htim2, TIM_CHANNEL_3);
+
+   bspPwm(0, 0, 0);
+   osDelay(100);
+   
+   spiWrite(CTRL, 0xC0);
+   spiWrite(CTRL, 0xC0);
+   spiWrite(CTRL+1, CDS_KEYCODE);
+   spiRead(ANG);
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Arm motor position
+ *  @return  TIM3 CCR2, the input capture count, wraps at 65536
+ */
+uint16_t bspArmCapture(void) {
+   return htim3.Instance->CCR2;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Raw pendulum encoder reading
+ *  @details Two SPI transfers, a few microseconds.
+ *  @return  The angle register, 65536 per rev
+ */
+uint16_t bspPendEncoder(void) {
+   return spiRead(ANG);
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief    Set PWM duty cycle for a, b, and c outputs (12 bit inputs)
+ *  @details  This function is used to set the duty cycle for each of the
+ *            3 pwm output waveforms by setting the timer compare register.
+ *            It assumes a 12 bit input, thus bit shift..
+ *          
+ *  @param   a The 12 bit duty cycle for tim2 channel 1 output
+ *  @param   b The 12 bit duty cycle for tim2 channel 2 output
+ *  @param   c The 12 bit duty cycle for tim2 channel 3 output
+ */
+void bspPwm(uint16_t a, uint16_t b, uint16_t c) {
+   /* for some reason, the polarity must be low for the numbers
+      to make sense (i.e. bigger == longer high pulse) */
+   __HAL_TIM_SET_COMPARE(&htim2, TIM_CHANNEL_1, a << 3 ); 
+   __HAL_TIM_SET_COMPARE(&htim2, TIM_CHANNEL_2, b << 3 );
+   __HAL_TIM_SET_COMPARE(&htim2, TIM_CHANNEL_3, c << 3 );
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Core cycles, from whenever the counter started
+ *  @details 72 MHz, wraps about every 60 s; only differences mean
+ *           anything.
+ *  @return  DWT->CYCCNT
+ */
+uint32_t bspCycles(void) {
+   return DWT->CYCCNT;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Storage kept over resets and reflashing
+ *  @return  BSP_STORE_BYTES, all 0xFF when never written
+ */
+const void * bspStore(void) {
+   return _silc;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Replace what bspStore() holds
+ *  @details Erasing the page stalls the CPU for ~20 ms, including
+ *           interrupts that execute from flash, so only call this with
+ *           the motor off. The rest of the page reads 0xFF after.
+ *  @param   data Data, 2 byte aligned
+ *  @param   len Bytes, even, at most BSP_STORE_BYTES
+ *  @return  1 if written and read back, 0 if too long or flash failed
+ */
+uint8_t bspStoreWrite(const void * data, uint16_t len) {
+   FLASH_EraseInitTypeDef erase;
+   uint32_t pageError;
+   const uint16_t * h = data;
+   uint16_t i;
+   uint8_t ok = 1;
+
+   if(len > BSP_STORE_BYTES || len & 1) {
+      return 0;
+   }
+   erase.TypeErase = FLASH_TYPEERASE_PAGES;
+   erase.Banks = FLASH_BANK_1;
+   erase.PageAddress = (uint32_t)_silc;
+   erase.NbPages = 1;
+
+   HAL_FLASH_Unlock();
+   if(HAL_FLASHEx_Erase(&erase, &pageError) != HAL_OK) {
+      ok = 0;
+   }
+   for(i = 0; ok && i < len / 2; i++) {
+      if(HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, (uint32_t)&_silc[i], h[i]) != HAL_OK) {
+         ok = 0;
+      }
+   }
+   HAL_FLASH_Lock();
+
+   /* read back */
+   for(i = 0; ok && i < len / 2; i++) {
+      if(_silc[i] != h[i]) {
+         ok = 0;
+      }
+   }
+   return ok;
+}
@@ -0,0 +1,279 @@
+#include "capture.h"
+#include "telemetry.h"
+#include "stm32f1xx.h"
+#include <string.h>
+
+/*
+ * Burst capture: every control tick over a short window, for step
+ * responses and catch transients that the decimated state records cannot
+ * show.
+ *
+ * The buffer is the CAPTURE region the linker script keeps at the top of
+ * RAM, so everything else has to fit below it and running out shows at
+ * link time. It is split into one column per armed channel (struct of
+ * arrays): the control loop stores one cell per column at a common index
+ * each tick, and a dump walks each column in order.
+ *
+ * While armed the columns are a circular history. The trigger fixes where
+ * the capture ends: up to pre samples before it, the trigger sample and
+ * the rest of the columns after it. The control interrupt does the
+ * recording; the telemetry task arms, stops and dumps, and touches the
+ * settings and columns only while the interrupt does not, i.e. idle or
+ * done. captureArm() puts a barrier after the idle store and one before
+ * the armed store, so the new settings are never seen half written.
+ */
+
+/* start of the CAPTURE region, CAPTURE_BYTES long */
+extern int16_t _scapture[];
+static int16_t * const cells = _scapture;
+
+static volatile uint8_t state;
+static volatile uint8_t trigRequest;
+
+/* settings, written by the task while idle or done */
+static uint8_t channels;
+static uint8_t chans[PROTO_CH_COUNT];
+static uint8_t count;
+static uint8_t trigger;
+static uint16_t depth;
+static uint16_t pre;
+
+/* recording, control interrupt */
+static uint16_t head;
+static uint16_t filled;
+static uint16_t left;
+static uint8_t lastLaw;
+
+/* result, complete before the state turns done */
+static uint16_t first;
+static uint16_t len;
+static uint16_t trigAt;
+static uint32_t startTime;
+
+/* dump, telemetry task: 0 none, 1 info next, 2 data next */
+static uint8_t dumping;
+static uint8_t dumpChan;
+static uint16_t dumpAt;
+
+
+//-------------------------------------------------------------------------------------
+/** @brief   Start idle, call before the scheduler and the control loop start
+ */
+void captureInit(void) {
+   state = PROTO_CAP_IDLE;
+   trigRequest = 0;
+   dumping = 0;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Clamp to int16
+ *  @param   x Value
+ *  @return  x limited to +-32767
+ */
+static int16_t captureSat(int32_t x) {
+   if(x > 32767) {
+      return 32767;
+   }
+   if(x < -32767) {
+      return -32767;
+   }
+   return x;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   One sample of a channel
+ *  @param   ch protoCapChannel_t
+ *  @param   s Current state
+ *  @return  Sample, see protoCapChannel_t
+ */
+static int16_t captureValue(uint8_t ch, const ctrlState_t * s) {
+   switch(ch) {
+   case PROTO_CH_ARM:
+      return (int16_t)s->arm;
+   case PROTO_CH_ARM_RATE:
+      return captureSat(s->armRate >> CAPTURE_RATE_SHIFT);
+   case PROTO_CH_PEND:
+      return (int16_t)s->pend;
+   case PROTO_CH_PEND_RATE:
+      return captureSat(s->pendRate >> CAPTURE_RATE_SHIFT);
+   case PROTO_CH_TORQUE:
+      return s->lastOut;
+   default:
+      return (int16_t)s->armRef;
+   }
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Start recording, drops any earlier capture
+ *  @details Telemetry task. The columns are CAPTURE_CELLS / channels
+ *           samples long, e.g. 3072 ticks of one channel or 1024 of three.
+ *  @param   mask Bit n records protoCapChannel_t n
+ *  @param   trig protoCapTrigger_t
+ *  @param   history Samples to keep from before the trigger, less than a
+ *           column
+ *  @return  1 if armed, 0 if the arguments are out of range
+ */
+uint8_t captureArm(uint8_t mask, uint8_t trig, uint16_t history) {
+   uint8_t c, n = 0;
+
+   for(c = 0; c < PROTO_CH_COUNT; c++) {
+      n += (mask >> c) & 1;
+   }
+   if(!n || mask >> PROTO_CH_COUNT || trig > PROTO_TRIG_LAW || history >= CAPTURE_CELLS / n) {
+      return 0;
+   }
+
+   state = PROTO_CAP_IDLE;
+   __DMB();
+   dumping = 0;
+   channels = mask;
+   count = 0;
+   for(c = 0; c < PROTO_CH_COUNT; c++) {
+      if(mask & (1 << c)) {
+         chans[count++] = c;
+      }
+   }
+   trigger = trig;
+   depth = CAPTURE_CELLS / n;
+   pre = history;
+   head = 0;
+   filled = 0;
+   trigRequest = 0;
+   lastLaw = ctrlActive();
+   __DMB();
+   state = PROTO_CAP_ARMED;
+   return 1;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Trigger an armed capture at the next control tick
+ *  @return  1 if armed, 0 if not
+ */
+uint8_t captureTrigger(void) {
+   if(state != PROTO_CAP_ARMED) {
+      return 0;
+   }
+   trigRequest = 1;
+   return 1;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Send a finished capture, from the following capturePoll() calls
+ *  @return  1 if there is one, 0 if not
+ */
+uint8_t captureDump(void) {
+   if(state != PROTO_CAP_DONE) {
+      return 0;
+   }
+   dumping = 1;
+   dumpChan = 0;
+   dumpAt = 0;
+   return 1;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Stop recording or dumping and drop the capture
+ */
+void captureStop(void) {
+   state = PROTO_CAP_IDLE;
+   dumping = 0;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Where the capture is
+ *  @return  State
+ */
+protoCapState_t captureState(void) {
+   return state;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Record a control tick, from the control loop after ctrlStep()
+ *  @details A few stores per armed channel, nothing when idle or done.
+ *  @param   s State of this tick
+ */
+void captureSample(const ctrlState_t * s) {
+   uint8_t st = state;
+   int16_t * col = cells + head;
+   uint8_t law, c;
+
+   if(st != PROTO_CAP_ARMED && st != PROTO_CAP_TRIGGERED) {
+      return;
+   }
+   for(c = 0; c < count; c++, col += depth) {
+      *col = captureValue(chans[c], s);
+   }
+   if(++head == depth) {
+      head = 0;
+   }
+   if(filled < depth) {
+      filled++;
+   }
+
+   if(st == PROTO_CAP_ARMED) {
+      law = ctrlActive();
+      if(!trigRequest && (trigger != PROTO_TRIG_LAW || law == lastLaw)) {
+         lastLaw = law;
+         return;
+      }
+      trigAt = filled - 1 < pre ? filled - 1 : pre;
+      left = depth - pre;
+      state = PROTO_CAP_TRIGGERED;
+   }
+   if(--left == 0) {
+      len = trigAt + depth - pre;
+      first = head >= len ? head - len : head + depth - len;
+      startTime = s->time - (len - 1) * (1000000 / CTRL_HZ);
+      state = PROTO_CAP_DONE;
+   }
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Send the next part of a dump, from the telemetry task
+ *  @details Up to CAPTURE_CHUNKS_PER_POLL messages per call, so state
+ *           records keep going out in between.
+ */
+void capturePoll(void) {
+   uint8_t body[sizeof(protoCaptureData_t) + 2 * PROTO_CAPTURE_CHUNK];
+   protoCaptureInfo_t info;
+   protoCaptureData_t hdr;
+   const int16_t * col;
+   uint16_t n, i, k;
+   uint8_t sent;
+
+   if(dumping == 1) {
+      info.channels = channels;
+      info.len = len;
+      info.trigger = trigAt;
+      info.time = startTime;
+      info.rate = CTRL_HZ;
+      telemSend(PROTO_CAPTURE_INFO, &info, sizeof(info));
+      dumping = 2;
+   }
+   for(sent = 0; sent < CAPTURE_CHUNKS_PER_POLL && dumping; sent++) {
+      n = len - dumpAt < PROTO_CAPTURE_CHUNK ? len - dumpAt : PROTO_CAPTURE_CHUNK;
+      hdr.channel = chans[dumpChan];
+      hdr.index = dumpAt;
+      memcpy(body, &hdr, sizeof(hdr));
+      col = cells + dumpChan * depth;
+      k = first + dumpAt;
+      if(k >= depth) {
+         k -= depth;
+      }
+      for(i = 0; i < n; i++) {
+         memcpy(body + sizeof(hdr) + 2 * i, &col[k], 2);
+         if(++k == depth) {
+            k = 0;
+         }
+      }
+      telemSend(PROTO_CAPTURE_DATA, body, sizeof(hdr) + 2 * n);
+
+      dumpAt += n;
+      if(dumpAt == len) {
+         dumpAt = 0;
+         if(++dumpChan == count) {
+            dumping = 0;
+         }
+      }
+   }
+}
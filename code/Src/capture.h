@@ -0,0 +1,25 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+#include <stdint.h>
+#include "proto.h"
+#include "control.h"
+
+/** @brief Bytes of the CAPTURE region in STM32F103C8Tx_FLASH.ld **/
+#define CAPTURE_BYTES 6144
+/** @brief int16 samples the buffer holds, shared by the armed channels **/
+#define CAPTURE_CELLS (CAPTURE_BYTES / 2)
+/** @brief Rates are stored as counts/s >> CAPTURE_RATE_SHIFT **/
+#define CAPTURE_RATE_SHIFT 5
+/** @brief Most CAPTURE_DATA messages sent per capturePoll() **/
+#define CAPTURE_CHUNKS_PER_POLL 4
+
+void captureInit(void);
+uint8_t captureArm(uint8_t channels, uint8_t trigger, uint16_t pre);
+uint8_t captureTrigger(void);
+uint8_t captureDump(void);
+void captureStop(void);
+protoCapState_t captureState(void);
+void captureSample(const ctrlState_t * s);
+void capturePoll(void);
+
+#endif
@@ -0,0 +1,151 @@
+#include "chan.h"
+#include "telemetry.h"
+#include "stm32f1xx.h"
+#include <string.h>
+
+/*
+ * Telemetry channels: the signals in protoChans, each sent at the
+ * decimation the host subscribed it at (CMD_SUBSCRIBE), so the link
+ * carries only what is being looked at. The control interrupt packs the
+ * channels due at a tick into one CHANNELS message in the telemetry ring;
+ * a channel is due when its decimation divides the tick, so channels at
+ * the same or related rates share messages. Nothing keeps the host from
+ * asking for more than the link carries: what does not fit the ring is
+ * dropped and counted like state records.
+ */
+
+/* written by the telemetry task, 0 for off, read by the control interrupt */
+static volatile uint16_t decims[PROTO_CHAN_COUNT];
+static volatile uint16_t subscribed;
+
+
+//-------------------------------------------------------------------------------------
+/** @brief   No channels, call before the control loop starts
+ */
+void chanInit(void) {
+   uint8_t c;
+
+   for(c = 0; c < PROTO_CHAN_COUNT; c++) {
+      decims[c] = 0;
+   }
+   subscribed = 0;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Subscribe or unsubscribe a channel
+ *  @details Telemetry task. Takes effect at the next control tick.
+ *  @param   ch protoChanId_t
+ *  @param   decim Control ticks per value, 0 to stop it
+ *  @return  1 if done, 0 if there is no such channel
+ */
+uint8_t chanSubscribe(uint8_t ch, uint16_t decim) {
+   if(ch >= PROTO_CHAN_COUNT) {
+      return 0;
+   }
+   decims[ch] = decim;
+   if(decim) {
+      subscribed |= 1 << ch;
+   } else {
+      subscribed &= ~(1 << ch);
+   }
+   return 1;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Channels subscribed to
+ *  @return  Bit n set for channel n
+ */
+uint16_t chanSubscribed(void) {
+   return subscribed;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Current value of a channel
+ *  @param   ch protoChanId_t
+ *  @param   s Control state
+ *  @param   latency Interrupt latency of this tick, cycles
+ *  @param   busy Length of the previous control period, cycles
+ *  @param   overruns Late control periods
+ *  @return  Value, sent as its low protoChans[ch].size bytes
+ */
+static uint32_t chanValue(uint8_t ch, const ctrlState_t * s, uint32_t latency,
+                          uint32_t busy, uint32_t overruns) {
+   switch(ch) {
+   case PROTO_CHAN_PEND:
+      return s->pend;
+   case PROTO_CHAN_ARM:
+      return s->arm;
+   case PROTO_CHAN_PEND_RATE:
+      return s->pendRate;
+   case PROTO_CHAN_ARM_RATE:
+      return s->armRate;
+   case PROTO_CHAN_TORQUE:
+      return s->lastOut;
+   case PROTO_CHAN_ARM_REF:
+      return s->armRef;
+   case PROTO_CHAN_LAW:
+      return ctrlActive();
+   case PROTO_CHAN_PWM_A:
+      return TIM2->CCR1;
+   case PROTO_CHAN_PWM_B:
+      return TIM2->CCR2;
+   case PROTO_CHAN_PWM_C:
+      return TIM2->CCR3;
+   case PROTO_CHAN_LATENCY:
+      return latency;
+   case PROTO_CHAN_BUSY:
+      return busy;
+   case PROTO_CHAN_OVERRUNS:
+      return overruns;
+   default:
+      return telemDrops();
+   }
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Send the channels due at this tick, from the control loop
+ *  @details One modulo per subscribed channel and a few stores per due
+ *           one; nothing at all with no subscriptions.
+ *  @param   s Control state after ctrlStep()
+ *  @param   latency Interrupt latency of this tick, cycles
+ *  @param   busy Length of the previous control period, cycles
+ *  @param   overruns Late control periods
+ */
+void chanSample(const ctrlState_t * s, uint32_t latency, uint32_t busy, uint32_t overruns) {
+   uint16_t mask = subscribed;
+   uint16_t due = 0;
+   protoChannels_t head;
+   uint8_t * body;
+   uint16_t len;
+   uint32_t v;
+   uint8_t c;
+
+   if(!mask) {
+      return;
+   }
+   for(c = 0; c < PROTO_CHAN_COUNT; c++) {
+      uint16_t d = decims[c];
+      if(mask & (1 << c) && d && s->tick % d == 0) {
+         due |= 1 << c;
+      }
+   }
+   if(!due) {
+      return;
+   }
+   body = telemReserveBody(PROTO_CHANNELS, CHAN_BODY_MAX);
+   if(!body) {
+      return;
+   }
+   head.time = s->time;
+   head.mask = due;
+   memcpy(body, &head, sizeof(head));
+   len = sizeof(head);
+   for(c = 0; c < PROTO_CHAN_COUNT; c++) {
+      if(due & (1 << c)) {
+         v = chanValue(c, s, latency, busy, overruns);
+         memcpy(body + len, &v, protoChans[c].size);
+         len += protoChans[c].size;
+      }
+   }
+   telemCommitBody(len);
+}
@@ -0,0 +1,15 @@
+#ifndef CHAN_H
+#define CHAN_H
+#include <stdint.h>
+#include "proto.h"
+#include "control.h"
+
+/** @brief Room for a CHANNELS body with every channel due **/
+#define CHAN_BODY_MAX (sizeof(protoChannels_t) + 4 * PROTO_CHAN_COUNT)
+
+void chanInit(void);
+uint8_t chanSubscribe(uint8_t ch, uint16_t decim);
+uint16_t chanSubscribed(void);
+void chanSample(const ctrlState_t * s, uint32_t latency, uint32_t busy, uint32_t overruns);
+
+#endif
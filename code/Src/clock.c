@@ -0,0 +1,101 @@
+#include "clock.h"
+#include "rtstats.h"
+#include "seqlock.h"
+#include "stm32f1xx.h"
+
+/*
+ * Free-running microsecond clock for time stamps, counted from the DWT
+ * cycle counter. CYCCNT wraps every 60 s at 72 MHz, so the control
+ * interrupt calls clockUpdate() every tick to move the whole microseconds
+ * since the last call into a 32 bit count; the cycles of the fraction
+ * stay behind for the next call, so no time is lost to rounding. The
+ * count wraps every 71 minutes, the host unwraps it. Between updates
+ * clockUs() adds the cycles since the last one, so readers get the full
+ * resolution.
+ *
+ * Until the control interrupt starts, SysTick keeps the clock through
+ * clockTick(). clockHandOver() ends that right before the control
+ * interrupt starts, so there is only ever one writer.
+ *
+ * The clock runs at the crystal's rate. The host measures that against
+ * its own clock with CMD_PING (proto.h, telemdec::ClockSync).
+ */
+
+static uint32_t cyclesPerUs;
+static volatile uint8_t handedOver;
+
+/* last update, control interrupt (SysTick at boot) to everyone else,
+   see seqlock.h */
+static uint32_t baseUs;
+static uint32_t baseCycles;
+static volatile uint32_t clockSeq;
+
+
+//-------------------------------------------------------------------------------------
+/** @brief   Start the clock at 0, call before the control loop starts
+ *  @details Starts the cycle counter as well; rtstatsTimerInit() later
+ *           leaves it running.
+ */
+void clockInit(void) {
+   CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+   DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+   cyclesPerUs = SystemCoreClock / 1000000;
+   baseUs = 0;
+   baseCycles = rtstatsCycles();
+   handedOver = 0;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Keep the clock until the control interrupt runs, from SysTick
+ *  @details Call with the interrupts that read the clock masked: they
+ *           preempt SysTick and would wait for this update forever.
+ */
+void clockTick(void) {
+   if(!handedOver) {
+      clockUpdate();
+   }
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Leave clockUpdate() to the control interrupt from now on
+ *  @details Call from a task right before starting the control interrupt.
+ *           A clockTick() in progress cannot be interrupted by a task, so
+ *           none runs once this returns.
+ */
+void clockHandOver(void) {
+   handedOver = 1;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Carry the cycles counted since the last call over, from the
+ *           control interrupt every tick
+ *  @details Must run at least every 2^32 cycles, and only from one place
+ *           at a time, see clockHandOver().
+ *  @return  Microseconds now, as clockUs()
+ */
+uint32_t clockUpdate(void) {
+   uint32_t n = (rtstatsCycles() - baseCycles) / cyclesPerUs;
+
+   seqWriteBegin(&clockSeq);
+   baseUs += n;
+   baseCycles += n * cyclesPerUs;
+   seqWriteEnd(&clockSeq);
+   return baseUs;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Microseconds since clockInit()
+ *  @details Any task or interrupt except those that can preempt the
+ *           control interrupt, which would wait for it forever.
+ *  @return  Time, wraps at 2^32
+ */
+uint32_t clockUs(void) {
+   uint32_t s, us, cycles;
+
+   do {
+      s = seqReadBegin(&clockSeq);
+      us = baseUs;
+      cycles = baseCycles;
+   } while(seqReadRetry(&clockSeq, s));
+   return us + (rtstatsCycles() - cycles) / cyclesPerUs;
+}
@@ -0,0 +1,11 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+#include <stdint.h>
+
+void clockInit(void);
+void clockTick(void);
+void clockHandOver(void);
+uint32_t clockUpdate(void);
+uint32_t clockUs(void);
+
+#endif
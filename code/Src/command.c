@@ -0,0 +1,216 @@
+#include "command.h"
+#include "control.h"
+#include "telemetry.h"
+#include "capture.h"
+#include "chan.h"
+#include "link.h"
+#include "clock.h"
+#include <string.h>
+
+/*
+ * Commands from the host, see proto.h. Runs in the telemetry task, below
+ * the control interrupt, and every command is a fixed amount of work:
+ * a table lookup and one store, one ctrlRequest(), a subscription, a
+ * capture state change or two clock readings for CMD_PING; a capture
+ * dump is sent later by capturePoll(). The control loop sees each change
+ * whole, since parameters are single aligned 8, 16 or 32 bit stores; a
+ * set spread over several parameters, like the four LQR gains, takes
+ * effect one gain at a time, so switch to a law that does not use them
+ * first.
+ */
+
+/** @brief A settable field of ctrlParams and its range **/
+typedef struct {
+   void * value;
+   uint8_t size;       /**< bytes, 1, 2 or 4 */
+   int32_t min;
+   int32_t max;
+} cmdParam_t;
+
+static const cmdParam_t cmdParams[PROTO_PARAM_COUNT] = {
+   [PROTO_PARAM_OPEN_LOOP] = { &ctrlParams.openLoop, 2, -CTRL_TORQUE_MAX, CTRL_TORQUE_MAX },
+   [PROTO_PARAM_KP] = { &ctrlParams.kp, 4, 0, 1L << 16 },
+   [PROTO_PARAM_KI] = { &ctrlParams.ki, 4, 0, 1L << 16 },
+   [PROTO_PARAM_KD] = { &ctrlParams.kd, 4, 0, 1L << 10 },
+   [PROTO_PARAM_LQR0] = { &ctrlParams.lqr[0], 4, -(1L << 20), 1L << 20 },
+   [PROTO_PARAM_LQR0 + 1] = { &ctrlParams.lqr[1], 4, -(1L << 20), 1L << 20 },
+   [PROTO_PARAM_LQR0 + 2] = { &ctrlParams.lqr[2], 4, -(1L << 20), 1L << 20 },
+   [PROTO_PARAM_LQR0 + 3] = { &ctrlParams.lqr[3], 4, -(1L << 20), 1L << 20 },
+   [PROTO_PARAM_W0SQ] = { &ctrlParams.w0sq, 4, 0, 1L << 20 },
+   [PROTO_PARAM_CATCH_WITH] = { &ctrlParams.catchWith, 1, CTRL_OFF, CTRL_COUNT - 1 },
+   [PROTO_PARAM_ARM_SETPOINT] = { &ctrlParams.armSetpoint, 4, -(1L << 16), 1L << 16 }
+};
+
+
+//-------------------------------------------------------------------------------------
+/** @brief   Current value of a parameter
+ *  @param   p Parameter
+ *  @return  Value
+ */
+static int32_t cmdRead(const cmdParam_t * p) {
+   if(p->size == 1) {
+      return *(volatile uint8_t *)p->value;
+   } else if(p->size == 2) {
+      return *(volatile int16_t *)p->value;
+   }
+   return *(volatile int32_t *)p->value;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Store a parameter in one write
+ *  @param   p Parameter
+ *  @param   v Value, in range
+ */
+static void cmdWrite(const cmdParam_t * p, int32_t v) {
+   if(p->size == 1) {
+      *(volatile uint8_t *)p->value = v;
+   } else if(p->size == 2) {
+      *(volatile int16_t *)p->value = v;
+   } else {
+      *(volatile int32_t *)p->value = v;
+   }
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Set or read a parameter
+ *  @param   set 1 to set, 0 to read
+ *  @param   body protoParam_t
+ *  @param   len Body bytes
+ *  @param   reply Filled with status and value
+ */
+static void cmdParam(uint8_t set, const uint8_t * body, uint16_t len, protoReply_t * reply) {
+   protoParam_t msg;
+   const cmdParam_t * p;
+
+   if(len != sizeof(msg)) {
+      reply->status = PROTO_BAD_LEN;
+      return;
+   }
+   memcpy(&msg, body, sizeof(msg));
+   if(msg.param >= PROTO_PARAM_COUNT) {
+      reply->status = PROTO_BAD_PARAM;
+      return;
+   }
+   p = &cmdParams[msg.param];
+   if(set) {
+      if(msg.value < p->min || msg.value > p->max) {
+         reply->status = PROTO_BAD_VALUE;
+      } else {
+         cmdWrite(p, msg.value);
+      }
+   }
+   reply->value = cmdRead(p);
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Control the burst capture
+ *  @param   body protoCapture_t
+ *  @param   len Body bytes
+ *  @param   reply Filled with status and the capture state
+ */
+static void cmdCapture(const uint8_t * body, uint16_t len, protoReply_t * reply) {
+   protoCapture_t msg;
+
+   if(len != sizeof(msg)) {
+      reply->status = PROTO_BAD_LEN;
+   } else {
+      memcpy(&msg, body, sizeof(msg));
+      if(msg.op == PROTO_CAP_STOP) {
+         captureStop();
+      } else if(msg.op == PROTO_CAP_ARM) {
+         if(!captureArm(msg.channels, msg.trigger, msg.pre)) {
+            reply->status = PROTO_BAD_VALUE;
+         }
+      } else if(msg.op == PROTO_CAP_TRIGGER) {
+         if(!captureTrigger()) {
+            reply->status = PROTO_BAD_STATE;
+         }
+      } else if(msg.op == PROTO_CAP_DUMP) {
+         if(!captureDump()) {
+            reply->status = PROTO_BAD_STATE;
+         }
+      } else {
+         reply->status = PROTO_BAD_PARAM;
+      }
+   }
+   reply->value = captureState();
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Subscribe to a channel or drop it
+ *  @param   body protoSubscribe_t
+ *  @param   len Body bytes
+ *  @param   reply Filled with status and the subscribed channels
+ */
+static void cmdSubscribe(const uint8_t * body, uint16_t len, protoReply_t * reply) {
+   protoSubscribe_t msg;
+
+   if(len != sizeof(msg)) {
+      reply->status = PROTO_BAD_LEN;
+   } else {
+      memcpy(&msg, body, sizeof(msg));
+      if(!chanSubscribe(msg.chan, msg.decim)) {
+         reply->status = PROTO_BAD_PARAM;
+      }
+   }
+   reply->value = chanSubscribed();
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Answer CMD_PING with the times it came in and goes out
+ *  @param   seq Frame counter of the ping
+ */
+static void cmdPong(uint16_t seq) {
+   protoPong_t pong;
+
+   pong.seq = seq;
+   pong.rx = linkRxTime();
+   pong.tx = clockUs();
+   telemSend(PROTO_CMD_PONG, &pong, sizeof(pong));
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Carry out one command and reply
+ *  @details Telemetry task only, the reply goes out with telemSend().
+ *  @param   id Message id
+ *  @param   seq Frame counter of the command, echoed in the reply
+ *  @param   body Body
+ *  @param   len Body bytes
+ */
+void cmdDispatch(uint8_t id, uint16_t seq, const uint8_t * body, uint16_t len) {
+   protoReply_t reply;
+
+   if(id == PROTO_CMD_PING) {
+      cmdPong(seq);
+      return;
+   }
+   reply.seq = seq;
+   reply.cmd = id;
+   reply.status = PROTO_OK;
+   reply.value = 0;
+
+   if(id == PROTO_CMD_SET || id == PROTO_CMD_GET) {
+      cmdParam(id == PROTO_CMD_SET, body, len, &reply);
+   } else if(id == PROTO_CMD_MODE) {
+      if(len != 1) {
+         reply.status = PROTO_BAD_LEN;
+      } else if(!ctrlRequest(body[0])) {
+         reply.status = PROTO_BAD_PARAM;
+      }
+      reply.value = len == 1 && reply.status == PROTO_OK ? body[0] : ctrlActive();
+   } else if(id == PROTO_CMD_LOG) {
+      if(len != 1) {
+         reply.status = PROTO_BAD_LEN;
+      } else if(!telemSetLogging(body[0])) {
+         reply.status = PROTO_BAD_VALUE;
+      }
+      reply.value = telemLogging();
+   } else if(id == PROTO_CMD_CAPTURE) {
+      cmdCapture(body, len, &reply);
+   } else if(id == PROTO_CMD_SUBSCRIBE) {
+      cmdSubscribe(body, len, &reply);
+   } else {
+      reply.status = PROTO_BAD_ID;
+   }
+   telemSend(PROTO_CMD_REPLY, &reply, sizeof(reply));
+}
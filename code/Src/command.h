@@ -0,0 +1,8 @@
+#ifndef COMMAND_H
+#define COMMAND_H
+#include <stdint.h>
+#include "proto.h"
+
+void cmdDispatch(uint8_t id, uint16_t seq, const uint8_t * body, uint16_t len);
+
+#endif
@@ -0,0 +1,214 @@
+#include "control.h"
+#include "friction.h"
+#include "ident.h"
+#include "seqlock.h"
+#include "trajectory.h"
+
+/* switch requests, written by the command side, read by ctrlStep() */
+static volatile uint8_t requestId;
+static volatile uint8_t requestSeq;
+static uint8_t seenSeq;
+
+static ctrlId_t active;
+/* jerk limited reference toward ctrlParams.armSetpoint */
+static traj_t armTraj;
+static int32_t armTarget;
+static int32_t blendOffset;
+static uint16_t blendLeft;
+
+/* last state handed out by ctrlPublish() */
+static ctrlState_t published;
+static volatile uint32_t publishedSeq;
+
+
+//-------------------------------------------------------------------------------------
+/** @brief   Start the control loop state with the given law
+ *  @details The arm position starts over at 0 here, which the online
+ *           identification is told with identRestart().
+ *  @param   s Shared state to reset
+ *  @param   id Law to start with
+ *  @param   capture Arm input capture count (htim3 CCR2)
+ *  @param   pend Pendulum angle, 0 hanging down
+ */
+void ctrlInit(ctrlState_t * s, ctrlId_t id, uint16_t capture, uint16_t pend) {
+   s->arm = 0;
+   s->armVel = 0;
+   s->armAcc = 0;
+   s->armRate = 0;
+   s->pend = pend;
+   s->pendRate = 0;
+   s->armRef = 0;
+   s->armRefVel = 0;
+   s->armRefAcc = 0;
+   s->lastOut = 0;
+   s->tick = 0;
+   s->lastCapture = capture;
+   s->lastPend = pend;
+   identRestart();
+
+   trajInit(&armTraj, 0, CTRL_ARM_VMAX, CTRL_ARM_AMAX, CTRL_ARM_JMAX);
+   armTarget = ctrlParams.armSetpoint;
+   trajSetTarget(&armTraj, armTarget);
+
+   active = id < CTRL_COUNT ? id : CTRL_OFF;
+   seenSeq = requestSeq;
+   blendLeft = 0;
+   ctrlTable[active]->start(s);
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Update the shared state from this tick's measurements
+ *  @param   s Shared state
+ *  @param   capture Arm input capture count (htim3 CCR2)
+ *  @param   pend Pendulum angle, 0 hanging down
+ */
+void ctrlSense(ctrlState_t * s, uint16_t capture, uint16_t pend) {
+   /* positive torque drives the capture count down */
+   int32_t vel = (int16_t)(s->lastCapture - capture);
+   int32_t pvel = (int16_t)(pend - s->lastPend);
+
+   s->lastCapture = capture;
+   s->lastPend = pend;
+   s->arm += vel;
+   s->armAcc = vel - s->armVel;
+   s->armVel = vel;
+   s->armRate += (vel * CTRL_HZ - s->armRate) >> CTRL_RATE_SHIFT;
+   s->pend = pend;
+   s->pendRate += (pvel * CTRL_HZ - s->pendRate) >> CTRL_RATE_SHIFT;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Ask for another law, it takes over at the next ctrlStep()
+ *  @details Lock free: the id is written before the sequence number, so
+ *           ctrlStep() never sees a new sequence with an old id. If several
+ *           requests come in within one tick the last one wins. Meant for
+ *           the command handler; the only other caller is a law handing
+ *           over by itself (swing-up to catch), and a command racing that
+ *           handover may be dropped, never half applied.
+ *  @param   id Law to switch to
+ *  @return  1 if accepted, 0 if there is no such law
+ */
+uint8_t ctrlRequest(ctrlId_t id) {
+   if(id >= CTRL_COUNT) {
+      return 0;
+   }
+   requestId = id;
+   requestSeq = requestSeq + 1;
+   return 1;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Law that is currently running
+ *  @return  Id of the active law
+ */
+ctrlId_t ctrlActive(void) {
+   return active;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Advance the arm reference by one tick
+ *  @details A new ctrlParams.armSetpoint is not stepped to: it becomes the
+ *           target of the jerk limited reference, which the position laws
+ *           follow with feedforward of its velocity and acceleration and
+ *           the balancing laws balance around.
+ *  @param   s Shared state, armRef and its derivatives are updated
+ */
+static void ctrlReference(ctrlState_t * s) {
+   int32_t target = ctrlParams.armSetpoint;
+
+   if(target != armTarget) {
+      armTarget = target;
+      trajSetTarget(&armTraj, target);
+   }
+   trajStep(&armTraj);
+   s->armRef = trajPos(&armTraj);
+   s->armRefVel = armTraj.vel;
+   s->armRefAcc = armTraj.acc;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Run one control period
+ *  @details The arm reference moves first, see ctrlReference(). Then a
+ *           pending switch is applied: the new law is started
+ *           from the current state and stepped, and the difference between
+ *           the last applied torque and its output is added on top and
+ *           faded out linearly over CTRL_BLEND_TICKS, so the torque has no
+ *           step at the switch. Laws that can absorb the difference
+ *           themselves (the PID integrator) do so in start() and leave
+ *           nothing to fade. A switch to CTRL_OFF is not blended, and
+ *           ends a fade still running: off means no torque from that
+ *           period on. The switch happens inside this one call, so
+ *           no control period is skipped. The torque that goes out also
+ *           updates the friction model (frictionUpdate()), whichever law
+ *           produced it.
+ *  @param   s Shared state, updated by ctrlSense() this tick
+ *  @return  Torque for setMotorTorque()
+ */
+int16_t ctrlStep(ctrlState_t * s) {
+   uint8_t seq = requestSeq;
+   uint8_t switched = 0;
+   int32_t out;
+
+   ctrlReference(s);
+   if(seq != seenSeq) {
+      ctrlId_t id = requestId;
+      seenSeq = seq;
+      if(id != active) {
+         active = id;
+         ctrlTable[active]->start(s);
+         switched = 1;
+      }
+   }
+
+   out = ctrlTable[active]->step(s);
+   if(active == CTRL_OFF) {
+      blendLeft = 0;
+   } else if(switched) {
+      blendOffset = s->lastOut - out;
+      blendLeft = CTRL_BLEND_TICKS;
+   }
+
+   if(blendLeft) {
+      out += blendOffset * blendLeft / CTRL_BLEND_TICKS;
+      blendLeft--;
+   }
+
+   if(out > CTRL_TORQUE_MAX) {
+      out = CTRL_TORQUE_MAX;
+   }
+   if(out < -CTRL_TORQUE_MAX) {
+      out = -CTRL_TORQUE_MAX;
+   }
+   s->lastOut = out;
+   s->tick++;
+   frictionUpdate(out, s->armVel, s->armAcc);
+   return out;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Make this tick's state available to ctrlLatest()
+ *  @details Called by the control loop once per tick after ctrlStep(). It
+ *           runs in the control interrupt, so tasks reading the state may
+ *           be interrupted but never the other way round.
+ *  @param   s State to publish
+ */
+void ctrlPublish(const ctrlState_t * s) {
+   seqWriteBegin(&publishedSeq);
+   published = *s;
+   seqWriteEnd(&publishedSeq);
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Consistent copy of the last published state, for tasks
+ *  @details Lock free, see seqlock.h: the copy is retried if the control
+ *           interrupt published in the middle of it.
+ *  @param   out Filled with the state
+ */
+void ctrlLatest(ctrlState_t * out) {
+   uint32_t seq;
+
+   do {
+      seq = seqReadBegin(&publishedSeq);
+      *out = published;
+   } while(seqReadRetry(&publishedSeq, seq));
+}
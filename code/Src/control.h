@@ -0,0 +1,116 @@
+#ifndef CONTROL_H
+#define CONTROL_H
+#include <stdint.h>
+#include "ilc.h"
+
+/** @brief Ticks over which the output offset at a switch is faded out **/
+#define CTRL_BLEND_TICKS 200
+/** @brief Control ticks per second, rates in ctrlState_t are per second **/
+#define CTRL_HZ 1000
+/** @brief Rate filter, new = old + (raw - old) >> CTRL_RATE_SHIFT **/
+#define CTRL_RATE_SHIFT 2
+/** @brief Largest torque any law may command **/
+#define CTRL_TORQUE_MAX 1000
+/** @brief Arm reference limits, Q16 counts/tick, counts/tick^2 and counts/tick^3 **/
+#define CTRL_ARM_VMAX (50L << 16)
+#define CTRL_ARM_AMAX 3277
+#define CTRL_ARM_JMAX 33
+/** @brief Arm inertia feedforward of the position laws, torque per count/tick^2 **/
+#define CTRL_ARM_KA 360
+/** @brief Disturbance observer of the position laws: Q-filter bandwidth in Hz
+    and the largest disturbance it cancels. The balancing laws run without
+    it: the pendulum's reaction on the arm is part of their model, and the
+    observer would take it for a disturbance and cancel it **/
+#define CTRL_DOB_HZ 20
+#define CTRL_DOB_LIMIT 400
+/** @brief Swing-up learning: pendulum rate (counts/s) and angle counted as
+    hanging still, and the longest wait for that between trials in ticks **/
+#define CTRL_REST_RATE 200
+#define CTRL_REST_ANGLE 364
+#define CTRL_SETTLE_TICKS 20000
+
+/** @brief Plant state shared by all control laws, filled by ctrlSense()
+ *
+ *  Positions are 65536 counts per rev. Arm values are in torque direction
+ *  (positive torque increases them), the pendulum is 0 hanging down.
+ */
+typedef struct {
+   int32_t arm;        /**< unwrapped arm position */
+   int32_t armVel;     /**< arm velocity, counts/tick, unfiltered */
+   int32_t armAcc;     /**< arm acceleration, counts/tick^2, unfiltered */
+   int32_t armRate;    /**< arm velocity, counts/s, filtered */
+   uint16_t pend;      /**< pendulum angle */
+   int32_t pendRate;   /**< pendulum velocity, counts/s, filtered */
+   int32_t armRef;     /**< arm reference, on its way to ctrlParams.armSetpoint */
+   int32_t armRefVel;  /**< reference velocity, Q16 counts/tick */
+   int32_t armRefAcc;  /**< reference acceleration, Q16 counts/tick^2 */
+   int16_t lastOut;    /**< torque applied over the last tick */
+   uint32_t tick;      /**< ticks since ctrlInit() */
+   uint32_t time;      /**< clockUs() at the start of the tick, set by the caller */
+   uint16_t lastCapture;
+   uint16_t lastPend;
+} ctrlState_t;
+
+/** @brief Control interrupt timing over CTRL_HZ ticks, in core cycles **/
+typedef struct {
+   uint32_t latencyMax;   /**< longest delay from the timer update to the handler */
+   uint32_t latencySum;
+   uint32_t busyMax;      /**< longest control period */
+   uint32_t busySum;
+} ctrlTiming_t;
+
+/** @brief Control laws in the registry **/
+typedef enum {
+   CTRL_OFF = 0,
+   CTRL_OPEN_LOOP,
+   CTRL_P,
+   CTRL_PID,
+   CTRL_LQR,
+   CTRL_EMPC,
+   CTRL_SWINGUP,
+   CTRL_FRICTION,
+   CTRL_LEARN,
+   CTRL_COUNT
+} ctrlId_t;
+
+/** @brief Common interface of a control law
+ *
+ *  start() is called once in the tick the law becomes active, before its
+ *  first step(), and should set up internal state (integrators, trial
+ *  counters) from the current state so the output continues where the
+ *  previous law left off. Both run in the control loop and must finish
+ *  well within one tick.
+ */
+typedef struct {
+   const char * name;
+   void (*start)(const ctrlState_t * s);
+   int16_t (*step)(const ctrlState_t * s);
+} controller_t;
+
+/** @brief Tunables of the laws, may be changed while running **/
+typedef struct {
+   int16_t openLoop;       /**< CTRL_OPEN_LOOP torque */
+   int32_t armSetpoint;    /**< arm target, counts from where ctrlInit() started */
+   int32_t kp;             /**< P and PID, Q8 torque per count */
+   int32_t ki;             /**< PID, Q16 torque per count tick */
+   int32_t kd;             /**< PID, torque per count/tick */
+   int32_t lqr[4];         /**< LQR, Q16 torque per count, see empc.h */
+   int32_t w0sq;           /**< swing-up w0^2, Q8 rad^2/s^2, 0 for default; kept
+                                up to date by the identification once valid */
+   ilc_t * ilc;            /**< swing-up feedforward profile */
+   uint8_t catchWith;      /**< law to hand over to once swung up */
+} ctrlParams_t;
+
+extern ctrlParams_t ctrlParams;
+extern const controller_t * const ctrlTable[CTRL_COUNT];
+
+void ctrlInit(ctrlState_t * s, ctrlId_t id, uint16_t capture, uint16_t pend);
+void ctrlSense(ctrlState_t * s, uint16_t capture, uint16_t pend);
+uint8_t ctrlRequest(ctrlId_t id);
+ctrlId_t ctrlActive(void);
+int16_t ctrlStep(ctrlState_t * s);
+void ctrlPublish(const ctrlState_t * s);
+void ctrlLatest(ctrlState_t * out);
+uint16_t ctrlLearnedTrials(void);
+
+#endif
@@ -0,0 +1,369 @@
+#include "control.h"
+#include "empc.h"
+#include "swingup.h"
+#include "friction.h"
+#include "trajectory.h"
+#include "dob.h"
+
+/** @brief Tunables of all laws, defaults for the nominal rig **/
+ctrlParams_t ctrlParams = {
+   .openLoop = 0,
+   .armSetpoint = 0,
+   .kp = 16,
+   .ki = 64,
+   .kd = 8,
+   /* discrete LQR of the tools/empc_gen.c model, -K in empc.h units */
+   .lqr = { -3010, 33201, -1486, 2526 },
+   .w0sq = 0,
+   .ilc = 0,
+   .catchWith = CTRL_LQR
+};
+
+/* law state */
+static int64_t pidInteg;
+static swingup_t swing;
+static int32_t swingArm0;
+static uint8_t learnTrial;
+static uint16_t learnStill;
+static uint16_t learnWait;
+static uint16_t learnLeft;
+static volatile uint16_t learnedTrials;
+static dob_t armDob;
+static int32_t lastFriction;
+
+
+//-------------------------------------------------------------------------------------
+/** @brief   Balance state in empc.h units, arm relative to armRef
+ *  @param   s Shared state
+ *  @param   x Filled with arm, pendulum from upright, arm rate, pendulum rate
+ */
+static void balanceState(const ctrlState_t * s, int32_t x[EMPC_NX]) {
+   x[0] = s->arm - s->armRef;
+   x[1] = (int16_t)(s->pend - 32768);
+   x[2] = s->armRate;
+   x[3] = s->pendRate;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Start hook for laws without internal state
+ *  @param   s Not used
+ */
+static void noStart(const ctrlState_t * s) {
+   (void)s;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Motor off
+ *  @param   s Not used
+ *  @return  0
+ */
+static int16_t offStep(const ctrlState_t * s) {
+   (void)s;
+   return 0;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Constant test torque, ctrlParams.openLoop
+ *  @param   s Not used
+ *  @return  The open loop torque
+ */
+static int16_t openLoopStep(const ctrlState_t * s) {
+   (void)s;
+   return ctrlParams.openLoop;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Feedforward of the position laws from the arm reference
+ *  @details The inertia times the reference acceleration, and the
+ *           identified friction at the reference velocity, so the
+ *           feedback only has to correct model errors. The friction part
+ *           is kept for posDisturbance() in the next tick.
+ *  @param   s Shared state
+ *  @param   fb Feedback torque, the direction to break away in at standstill
+ *  @return  Torque to add to the feedback
+ */
+static int32_t posFeedforward(const ctrlState_t * s, int32_t fb) {
+   int32_t ff = (int32_t)(((int64_t)s->armRefAcc * CTRL_ARM_KA) >> TRAJ_Q);
+
+   lastFriction = frictionCompensate(s->armRefVel >> TRAJ_Q, fb);
+   return ff + lastFriction;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Disturbance on the arm seen over the last tick, see dob.h
+ *  @details The observer gets the applied torque less its friction
+ *           feedforward, so it estimates only what the friction model
+ *           misses and the friction is not cancelled twice. Call once
+ *           per tick, before posFeedforward().
+ *  @param   s Shared state
+ *  @return  Torque to subtract from the output
+ */
+static int32_t posDisturbance(const ctrlState_t * s) {
+   return dobUpdate(&armDob, s->armVel, s->lastOut - lastFriction);
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Start hook of the position laws: observer from scratch
+ *  @param   s Shared state
+ */
+static void posStart(const ctrlState_t * s) {
+   dobInit(&armDob, CTRL_ARM_KA, 0, CTRL_DOB_LIMIT);
+   dobSetBandwidth(&armDob, CTRL_DOB_HZ, CTRL_HZ);
+   dobReset(&armDob, s->armVel);
+   lastFriction = 0;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Proportional arm position control along the jerk limited reference
+ *  @param   s Shared state
+ *  @return  kp (armRef - arm) plus the feedforward, less the disturbance
+ */
+static int16_t pStep(const ctrlState_t * s) {
+   int32_t out = ((s->armRef - s->arm) * ctrlParams.kp) / 256;
+   int32_t d = posDisturbance(s);
+
+   out += posFeedforward(s, out) - d;
+   return out > CTRL_TORQUE_MAX ? CTRL_TORQUE_MAX : (out < -CTRL_TORQUE_MAX ? -CTRL_TORQUE_MAX : out);
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   PID start: preload the integrator with whatever the previous
+ *           law applied beyond P, D and the feedforward, so the first
+ *           output equals it
+ *  @param   s Shared state
+ */
+static void pidStart(const ctrlState_t * s) {
+   int32_t pd;
+
+   posStart(s);
+   pd = ((s->armRef - s->arm) * ctrlParams.kp) / 256
+        - ctrlParams.kd * (s->armVel - (s->armRefVel >> TRAJ_Q));
+   pidInteg = (int64_t)(s->lastOut - pd - posFeedforward(s, pd)) << 16;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   PID on arm position, integrator clamped to the torque range
+ *  @details D acts on the velocity error to the reference.
+ *  @param   s Shared state
+ *  @return  Torque, with the feedforward, less the disturbance
+ */
+static int16_t pidStep(const ctrlState_t * s) {
+   const int64_t lim = (int64_t)CTRL_TORQUE_MAX << 16;
+   int32_t e = s->armRef - s->arm;
+   int32_t d = posDisturbance(s);
+   int32_t out;
+
+   pidInteg += (int64_t)e * ctrlParams.ki;
+   if(pidInteg > lim) {
+      pidInteg = lim;
+   }
+   if(pidInteg < -lim) {
+      pidInteg = -lim;
+   }
+   out = (e * ctrlParams.kp) / 256 - ctrlParams.kd * (s->armVel - (s->armRefVel >> TRAJ_Q))
+         + (int32_t)(pidInteg >> 16);
+   out += posFeedforward(s, out) - d;
+   return out > CTRL_TORQUE_MAX ? CTRL_TORQUE_MAX : (out < -CTRL_TORQUE_MAX ? -CTRL_TORQUE_MAX : out);
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Friction compensation of the balancing laws, clamped
+ *  @details The laws are designed for the frictionless model, so the
+ *           identified friction at the measured arm velocity is added
+ *           back; at standstill it breaks away in the direction the law
+ *           asks for. Without it the arm sticks until the pendulum has
+ *           tipped far enough to overcome stiction, a limit cycle. Unlike
+ *           the position laws they get no disturbance observer, see
+ *           CTRL_DOB_HZ.
+ *  @param   s Shared state
+ *  @param   out Torque of the law
+ *  @return  Torque with the compensation
+ */
+static int16_t balanceFriction(const ctrlState_t * s, int32_t out) {
+   out += frictionCompensate(s->armVel, out);
+   return out > CTRL_TORQUE_MAX ? CTRL_TORQUE_MAX : (out < -CTRL_TORQUE_MAX ? -CTRL_TORQUE_MAX : out);
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Linear state feedback balancing around upright
+ *  @param   s Shared state
+ *  @return  -K x, with friction compensation
+ */
+static int16_t lqrStep(const ctrlState_t * s) {
+   int32_t x[EMPC_NX];
+   int64_t acc = 0;
+   int32_t out;
+   uint8_t i;
+
+   balanceState(s, x);
+   for(i = 0; i < EMPC_NX; i++) {
+      acc += (int64_t)ctrlParams.lqr[i] * x[i];
+   }
+   out = -(int32_t)(acc >> 16);
+   return balanceFriction(s, out);
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Explicit MPC balancing, see empc.h
+ *  @param   s Shared state
+ *  @return  Torque from the region table, with friction compensation
+ */
+static int16_t empcStep(const ctrlState_t * s) {
+   int32_t x[EMPC_NX];
+
+   balanceState(s, x);
+   return balanceFriction(s, empcControl(x));
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Swing-up start: play the ctrlParams.ilc profile from here
+ *  @param   s Shared state
+ */
+static void swingStart(const ctrlState_t * s) {
+   swingArm0 = s->arm;
+   if(ctrlParams.ilc) {
+      swingupStart(&swing, ctrlParams.ilc, ctrlParams.w0sq, s->pend);
+   } else {
+      swing.status = SWING_TIMEOUT;
+   }
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Energy swing-up, hands over to ctrlParams.catchWith near upright
+ *  @param   s Shared state
+ *  @return  Torque, 0 once the swing-up is over
+ */
+static int16_t swingStep(const ctrlState_t * s) {
+   int16_t out;
+
+   if(swing.status != SWING_RUNNING) {
+      return 0;
+   }
+   out = swingupStep(&swing, s->arm - swingArm0, s->armVel, s->pend);
+   if(swing.status == SWING_UP) {
+      ctrlRequest(ctrlParams.catchWith);
+   }
+   return out;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Friction identification start: excite from standstill
+ *  @param   s Not used
+ */
+static void frictionStart(const ctrlState_t * s) {
+   (void)s;
+   frictionIdentStart();
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Friction identification, see frictionIdentStep()
+ *  @details The arm must be free to turn. Hands over to CTRL_OFF once the
+ *           model is identified or the routine gave up, which leaves the
+ *           previous model; switching away earlier leaves it as well, but
+ *           with frictionUpdate() off until an identification finishes.
+ *  @param   s Shared state
+ *  @return  Excitation torque
+ */
+static int16_t frictionStep(const ctrlState_t * s) {
+   int16_t out = 0;
+
+   if(frictionIdentStep(s->armVel, &out) != FRIC_IDENT_RUNNING) {
+      ctrlRequest(CTRL_OFF);
+   }
+   return out;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Learning start: wait for the pendulum to hang still
+ *  @param   s Not used
+ */
+static void learnStart(const ctrlState_t * s) {
+   (void)s;
+   learnTrial = 0;
+   learnStill = 0;
+   learnWait = 0;
+   learnLeft = ILC_MAX_TRIALS;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Learn the ctrlParams.ilc swing-up feedforward over repeated trials
+ *  @details Each trial starts once the pendulum has hung still for a
+ *           second and runs the swing-up from there. When it ends the
+ *           motor is released and the ILC updates the profile from the
+ *           recorded energy error, in this one tick. Hands over to
+ *           CTRL_OFF once a trial converged, after ILC_MAX_TRIALS or if
+ *           the pendulum does not settle within CTRL_SETTLE_TICKS. Storing
+ *           the profile is left to a task, see ctrlLearnedTrials().
+ *  @param   s Shared state
+ *  @return  Swing-up torque during a trial, 0 between trials
+ */
+static int16_t learnStep(const ctrlState_t * s) {
+   int16_t out;
+
+   if(!ctrlParams.ilc) {
+      ctrlRequest(CTRL_OFF);
+      return 0;
+   }
+   if(!learnTrial) {
+      if(s->pendRate > CTRL_REST_RATE || s->pendRate < -CTRL_REST_RATE
+         || (int16_t)s->pend > CTRL_REST_ANGLE || (int16_t)s->pend < -CTRL_REST_ANGLE) {
+         learnStill = 0;
+      } else if(++learnStill >= CTRL_HZ) {
+         learnTrial = 1;
+         swingArm0 = s->arm;
+         swingupStart(&swing, ctrlParams.ilc, ctrlParams.w0sq, s->pend);
+         return 0;
+      }
+      if(++learnWait > CTRL_SETTLE_TICKS) {
+         ctrlRequest(CTRL_OFF);
+      }
+      return 0;
+   }
+   out = swingupStep(&swing, s->arm - swingArm0, s->armVel, s->pend);
+   if(swing.status != SWING_RUNNING) {
+      ilcTrialEnd(ctrlParams.ilc);
+      learnedTrials++;
+      learnTrial = 0;
+      learnStill = 0;
+      learnWait = 0;
+      if(ctrlParams.ilc->converged || !--learnLeft) {
+         ctrlRequest(CTRL_OFF);
+      }
+      return 0;
+   }
+   return out;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Trials the learning law finished since boot
+ *  @details The learned profile is in RAM only. Store it with ilcSave()
+ *           when this changed and the active law is CTRL_OFF: erasing
+ *           flash stalls the CPU, the control interrupt included.
+ *  @return  Trial count
+ */
+uint16_t ctrlLearnedTrials(void) {
+   return learnedTrials;
+}
+
+static const controller_t ctrlOff = { "off", noStart, offStep };
+static const controller_t ctrlOpenLoop = { "open loop", noStart, openLoopStep };
+static const controller_t ctrlP = { "P", posStart, pStep };
+static const controller_t ctrlPid = { "PID", pidStart, pidStep };
+static const controller_t ctrlLqr = { "LQR", noStart, lqrStep };
+static const controller_t ctrlEmpc = { "EMPC", noStart, empcStep };
+static const controller_t ctrlSwing = { "swing-up", swingStart, swingStep };
+static const controller_t ctrlFriction = { "friction id", frictionStart, frictionStep };
+static const controller_t ctrlLearn = { "swing-up learning", learnStart, learnStep };
+
+/** @brief The registry, indexed by ctrlId_t **/
+const controller_t * const ctrlTable[CTRL_COUNT] = {
+   [CTRL_OFF] = &ctrlOff,
+   [CTRL_OPEN_LOOP] = &ctrlOpenLoop,
+   [CTRL_P] = &ctrlP,
+   [CTRL_PID] = &ctrlPid,
+   [CTRL_LQR] = &ctrlLqr,
+   [CTRL_EMPC] = &ctrlEmpc,
+   [CTRL_SWINGUP] = &ctrlSwing,
+   [CTRL_FRICTION] = &ctrlFriction,
+   [CTRL_LEARN] = &ctrlLearn
+};
@@ -0,0 +1,78 @@
+#include "dob.h"
+
+/** @brief 2 * pi in Q15 **/
+#define TWO_PI_Q15 205887
+
+
+//-------------------------------------------------------------------------------------
+/** @brief   Set up an observer with the nominal arm model
+ *  @param   d Observer to initialize
+ *  @param   ka Arm inertia, torque per count/tick^2
+ *  @param   kv Arm damping, Q16 torque per count/tick
+ *  @param   limit Largest estimate that is passed on for cancellation
+ */
+void dobInit(dob_t * d, int32_t ka, int32_t kv, int16_t limit) {
+   d->ka = ka;
+   d->kv = kv;
+   d->limit = limit;
+   d->alpha = 0;
+   dobReset(d, 0);
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Set the Q-filter bandwidth
+ *  @details Higher bandwidth rejects faster disturbances but passes more
+ *           velocity quantization noise into the torque. Uses the small
+ *           angle form alpha = 2 pi f / fs, capped at 1.
+ *  @param   d Observer to update
+ *  @param   hz Q-filter cutoff in Hz
+ *  @param   loopHz Rate dobUpdate() is called at
+ */
+void dobSetBandwidth(dob_t * d, uint16_t hz, uint16_t loopHz) {
+   int32_t alpha = (int32_t)((int64_t)TWO_PI_Q15 * hz / loopHz);
+   d->alpha = alpha > (1 << 15) ? (1 << 15) : alpha;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Clear the estimate, e.g. after the loop was open for a while
+ *  @param   d Observer to reset
+ *  @param   vel Current arm velocity in counts/tick
+ */
+void dobReset(dob_t * d, int32_t vel) {
+   d->velFilt = vel * (1 << DOB_Q);
+   d->rest = 0;
+   d->estimate = 0;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Update the disturbance estimate for this tick
+ *  @details With a first order Q-filter Q the estimate is
+ *           d = Q(ka acc + kv vel - u). The acceleration is never formed
+ *           directly: Q(ka (1 - z^-1) vel) = ka (1 - z^-1) Q(vel), so only
+ *           the filtered velocity is differenced, which keeps the integer
+ *           velocity steps from showing up in the torque.
+ *  @param   d Observer to update
+ *  @param   vel Arm velocity this tick in counts/tick (torque direction)
+ *  @param   torque Torque that was applied over the last tick
+ *  @return  Disturbance estimate; subtract it from the next command
+ */
+int16_t dobUpdate(dob_t * d, int32_t vel, int16_t torque) {
+   int32_t prev = d->velFilt;
+   int32_t x;
+   int64_t est;
+
+   d->velFilt += (int32_t)(((int64_t)d->alpha * (vel * (1 << DOB_Q) - d->velFilt)) >> 15);
+
+   x = d->kv * vel - torque * (1 << DOB_Q);
+   d->rest += (int32_t)(((int64_t)d->alpha * (x - d->rest)) >> 15);
+
+   est = ((int64_t)d->ka * (d->velFilt - prev) + d->rest) >> DOB_Q;
+   if(est > d->limit) {
+      est = d->limit;
+   }
+   if(est < -d->limit) {
+      est = -d->limit;
+   }
+   d->estimate = est;
+   return d->estimate;
+}
@@ -0,0 +1,29 @@
+#ifndef DOB_H
+#define DOB_H
+#include <stdint.h>
+
+/** @brief Fractional bits of the observer state **/
+#define DOB_Q 16
+
+/** @brief Disturbance observer around the nominal arm model
+ *
+ *  Nominal plant, all in torque direction: ka * acc + kv * vel = u + d,
+ *  with vel in counts/tick and acc in counts/tick^2. d lumps everything
+ *  the model does not explain: cogging, friction error, cable drag, bumps.
+ */
+typedef struct {
+   int32_t ka;        /**< inertia, torque per count/tick^2 */
+   int32_t kv;        /**< damping, Q16 torque per count/tick */
+   int32_t alpha;     /**< Q-filter coefficient, Q15 */
+   int16_t limit;     /**< largest disturbance that will be cancelled */
+   int16_t estimate;  /**< last disturbance estimate */
+   int32_t velFilt;   /**< Q-filtered velocity, Q16 */
+   int32_t rest;      /**< Q-filtered kv * vel - u, Q16 */
+} dob_t;
+
+void dobInit(dob_t * d, int32_t ka, int32_t kv, int16_t limit);
+void dobSetBandwidth(dob_t * d, uint16_t hz, uint16_t loopHz);
+void dobReset(dob_t * d, int32_t vel);
+int16_t dobUpdate(dob_t * d, int32_t vel, int16_t torque);
+
+#endif
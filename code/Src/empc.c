@@ -0,0 +1,71 @@
+#include "empc.h"
+
+
+//-------------------------------------------------------------------------------------
+/** @brief   Check if a state lies inside the region the table was built for
+ *  @param   x State vector (see empc.h for units)
+ *  @return  1 if every state is inside the table domain, 0 otherwise
+ */
+uint8_t empcInDomain(const int32_t x[EMPC_NX]) {
+   uint8_t i;
+   for(i = 0; i < EMPC_NX; i++) {
+      if(x[i] < empcLower[i] || x[i] > empcUpper[i]) {
+         return 0;
+      }
+   }
+   return 1;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Evaluate the explicit MPC law for the given state
+ *  @details The state is clamped to the table domain so the affine law is
+ *           never extrapolated, then the region tree is walked down to a
+ *           leaf. The walk takes one compare per level of the leaf it ends
+ *           in, at worst EMPC_MAX_DEPTH, followed by EMPC_NX
+ *           multiply-accumulates, which bounds the worst case time. The
+ *           torque limit is enforced by the final saturation; the
+ *           arm angle limit is part of the problem the table was solved for.
+ *  @param   x State vector (see empc.h for units)
+ *  @return  Torque to apply from -1000 to 1000
+ */
+int16_t empcControl(const int32_t x[EMPC_NX]) {
+   int32_t xc[EMPC_NX];
+   const empcLeaf_t * leaf;
+   uint16_t idx = empcRoot;
+   uint8_t i;
+   int64_t acc;
+   int32_t out;
+
+   for(i = 0; i < EMPC_NX; i++) {
+      xc[i] = x[i];
+      if(xc[i] < empcLower[i]) {
+         xc[i] = empcLower[i];
+      }
+      if(xc[i] > empcUpper[i]) {
+         xc[i] = empcUpper[i];
+      }
+   }
+
+   for(i = 0; i < EMPC_MAX_DEPTH && !(idx & EMPC_LEAF); i++) {
+      const empcNode_t * n = &empcNodes[idx];
+      idx = (xc[n->dim] < n->split) ? n->left : n->right;
+   }
+   if(!(idx & EMPC_LEAF)) {
+      return 0;           /* corrupt table, fail safe */
+   }
+
+   leaf = &empcLeaves[idx & ~EMPC_LEAF];
+   acc = 0;
+   for(i = 0; i < EMPC_NX; i++) {
+      acc += (int64_t)leaf->gain[i] * xc[i];
+   }
+   out = (int32_t)(acc >> empcGainShift) + leaf->offset;
+
+   if(out > 1000) {
+      out = 1000;
+   }
+   if(out < -1000) {
+      out = -1000;
+   }
+   return out;
+}
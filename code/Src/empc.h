@@ -0,0 +1,55 @@
+#ifndef EMPC_H
+#define EMPC_H
+#include <stdint.h>
+
+/*
+ * Explicit MPC for balancing the pendulum. The table in empc_table.c is
+ * generated on the host by tools/empc_gen.c ("make empc"); do not edit it.
+ *
+ * The table approximates the MPC law to within 88.2 of 1000 torque units
+ * in its worst region, not the 5% the generator aims for: the regions
+ * that miss it hit EMPC_MAX_DEPTH, and a deeper, larger table (512
+ * regions at depth 20) still leaves 55.4 for twice the flash. The figure
+ * is after the final saturation, so it is torque the motor really sees.
+ *
+ * State vector units (all int32):
+ *   x[0] arm angle from center, 65536 counts/rev
+ *   x[1] pendulum angle from upright, 65536 counts/rev
+ *   x[2] arm rate, counts/s
+ *   x[3] pendulum rate, counts/s
+ */
+
+/** @brief Number of states in the model **/
+#define EMPC_NX 4
+
+/** @brief Hard bound on tree depth, gives the worst case lookup time **/
+#define EMPC_MAX_DEPTH 16
+
+/** @brief Child index flag marking a leaf rather than a node **/
+#define EMPC_LEAF 0x8000
+
+/** @brief Interior node of the region tree: go left if x[dim] < split **/
+typedef struct {
+   int32_t split;
+   uint16_t left;
+   uint16_t right;
+   uint8_t dim;
+} empcNode_t;
+
+/** @brief Affine control law of one region: u = (F x >> shift) + g **/
+typedef struct {
+   int32_t gain[EMPC_NX];
+   int16_t offset;
+} empcLeaf_t;
+
+extern const empcNode_t empcNodes[];
+extern const empcLeaf_t empcLeaves[];
+extern const uint16_t empcRoot;
+extern const uint8_t empcGainShift;
+extern const int32_t empcLower[EMPC_NX];
+extern const int32_t empcUpper[EMPC_NX];
+
+int16_t empcControl(const int32_t x[EMPC_NX]);
+uint8_t empcInDomain(const int32_t x[EMPC_NX]);
+
+#endif
@@ -0,0 +1,528 @@
+/* Generated by tools/empc_gen.c, do not edit.
+ * horizon 10 x 0.01 s, |u| <= 0.06 Nm, |arm| <= 1.5 rad
+ * 256 regions, depth 16, worst fit error 88.2 of 1000 */
+#include "empc.h"
+
+const uint8_t empcGainShift = 16;
+
+const int32_t empcLower[EMPC_NX] = { -14081, -1565, -20861, -20861 };
+const int32_t empcUpper[EMPC_NX] = { 14081, 1565, 20861, 20861 };
+
+const uint16_t empcRoot = 0x0000;
+
+const empcNode_t empcNodes[] = {
+   { 0, 0x0001, 0x0002, 0 },
+   { 0, 0x0003, 0x8000, 1 },
+   { 0, 0x8001, 0x0004, 1 },
+   { 0, 0x0005, 0x8002, 2 },
+   { 0, 0x8003, 0x0006, 2 },
+   { 0, 0x8004, 0x0007, 3 },
+   { 0, 0x0008, 0x8005, 3 },
+   { -7041, 0x0009, 0x8006, 0 },
+   { 7041, 0x8007, 0x000c, 0 },
+   { -782, 0x000a, 0x000b, 1 },
+   { -10430, 0x000f, 0x8008, 2 },
+   { -10430, 0x80fe, 0x80ff, 2 },
+   { 782, 0x000d, 0x000e, 1 },
+   { 10430, 0x8075, 0x008a, 2 },
+   { 10430, 0x8009, 0x0010, 2 },
+   { 10430, 0x0011, 0x0012, 3 },
+   { -10430, 0x002a, 0x002b, 3 },
+   { -10561, 0x00c9, 0x80c0, 0 },
+   { -10561, 0x0013, 0x800a, 0 },
+   { -1173, 0x0014, 0x0015, 1 },
+   { -15646, 0x002f, 0x0030, 2 },
+   { -15646, 0x0016, 0x800b, 2 },
+   { 15646, 0x0017, 0x0018, 3 },
+   { -18253, 0x0019, 0x001a, 2 },
+   { -18253, 0x0026, 0x0027, 2 },
+   { 13038, 0x001b, 0x001c, 3 },
+   { 13038, 0x0020, 0x0021, 3 },
+   { -978, 0x001e, 0x001f, 1 },
+   { -978, 0x001d, 0x800c, 1 },
+   { -12321, 0x8011, 0x8012, 0 },
+   { -12321, 0x800f, 0x8010, 0 },
+   { -12321, 0x800d, 0x800e, 0 },
+   { -978, 0x0024, 0x0025, 1 },
+   { -978, 0x0022, 0x0023, 1 },
+   { -12321, 0x8013, 0x8014, 0 },
+   { -12321, 0x80bb, 0x80bc, 0 },
+   { -12321, 0x8017, 0x8018, 0 },
+   { -12321, 0x8015, 0x8016, 0 },
+   { 18253, 0x801a, 0x801b, 3 },
+   { 18253, 0x0028, 0x8019, 3 },
+   { -978, 0x0029, 0x801c, 1 },
+   { -12321, 0x801d, 0x801e, 0 },
+   { 10561, 0x801f, 0x002c, 0 },
+   { 10561, 0x80c1, 0x00ca, 0 },
+   { 1173, 0x002d, 0x002e, 1 },
+   { 15646, 0x0073, 0x0074, 2 },
+   { 15646, 0x0034, 0x0035, 2 },
+   { 15646, 0x0054, 0x0055, 3 },
+   { 15646, 0x0031, 0x0032, 3 },
+   { -1369, 0x8020, 0x0033, 1 },
+   { -1369, 0x00b7, 0x00b8, 1 },
+   { -13038, 0x8021, 0x8022, 2 },
+   { -15646, 0x8023, 0x0036, 3 },
+   { -15646, 0x0037, 0x0038, 3 },
+   { 1369, 0x0053, 0x803c, 1 },
+   { 1369, 0x0045, 0x0046, 1 },
+   { 1369, 0x0039, 0x003a, 1 },
+   { 18253, 0x003f, 0x0040, 2 },
+   { 18253, 0x003b, 0x003c, 2 },
+   { -13038, 0x803d, 0x803e, 3 },
+   { -13038, 0x003d, 0x003e, 3 },
+   { 12321, 0x8024, 0x8025, 0 },
+   { 12321, 0x803a, 0x803b, 0 },
+   { -13038, 0x0041, 0x0042, 3 },
+   { -13038, 0x0043, 0x0044, 3 },
+   { 12321, 0x8026, 0x8027, 0 },
+   { 12321, 0x8073, 0x8074, 0 },
+   { 12321, 0x8028, 0x8029, 0 },
+   { 12321, 0x802a, 0x802b, 0 },
+   { 18253, 0x0047, 0x0048, 2 },
+   { 18253, 0x004b, 0x004c, 2 },
+   { -18253, 0x0049, 0x004a, 3 },
+   { -18253, 0x0051, 0x0052, 3 },
+   { 12321, 0x802c, 0x802d, 0 },
+   { 12321, 0x8036, 0x8037, 0 },
+   { -18253, 0x004f, 0x0050, 3 },
+   { -18253, 0x004d, 0x004e, 3 },
+   { 12321, 0x8030, 0x8031, 0 },
+   { 12321, 0x802e, 0x802f, 0 },
+   { 12321, 0x8032, 0x8033, 0 },
+   { 12321, 0x8038, 0x8039, 0 },
+   { 12321, 0x80ac, 0x80ad, 0 },
+   { 12321, 0x8034, 0x8035, 0 },
+   { 13038, 0x805c, 0x0071, 2 },
+   { -1369, 0x0062, 0x0063, 1 },
+   { -1369, 0x0056, 0x0057, 1 },
+   { -18253, 0x005c, 0x005d, 2 },
+   { -18253, 0x0058, 0x0059, 2 },
+   { 18253, 0x005a, 0x005b, 3 },
+   { 18253, 0x006d, 0x006e, 3 },
+   { -12321, 0x8045, 0x8046, 0 },
+   { -12321, 0x8058, 0x8059, 0 },
+   { 18253, 0x005e, 0x005f, 3 },
+   { 18253, 0x0060, 0x0061, 3 },
+   { -12321, 0x8041, 0x8042, 0 },
+   { -12321, 0x803f, 0x8040, 0 },
+   { -12321, 0x8047, 0x8048, 0 },
+   { -12321, 0x8043, 0x8044, 0 },
+   { -18253, 0x0064, 0x0065, 2 },
+   { -18253, 0x0066, 0x0067, 2 },
+   { 13038, 0x006a, 0x006b, 3 },
+   { 13038, 0x804b, 0x006c, 3 },
+   { 13038, 0x0068, 0x0069, 3 },
+   { 13038, 0x006f, 0x0070, 3 },
+   { -12321, 0x804c, 0x804d, 0 },
+   { -12321, 0x8049, 0x804a, 0 },
+   { -12321, 0x80b9, 0x80ba, 0 },
+   { -12321, 0x8054, 0x8055, 0 },
+   { -12321, 0x8050, 0x8051, 0 },
+   { -12321, 0x804e, 0x804f, 0 },
+   { -12321, 0x8056, 0x8057, 0 },
+   { -12321, 0x805a, 0x805b, 0 },
+   { -12321, 0x8052, 0x8053, 0 },
+   { -13038, 0x0072, 0x805d, 3 },
+   { 12321, 0x809a, 0x809b, 0 },
+   { -15646, 0x806b, 0x0084, 3 },
+   { -15646, 0x0075, 0x0076, 3 },
+   { 18253, 0x00c8, 0x80bd, 2 },
+   { 18253, 0x0077, 0x0078, 2 },
+   { -13038, 0x007f, 0x0080, 3 },
+   { -13038, 0x0079, 0x007a, 3 },
+   { 978, 0x007d, 0x007e, 1 },
+   { 978, 0x007b, 0x007c, 1 },
+   { 12321, 0x805e, 0x805f, 0 },
+   { 12321, 0x8060, 0x8061, 0 },
+   { 12321, 0x8071, 0x8072, 0 },
+   { 12321, 0x8062, 0x8063, 0 },
+   { 978, 0x8064, 0x0081, 1 },
+   { 978, 0x0082, 0x0083, 1 },
+   { 12321, 0x8065, 0x8066, 0 },
+   { 12321, 0x8069, 0x806a, 0 },
+   { 12321, 0x8067, 0x8068, 0 },
+   { 13038, 0x806c, 0x0085, 2 },
+   { -13038, 0x0086, 0x0087, 3 },
+   { 978, 0x0088, 0x0089, 1 },
+   { 978, 0x00c1, 0x00c2, 1 },
+   { 12321, 0x806d, 0x806e, 0 },
+   { 12321, 0x806f, 0x8070, 0 },
+   { -10430, 0x8076, 0x008b, 3 },
+   { 10561, 0x8077, 0x008c, 0 },
+   { 391, 0x008d, 0x008e, 1 },
+   { 15646, 0x008f, 0x8078, 2 },
+   { 15646, 0x0090, 0x0091, 2 },
+   { -5215, 0x0096, 0x0097, 3 },
+   { -5215, 0x00b3, 0x00b4, 3 },
+   { -5215, 0x0092, 0x0093, 3 },
+   { 587, 0x0094, 0x0095, 1 },
+   { 587, 0x009e, 0x009f, 1 },
+   { 18253, 0x0099, 0x009a, 2 },
+   { 18253, 0x00a9, 0x00aa, 2 },
+   { 196, 0x8096, 0x00b1, 1 },
+   { 196, 0x0098, 0x8079, 1 },
+   { 13038, 0x80ae, 0x00c3, 2 },
+   { -7823, 0x807c, 0x009d, 3 },
+   { -7823, 0x009b, 0x009c, 3 },
+   { 12321, 0x807f, 0x8080, 0 },
+   { 12321, 0x807a, 0x807b, 0 },
+   { 12321, 0x807d, 0x807e, 0 },
+   { 18253, 0x00a5, 0x00a6, 2 },
+   { 18253, 0x00a0, 0x00a1, 2 },
+   { -2608, 0x00a4, 0x8083, 3 },
+   { -2608, 0x00a2, 0x00a3, 3 },
+   { 12321, 0x8081, 0x8082, 0 },
+   { 12321, 0x80fc, 0x80fd, 0 },
+   { 12321, 0x8084, 0x8085, 0 },
+   { -2608, 0x00af, 0x00b0, 3 },
+   { -2608, 0x00a7, 0x00a8, 3 },
+   { 12321, 0x8088, 0x8089, 0 },
+   { 12321, 0x8086, 0x8087, 0 },
+   { -7823, 0x00ab, 0x00ac, 3 },
+   { -7823, 0x00ad, 0x00ae, 3 },
+   { 12321, 0x808a, 0x808b, 0 },
+   { 12321, 0x808e, 0x808f, 0 },
+   { 12321, 0x808c, 0x808d, 0 },
+   { 12321, 0x8090, 0x8091, 0 },
+   { 12321, 0x8092, 0x8093, 0 },
+   { 12321, 0x8094, 0x8095, 0 },
+   { 13038, 0x00b2, 0x8097, 2 },
+   { -7823, 0x8098, 0x8099, 3 },
+   { 587, 0x809f, 0x00b6, 1 },
+   { 587, 0x00b5, 0x809c, 1 },
+   { 13038, 0x809d, 0x809e, 2 },
+   { 13038, 0x80f7, 0x00fc, 2 },
+   { -13038, 0x00b9, 0x00ba, 2 },
+   { -13038, 0x00bd, 0x00be, 2 },
+   { 18253, 0x00bb, 0x00bc, 3 },
+   { 18253, 0x80b3, 0x00c6, 3 },
+   { -12321, 0x80a0, 0x80a1, 0 },
+   { -12321, 0x80a2, 0x80a3, 0 },
+   { 18253, 0x00bf, 0x00c0, 3 },
+   { 18253, 0x80b4, 0x00c7, 3 },
+   { -12321, 0x80a6, 0x80a7, 0 },
+   { -12321, 0x80a4, 0x80a5, 0 },
+   { 12321, 0x80a8, 0x80a9, 0 },
+   { 12321, 0x80aa, 0x80ab, 0 },
+   { -2608, 0x00c4, 0x00c5, 3 },
+   { 12321, 0x80af, 0x80b0, 0 },
+   { 12321, 0x80b1, 0x80b2, 0 },
+   { -12321, 0x80b7, 0x80b8, 0 },
+   { -12321, 0x80b5, 0x80b6, 0 },
+   { -18253, 0x80be, 0x80bf, 3 },
+   { -1173, 0x00cb, 0x00cc, 1 },
+   { 1173, 0x00d6, 0x00d7, 1 },
+   { -15646, 0x00cd, 0x80c2, 2 },
+   { -15646, 0x00cf, 0x00d0, 2 },
+   { 5215, 0x80c3, 0x00ce, 3 },
+   { -1369, 0x80c4, 0x00d1, 1 },
+   { 5215, 0x00ed, 0x00ee, 3 },
+   { 5215, 0x80c5, 0x00d2, 3 },
+   { -18253, 0x80c8, 0x80c9, 2 },
+   { -13038, 0x00d3, 0x80c6, 2 },
+   { 7823, 0x80c7, 0x00d4, 3 },
+   { -978, 0x80ca, 0x00d5, 1 },
+   { -12321, 0x80f5, 0x80f6, 0 },
+   { 15646, 0x00dc, 0x00dd, 2 },
+   { 15646, 0x80cb, 0x00d8, 2 },
+   { -5215, 0x00d9, 0x80cc, 3 },
+   { 1369, 0x00da, 0x80cd, 1 },
+   { 18253, 0x80ce, 0x00db, 2 },
+   { -7823, 0x80d0, 0x80d1, 3 },
+   { -5215, 0x00de, 0x80cf, 3 },
+   { -5215, 0x00df, 0x00e0, 3 },
+   { 13038, 0x80e1, 0x00ec, 2 },
+   { 18253, 0x00e2, 0x00e3, 2 },
+   { 18253, 0x80d2, 0x00e1, 2 },
+   { -2608, 0x80d3, 0x80d4, 3 },
+   { -7823, 0x00e4, 0x80d5, 3 },
+   { -7823, 0x00e5, 0x00e6, 3 },
+   { 978, 0x00e9, 0x80d8, 1 },
+   { 978, 0x00e7, 0x00e8, 1 },
+   { 978, 0x00ea, 0x00eb, 1 },
+   { 12321, 0x80d6, 0x80d7, 0 },
+   { 12321, 0x80d9, 0x80da, 0 },
+   { 12321, 0x80db, 0x80dc, 0 },
+   { 12321, 0x80df, 0x80e0, 0 },
+   { 12321, 0x80dd, 0x80de, 0 },
+   { -7823, 0x80e2, 0x80e3, 3 },
+   { -18253, 0x00ef, 0x80e4, 2 },
+   { -18253, 0x00f2, 0x00f3, 2 },
+   { 2608, 0x80e5, 0x00f0, 3 },
+   { -978, 0x80e6, 0x00f1, 1 },
+   { -12321, 0x80ef, 0x80f0, 0 },
+   { 7823, 0x00f6, 0x00f7, 3 },
+   { 7823, 0x80e7, 0x00f4, 3 },
+   { -978, 0x80e8, 0x00f5, 1 },
+   { -12321, 0x80e9, 0x80ea, 0 },
+   { -978, 0x00f8, 0x00f9, 1 },
+   { -978, 0x00fa, 0x00fb, 1 },
+   { -12321, 0x80f3, 0x80f4, 0 },
+   { -12321, 0x80f1, 0x80f2, 0 },
+   { -12321, 0x80ed, 0x80ee, 0 },
+   { -12321, 0x80eb, 0x80ec, 0 },
+   { -7823, 0x00fd, 0x00fe, 3 },
+   { 12321, 0x80fa, 0x80fb, 0 },
+   { 12321, 0x80f8, 0x80f9, 0 },
+};
+
+const empcLeaf_t empcLeaves[] = {
+   { { 2876, -32084, 1442, -2510 }, -15 },
+   { { 2906, -32106, 1442, -2505 }, 14 },
+   { { 3006, -33183, 1483, -2524 }, 0 },
+   { { 3007, -33180, 1484, -2524 }, 0 },
+   { { 2891, -32272, 1425, -2449 }, 5 },
+   { { 2934, -32496, 1431, -2457 }, -7 },
+   { { 3009, -33193, 1485, -2525 }, 0 },
+   { { 3009, -33193, 1485, -2525 }, 0 },
+   { { 2943, -33417, 1462, -2509 }, -18 },
+   { { 2960, -33473, 1451, -2507 }, 17 },
+   { { 3009, -33188, 1485, -2525 }, 0 },
+   { { 1882, -29970, 1245, -2204 }, -259 },
+   { { -105, -24504, 976, -1798 }, -669 },
+   { { -2848, -21769, 900, -1520 }, -1306 },
+   { { 3880, -31807, 1582, -2537 }, 193 },
+   { { -2093, -26685, 803, -1881 }, -1212 },
+   { { 3790, -34107, 1696, -2572 }, 186 },
+   { { -3219, -22065, 761, -1654 }, -1396 },
+   { { 3823, -30729, 1531, -2368 }, 155 },
+   { { -2076, -23400, 375, -1738 }, -1281 },
+   { { 3609, -33620, 1513, -2608 }, 118 },
+   { { -1667, -23097, 486, -1609 }, -1192 },
+   { { 3465, -33107, 1479, -2555 }, 80 },
+   { { -734, -30652, 1045, -1892 }, -925 },
+   { { 3329, -34380, 1572, -2650 }, 78 },
+   { { 224, -4432, 500, -675 }, -685 },
+   { { -116, -18724, 1002, -1745 }, -575 },
+   { { -123, -1661, 222, -209 }, -917 },
+   { { 279, -9648, 501, -688 }, -763 },
+   { { -1757, -20752, 420, -1570 }, -1177 },
+   { { 3559, -32515, 1378, -2418 }, 47 },
+   { { 3010, -33190, 1485, -2525 }, 0 },
+   { { 2643, -30861, 1326, -2383 }, -71 },
+   { { 2263, -30735, 1138, -2295 }, -200 },
+   { { 2582, -30789, 1346, -2383 }, -80 },
+   { { 2006, -30447, 1176, -2250 }, 249 },
+   { { 3421, -35273, 1609, -2717 }, -101 },
+   { { -1119, -35111, 1278, -2129 }, 1009 },
+   { { 3278, -34530, 1543, -2593 }, -49 },
+   { { -444, -30633, 1260, -2306 }, 739 },
+   { { 3814, -34508, 1742, -2539 }, -187 },
+   { { -2774, -26840, 1229, -1843 }, 1236 },
+   { { 3362, -35098, 1624, -2634 }, -83 },
+   { { -788, -29590, 1111, -2231 }, 842 },
+   { { 3434, -32238, 1383, -2408 }, -29 },
+   { { -2155, -22851, 610, -1577 }, 1251 },
+   { { 3897, -34458, 1638, -2691 }, -206 },
+   { { -3020, -26637, 1289, -1915 }, 1258 },
+   { { 3684, -30960, 1560, -2369 }, -138 },
+   { { -3305, -21695, 1112, -1745 }, 1283 },
+   { { 3483, -32892, 1521, -2502 }, -87 },
+   { { -2163, -21010, 1006, -1405 }, 1181 },
+   { { 3811, -30918, 1623, -2365 }, -177 },
+   { { -3661, -21179, 568, -1546 }, 1563 },
+   { { 3561, -32739, 1515, -2499 }, -101 },
+   { { -1663, -19036, 827, -1488 }, 1061 },
+   { { 3281, -34009, 1558, -2616 }, -69 },
+   { { -732, -28386, 1350, -2145 }, 760 },
+   { { 3063, -33824, 1522, -2562 }, -12 },
+   { { 585, -32489, 1352, -2156 }, 571 },
+   { { 2756, -31093, 1399, -2403 }, 39 },
+   { { 1921, -26626, 1135, -2206 }, 198 },
+   { { 2557, -28773, 1181, -2256 }, 105 },
+   { { -3767, -24910, 663, -1692 }, -1605 },
+   { { 3970, -31394, 1551, -2404 }, 184 },
+   { { -2692, -23906, 1376, -1988 }, -1080 },
+   { { 3944, -35206, 1659, -2666 }, 198 },
+   { { -1679, -21593, 849, -1536 }, -1095 },
+   { { 3500, -33850, 1493, -2544 }, 74 },
+   { { -3294, -21014, 562, -1723 }, -1444 },
+   { { 3851, -31030, 1553, -2416 }, 174 },
+   { { -1038, -28775, 1323, -2383 }, -783 },
+   { { 3285, -33944, 1579, -2611 }, 75 },
+   { { -2864, -26151, 977, -2591 }, -1159 },
+   { { 3924, -35029, 1684, -2600 }, 191 },
+   { { 2418, -31360, 1244, -2344 }, -155 },
+   { { -531, -31536, 1430, -2418 }, -704 },
+   { { 3403, -35367, 1690, -2670 }, 110 },
+   { { -2170, -18837, 693, -2166 }, -1021 },
+   { { 3538, -33000, 1552, -2512 }, 105 },
+   { { 541, -32108, 1151, -2141 }, -636 },
+   { { 3085, -33979, 1536, -2571 }, 18 },
+   { { -827, -30774, 1244, -2418 }, -798 },
+   { { 3283, -34228, 1546, -2587 }, 54 },
+   { { -1324, -29529, 1026, -2095 }, -1005 },
+   { { 3365, -35377, 1662, -2620 }, 83 },
+   { { -1857, -21518, 442, -1414 }, -1254 },
+   { { 3555, -30848, 1317, -2331 }, 38 },
+   { { -379, -21364, 484, -1565 }, -874 },
+   { { 272, -2570, 1428, -3784 }, 530 },
+   { { 651, -29204, 1280, -2251 }, -491 },
+   { { 3083, -33915, 1531, -2561 }, 16 },
+   { { 2653, -30966, 1415, -2366 }, 63 },
+   { { 2588, -31056, 1316, -2334 }, 104 },
+   { { 3814, -31922, 1528, -2389 }, -138 },
+   { { -2900, -24687, 912, -1665 }, 1322 },
+   { { 3755, -34652, 1674, -2592 }, -168 },
+   { { -2521, -29680, 1500, -2105 }, 1100 },
+   { { 3926, -31997, 1564, -2446 }, -176 },
+   { { -2934, -24133, 670, -1669 }, 1404 },
+   { { 62, -26360, 940, -2196 }, 599 },
+   { { 3550, -32325, 1566, -2535 }, -127 },
+   { { -1292, -22625, 571, -1950 }, 997 },
+   { { 3261, -34016, 1579, -2605 }, -67 },
+   { { -745, -29232, 1284, -2214 }, 790 },
+   { { 3709, -34346, 1598, -2585 }, -140 },
+   { { -1819, -18680, 951, -1501 }, 1061 },
+   { { 1208, -28763, 1088, -2122 }, 399 },
+   { { 2339, -30298, 1373, -2409 }, 114 },
+   { { 3382, -33090, 1480, -2566 }, -71 },
+   { { -971, -23956, 775, -1610 }, 974 },
+   { { 3303, -34371, 1569, -2631 }, -71 },
+   { { -590, -27515, 1072, -2110 }, 799 },
+   { { 1345, -11445, 1472, -885 }, 274 },
+   { { -1212, -24055, 717, -1676 }, 1003 },
+   { { 3093, -33957, 1539, -2569 }, -21 },
+   { { 804, -31084, 1268, -2434 }, 466 },
+   { { 2984, -32833, 1450, -2528 }, 3 },
+   { { 1984, -29689, 999, -2256 }, 243 },
+   { { 3009, -33189, 1485, -2525 }, 0 },
+   { { 1193, -27800, 1039, -3551 }, 399 },
+   { { 2276, -29466, 1166, -2221 }, 189 },
+   { { 3795, -30822, 1560, -2318 }, -152 },
+   { { -2507, -25279, 678, -1508 }, 1317 },
+   { { 331, -25281, 830, -1897 }, 629 },
+   { { 3393, -34106, 1580, -2554 }, -83 },
+   { { -1304, -17753, 682, -1988 }, 975 },
+   { { 511, -39329, 1429, -2397 }, 492 },
+   { { -678, -20057, 378, -1468 }, 972 },
+   { { 3327, -34772, 1564, -2611 }, -65 },
+   { { -492, -30012, 1242, -2217 }, 754 },
+   { { 2589, -32154, 1358, -2580 }, 95 },
+   { { 3074, -33787, 1526, -2566 }, -17 },
+   { { 1124, -31502, 1497, -2341 }, 363 },
+   { { 3344, -34536, 1659, -2664 }, -100 },
+   { { -302, -32817, 1266, -2534 }, 722 },
+   { { 3781, -35724, 1635, -2688 }, -163 },
+   { { -2152, -26137, 1143, -2350 }, 1077 },
+   { { 3462, -33320, 1476, -2561 }, -76 },
+   { { -1858, -24316, 598, -1739 }, 1187 },
+   { { 3686, -31745, 1457, -2426 }, -105 },
+   { { -2597, -19655, 611, -1800 }, 1275 },
+   { { 3321, -34733, 1583, -2622 }, -71 },
+   { { -292, -30301, 1186, -2445 }, 707 },
+   { { 3709, -33913, 1700, -2617 }, -182 },
+   { { -2247, -27297, 1297, -2056 }, 1073 },
+   { { 3193, -33860, 1528, -2573 }, -39 },
+   { { 88, -29373, 930, -2155 }, 715 },
+   { { 3058, -33656, 1526, -2565 }, -16 },
+   { { 1261, -32323, 1385, -2418 }, 368 },
+   { { 1173, -27629, 985, -2778 }, 364 },
+   { { 1340, -24949, 1418, -2537 }, 254 },
+   { { 1360, -31053, 1357, -2317 }, 313 },
+   { { 1756, -33000, 1493, -2174 }, 247 },
+   { { 3093, -33981, 1528, -2569 }, -17 },
+   { { 799, -33142, 1357, -2237 }, 524 },
+   { { 2779, -31856, 1337, -2453 }, 59 },
+   { { 2736, -31607, 1317, -2424 }, 70 },
+   { { 2436, -28847, 1373, -2317 }, 99 },
+   { { 2066, -27041, 1300, -2024 }, 207 },
+   { { 617, -30257, 1201, -2259 }, -538 },
+   { { 3079, -33774, 1528, -2572 }, 20 },
+   { { -512, -26121, 1111, -2005 }, -771 },
+   { { 3344, -33858, 1591, -2636 }, 97 },
+   { { -1310, -26900, 734, -1988 }, -1017 },
+   { { 3488, -32835, 1512, -2568 }, 104 },
+   { { -710, -29359, 1374, -2131 }, -785 },
+   { { 3266, -34480, 1615, -2601 }, 65 },
+   { { 3249, -33729, 1557, -2592 }, -60 },
+   { { -436, -27484, 812, -2076 }, 828 },
+   { { 3058, -33588, 1517, -2570 }, -16 },
+   { { 844, -31535, 1128, -2445 }, 500 },
+   { { 4649, -8967, 1389, 10 }, -34 },
+   { { -918, -22487, 737, -1744 }, 889 },
+   { { 2263, -32337, 1403, -2299 }, 152 },
+   { { 3424, -33690, 1507, -2564 }, -75 },
+   { { -423, -24283, 537, -1961 }, 865 },
+   { { 3266, -34367, 1556, -2633 }, -58 },
+   { { -120, -26922, 1190, -2147 }, 676 },
+   { { 2644, -31547, 1216, -2481 }, -87 },
+   { { 1968, -30816, 1312, -2239 }, -239 },
+   { { -523, -29390, 1106, -2201 }, -781 },
+   { { 3314, -33639, 1610, -2607 }, 88 },
+   { { 1015, -30576, 1117, -2225 }, -491 },
+   { { 3085, -33651, 1530, -2586 }, 28 },
+   { { 741, -27529, 1402, -2461 }, -357 },
+   { { 3089, -33907, 1532, -2579 }, 21 },
+   { { -1676, -21831, 563, -1469 }, -1162 },
+   { { 3534, -32102, 1427, -2401 }, 59 },
+   { { -172, -8307, 990, -666 }, 659 },
+   { { 220, -4694, 503, -729 }, 674 },
+   { { 200, -29172, 1027, -1948 }, 650 },
+   { { 3010, -33201, 1486, -2526 }, 0 },
+   { { 3010, -33201, 1486, -2526 }, 0 },
+   { { 2925, -32499, 1442, -2495 }, -11 },
+   { { 2895, -32243, 1427, -2475 }, -18 },
+   { { 2610, -32294, 1362, -2351 }, -104 },
+   { { 2917, -32532, 1435, -2448 }, -19 },
+   { { 2763, -31878, 1371, -2395 }, -59 },
+   { { 2677, -31293, 1456, -2248 }, -63 },
+   { { 2306, -28107, 1140, -2130 }, -174 },
+   { { 2612, -30670, 1171, -2407 }, -115 },
+   { { 2508, -31924, 1213, -2376 }, -148 },
+   { { 2887, -32384, 1406, -2485 }, 23 },
+   { { 2925, -32735, 1453, -2491 }, 15 },
+   { { 2617, -32529, 1324, -2370 }, 118 },
+   { { 2693, -30777, 1240, -2437 }, 83 },
+   { { 2937, -32604, 1439, -2480 }, 15 },
+   { { 2132, -26232, 1154, -2300 }, 148 },
+   { { 2521, -30090, 1266, -2291 }, 114 },
+   { { 2787, -31412, 1243, -2434 }, 79 },
+   { { 2343, -29303, 1269, -2266 }, 135 },
+   { { 2660, -31974, 1370, -2398 }, 80 },
+   { { 2310, -30357, 995, -2275 }, 231 },
+   { { 3730, -34196, 1663, -2580 }, -167 },
+   { { -2659, -25587, 1016, -1789 }, 1254 },
+   { { 2178, -29844, 1129, -2138 }, 236 },
+   { { 3328, -34831, 1605, -2644 }, -78 },
+   { { -1055, -27885, 1165, -1994 }, 888 },
+   { { 3275, -34220, 1548, -2602 }, -57 },
+   { { -245, -35277, 1473, -2490 }, 679 },
+   { { 3060, -33707, 1527, -2561 }, -16 },
+   { { 662, -28407, 1256, -2282 }, 477 },
+   { { 3348, -35331, 1606, -2679 }, -79 },
+   { { -670, -33186, 1447, -2177 }, 775 },
+   { { 2802, -31830, 1362, -2364 }, 57 },
+   { { 2347, -29225, 1293, -2232 }, 139 },
+   { { 2738, -31682, 1320, -2456 }, 67 },
+   { { 2709, -31514, 1326, -2424 }, -72 },
+   { { 2660, -32511, 1333, -2474 }, -98 },
+   { { 2507, -31342, 1244, -2308 }, -143 },
+   { { 2307, -29794, 1307, -2221 }, -146 },
+   { { 2129, -30081, 1061, -2258 }, -246 },
+   { { -751, -28134, 1221, -2450 }, -757 },
+   { { 3305, -34114, 1554, -2625 }, 69 },
+   { { -2507, -26797, 1066, -1941 }, -1204 },
+   { { 3752, -34145, 1601, -2632 }, 159 },
+   { { -967, -31667, 1120, -2215 }, -913 },
+   { { 3376, -34889, 1622, -2672 }, 94 },
+   { { 925, -29560, 1310, -2352 }, -425 },
+   { { 3074, -33806, 1517, -2562 }, 14 },
+   { { -789, -33609, 1349, -2328 }, -821 },
+   { { 3320, -34811, 1600, -2617 }, 73 },
+   { { 735, -28980, 1158, -2505 }, -478 },
+   { { 3070, -33873, 1524, -2581 }, 16 },
+   { { 1124, -28972, 1271, -2366 }, -384 },
+   { { 3059, -33697, 1528, -2555 }, 15 },
+   { { 2419, -31227, 1313, -2382 }, 134 },
+   { { 3066, -33575, 1523, -2567 }, -18 },
+   { { 935, -31520, 1137, -2322 }, 488 },
+   { { 3257, -34080, 1559, -2576 }, -55 },
+   { { -340, -27845, 1275, -2219 }, 695 },
+   { { 3061, -33753, 1520, -2563 }, -14 },
+   { { 1133, -32111, 1642, -2526 }, 311 },
+   { { 2665, -30609, 1364, -2507 }, -56 },
+   { { 2965, -32854, 1458, -2523 }, -6 },
+};
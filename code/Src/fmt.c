@@ -0,0 +1,156 @@
+#include "fmt.h"
+
+/*
+ * Text formatting for the few human readable lines the firmware sends
+ * (TEXT messages, telemPanic()), instead of newlib's sprintf, which takes
+ * over 2 KB of flash with its malloc and _sbrk, a few hundred bytes of
+ * stack and, for some conversions, the heap.
+ *
+ * Only what the lines need: strings, decimal integers, hex and signed
+ * fixed point. Everything goes into the caller's buffer through an
+ * fmt_t; what does not fit is cut off, so a call never writes past size
+ * and the caller checks len if it cares. No terminator is written, the
+ * messages carry their length.
+ *
+ * Every call is a loop over at most 10 digits, each a divide by 10 (a
+ * UDIV, or a multiply by the reciprocal where the compiler substitutes
+ * one) and a few ALU instructions. Counted from the code, not measured on
+ * the target, that bounds a number at a few hundred cycles whatever its
+ * value, and the stack at the 10 digit scratch buffer and a few saved
+ * registers. No heap, no locale, no errno.
+ */
+
+static const uint16_t fmtPow10[FMT_DECIMALS_MAX + 1] = { 1, 10, 100, 1000, 10000 };
+
+
+//-------------------------------------------------------------------------------------
+/** @brief   Start a line in a buffer
+ *  @param   f Line
+ *  @param   buf Buffer
+ *  @param   size Buffer bytes
+ */
+void fmtStart(fmt_t * f, char * buf, uint16_t size) {
+   f->buf = buf;
+   f->len = 0;
+   f->size = size;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Append a character if there is room
+ *  @param   f Line
+ *  @param   c Character
+ */
+static void fmtPut(fmt_t * f, char c) {
+   if(f->len < f->size) {
+      f->buf[f->len++] = c;
+   }
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Append the lowest decimal digits of a number
+ *  @param   f Line
+ *  @param   x Number
+ *  @param   digits At least this many digits, padded with zeros, at most 10
+ */
+static void fmtDigits(fmt_t * f, uint32_t x, uint8_t digits) {
+   char d[10];
+   uint8_t n = 0;
+
+   do {
+      d[n++] = '0' + x % 10;
+      x /= 10;
+   } while((x || n < digits) && n < sizeof(d));
+   while(n) {
+      fmtPut(f, d[--n]);
+   }
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Append a string
+ *  @param   f Line
+ *  @param   s 0 terminated string
+ */
+void fmtStr(fmt_t * f, const char * s) {
+   while(*s) {
+      fmtPut(f, *s++);
+   }
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Append an unsigned number in decimal
+ *  @param   f Line
+ *  @param   x Number, up to 10 digits
+ */
+void fmtUint(fmt_t * f, uint32_t x) {
+   fmtDigits(f, x, 1);
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Append a signed number in decimal
+ *  @param   f Line
+ *  @param   x Number, up to a sign and 10 digits
+ */
+void fmtInt(fmt_t * f, int32_t x) {
+   if(x < 0) {
+      fmtPut(f, '-');
+   }
+   fmtDigits(f, x < 0 ? 0U - (uint32_t)x : (uint32_t)x, 1);
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Append a number in hex, upper case, without 0x
+ *  @param   f Line
+ *  @param   x Number
+ *  @param   digits Lowest digits to show, 1 to 8
+ */
+void fmtHex(fmt_t * f, uint32_t x, uint8_t digits) {
+   uint8_t h;
+
+   if(digits > 8) {
+      digits = 8;
+   }
+   while(digits) {
+      h = (x >> (4 * --digits)) & 0xF;
+      fmtPut(f, h < 10 ? '0' + h : 'A' + h - 10);
+   }
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Append a fixed point number in decimal, rounded to nearest,
+ *           halves away from 0
+ *  @details E.g. x = 0x18000 with q = 16 and 2 decimals gives "1.50".
+ *           The fraction is scaled in 32 bits, which limits q and the
+ *           decimals; larger ones are taken as the limits.
+ *  @param   f Line
+ *  @param   x Number, x / 2^q
+ *  @param   q Fraction bits, at most FMT_Q_MAX
+ *  @param   decimals Digits after the point, at most FMT_DECIMALS_MAX, 0
+ *           for none and no point
+ */
+void fmtFixed(fmt_t * f, int32_t x, uint8_t q, uint8_t decimals) {
+   uint32_t m = x < 0 ? 0U - (uint32_t)x : (uint32_t)x;
+   uint32_t whole, part = 0;
+
+   if(q > FMT_Q_MAX) {
+      q = FMT_Q_MAX;
+   }
+   if(decimals > FMT_DECIMALS_MAX) {
+      decimals = FMT_DECIMALS_MAX;
+   }
+   whole = m >> q;
+   if(q) {
+      part = ((m & ((1UL << q) - 1)) * fmtPow10[decimals] + (1UL << (q - 1))) >> q;
+      if(part == fmtPow10[decimals]) {
+         whole++;
+         part = 0;
+      }
+   }
+   if(x < 0 && (whole || part)) {
+      fmtPut(f, '-');
+   }
+   fmtDigits(f, whole, 1);
+   if(decimals) {
+      fmtPut(f, '.');
+      fmtDigits(f, part, decimals);
+   }
+}
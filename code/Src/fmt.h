@@ -0,0 +1,24 @@
+#ifndef FMT_H
+#define FMT_H
+#include <stdint.h>
+
+/** @brief Largest fmtFixed() q **/
+#define FMT_Q_MAX 16
+/** @brief Most fmtFixed() decimals **/
+#define FMT_DECIMALS_MAX 4
+
+/** @brief Text being put together in a caller's buffer **/
+typedef struct {
+   char * buf;
+   uint16_t len;    /**< characters written, never more than size */
+   uint16_t size;
+} fmt_t;
+
+void fmtStart(fmt_t * f, char * buf, uint16_t size);
+void fmtStr(fmt_t * f, const char * s);
+void fmtUint(fmt_t * f, uint32_t x);
+void fmtInt(fmt_t * f, int32_t x);
+void fmtHex(fmt_t * f, uint32_t x, uint8_t digits);
+void fmtFixed(fmt_t * f, int32_t x, uint8_t q, uint8_t decimals);
+
+#endif
@@ -0,0 +1,331 @@
+#include "friction.h"
+
+/* excitation routine tuning (ticks are calls to frictionIdentStep) */
+#define RAMP_STEP    2      /* torque added per ramp interval */
+#define RAMP_TICKS   10     /* ticks between ramp increments */
+#define STOP_TICKS   300    /* ticks the arm must be still before next phase */
+#define SWEEP_LEVELS 4      /* constant torque levels used for the sweep */
+#define SWEEP_STEP   60     /* torque between sweep levels */
+#define SETTLE_TICKS 400    /* ticks to reach steady state at each level */
+#define AVG_TICKS    256    /* ticks averaged at each level (power of 2) */
+#define IDENT_MAX    1000   /* give up if breakaway needs more than this */
+
+/* online adaptation */
+#define ACC_QUIET    1      /* |acc| below this counts as steady motion */
+#define MU_C_SHIFT   10     /* coulomb adaptation rate (2^-n) */
+#define MU_V_SHIFT   12     /* viscous adaptation rate (2^-n) */
+#define ACC_Q        8      /* fractional bits kept by the adaptation */
+
+/* stiction compensation ramps in over this much demanded torque */
+#define DIR_FULL     64
+
+enum {
+   ID_IDLE = 0,
+   ID_BREAK_POS,
+   ID_STOP_POS,
+   ID_BREAK_NEG,
+   ID_STOP_NEG,
+   ID_SWEEP,
+   ID_DONE
+};
+
+static friction_t model;
+
+/* high resolution copies of the adapted terms */
+static int32_t coulombAcc;
+static int32_t viscousAcc;
+
+static struct {
+   uint8_t phase;
+   uint8_t level;
+   int16_t torque;
+   uint16_t ticks;
+   int32_t velFilt;       /* velocity, Q4 */
+   int32_t velSum;
+   int16_t breakPos;
+   int16_t breakNeg;
+   int64_t sx, sy, sxx, sxy;  /* least squares sums, x = |v| Q4, y = |u| */
+   int32_t lowVel;        /* |v| Q4 at the lowest sweep level */
+   int16_t lowTorque;
+} id;
+
+
+static int32_t iabs(int32_t x) {
+   return x < 0 ? -x : x;
+}
+
+static int16_t clampTorque(int32_t t) {
+   if(t > 1000) {
+      return 1000;
+   }
+   if(t < -1000) {
+      return -1000;
+   }
+   return t;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Load the default (unidentified) friction model
+ *  @details The defaults are conservative values measured by hand on the
+ *           first rig. They are replaced by frictionIdentStep() and then
+ *           tracked by frictionUpdate().
+ */
+void frictionInit(void) {
+   model.coulomb = 120;
+   model.stiction = 160;
+   model.viscous = 1 << (FRIC_Q - 1);
+   model.stribeck = 8;
+   coulombAcc = (int32_t)model.coulomb << ACC_Q;
+   viscousAcc = model.viscous;
+   id.phase = ID_IDLE;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Returns the current friction model
+ *  @return  Pointer to the model used by frictionCompensate()
+ */
+const friction_t * frictionModel(void) {
+   return &model;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Stribeck shape exp(-(v/vs)^2), approximated as vs^2/(vs^2+v^2)
+ *  @param   vel Velocity in counts/tick
+ *  @return  Shape factor in Q15, 1.0 at standstill
+ */
+static int32_t stribeckShape(int32_t vel) {
+   int64_t vs2 = (int64_t)model.stribeck * model.stribeck;
+   int64_t v2 = (int64_t)vel * vel;
+   if(vs2 == 0) {
+      return 0;
+   }
+   return (int32_t)((vs2 << FRIC_Q) / (vs2 + v2));
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Feedforward torque that cancels the modeled friction
+ *  @details While moving, the full Coulomb + Stribeck + viscous model is
+ *           evaluated at the measured velocity. At standstill the model is
+ *           evaluated in the direction the caller wants to move, and the
+ *           breakaway term is faded in over DIR_FULL of demand so the
+ *           compensation does not chatter around a setpoint.
+ *  @param   vel Measured arm velocity in counts/tick
+ *  @param   dir Demanded torque (only its sign and size near zero are used)
+ *  @return  Compensation torque to add to the command, -1000 to 1000
+ */
+int16_t frictionCompensate(int32_t vel, int32_t dir) {
+   int32_t level;
+
+   if(iabs(vel) <= FRIC_V_STILL) {
+      int32_t mag = iabs(dir);
+      if(mag == 0) {
+         return 0;
+      }
+      if(mag > DIR_FULL) {
+         mag = DIR_FULL;
+      }
+      level = model.stiction * mag / DIR_FULL;
+      return clampTorque(dir < 0 ? -level : level);
+   }
+
+   level = model.coulomb
+      + (((model.stiction - model.coulomb) * stribeckShape(vel)) >> FRIC_Q);
+   if(vel < 0) {
+      level = -level;
+   }
+   return clampTorque(level + ((model.viscous * vel) >> FRIC_Q));
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Track slow changes of the Coulomb and viscous terms
+ *  @details Runs a normalized LMS step on the residual between the applied
+ *           torque and the modeled friction. Only samples in steady motion
+ *           well above the Stribeck region are used, where the applied
+ *           torque is (almost) all friction.
+ *  @param   torque The total torque that was applied this tick
+ *  @param   vel Arm velocity in counts/tick
+ *  @param   acc Arm acceleration in counts/tick^2
+ */
+void frictionUpdate(int16_t torque, int32_t vel, int32_t acc) {
+   int32_t v = iabs(vel);
+   int32_t r;
+
+   if(id.phase != ID_IDLE && id.phase != ID_DONE) {
+      return;
+   }
+   if(iabs(acc) > ACC_QUIET || v < 4 * model.stribeck || v <= FRIC_V_STILL) {
+      return;
+   }
+   if((torque < 0) != (vel < 0)) {
+      return;
+   }
+
+   r = iabs(torque) - model.coulomb - ((model.viscous * v) >> FRIC_Q);
+
+   coulombAcc += (r * (1 << ACC_Q)) >> MU_C_SHIFT;
+   viscousAcc += (int32_t)(((int64_t)r * v * (1 << FRIC_Q))
+                           / ((int64_t)v * v + 1) >> MU_V_SHIFT);
+
+   if(coulombAcc < 0) {
+      coulombAcc = 0;
+   }
+   if(coulombAcc > ((int32_t)model.stiction << ACC_Q)) {
+      coulombAcc = (int32_t)model.stiction << ACC_Q;
+   }
+   if(viscousAcc < 0) {
+      viscousAcc = 0;
+   }
+   model.coulomb = coulombAcc >> ACC_Q;
+   model.viscous = viscousAcc;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Begin the friction excitation routine
+ *  @details After this call frictionIdentStep() must be called once per
+ *           control tick with the arm free to rotate until it stops
+ *           returning FRIC_IDENT_RUNNING.
+ */
+void frictionIdentStart(void) {
+   id.phase = ID_BREAK_POS;
+   id.level = 0;
+   id.torque = 0;
+   id.ticks = 0;
+   id.velFilt = 0;
+   id.velSum = 0;
+   id.sx = id.sy = id.sxx = id.sxy = 0;
+   id.lowVel = 0;
+   id.lowTorque = 0;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Fit coulomb and viscous terms to the sweep and derive vs
+ *  @return  FRIC_IDENT_DONE if the fit is usable, FRIC_IDENT_FAILED otherwise
+ */
+static fricIdentStatus_t identSolve(void) {
+   int64_t n = SWEEP_LEVELS;
+   int64_t den = n * id.sxx - id.sx * id.sx;
+   int32_t fv, fc, fs;
+
+   if(den <= 0) {
+      return FRIC_IDENT_FAILED;
+   }
+   /* slope is per Q4 velocity, so scale by 2^(Q+4) to land in Q15 per count */
+   fv = (int32_t)((n * id.sxy - id.sx * id.sy) * (1 << (FRIC_Q + 4)) / den);
+   fc = (int32_t)((id.sy - ((fv * id.sx) >> (FRIC_Q + 4))) / n);
+   fs = (id.breakPos + id.breakNeg) / 2;
+
+   if(fv < 0 || fc < 0 || fc > fs) {
+      return FRIC_IDENT_FAILED;
+   }
+
+   model.viscous = fv;
+   model.coulomb = fc;
+   model.stiction = fs;
+
+   /* solve the Stribeck shape at the lowest level for vs:
+      s = (u - fc - fv v) / (fs - fc),  vs^2 = v^2 s / (1 - s) */
+   if(fs > fc) {
+      int32_t v = id.lowVel >> 4;
+      int32_t ex = id.lowTorque - fc - ((fv * v) >> FRIC_Q);
+      int32_t s = ex * (1 << FRIC_Q) / (fs - fc);
+      if(s > 0 && s < (1 << FRIC_Q)) {
+         int64_t vs2 = (int64_t)v * v * s / ((1 << FRIC_Q) - s);
+         int32_t vs = 1;
+         while((int64_t)vs * vs < vs2) {
+            vs++;
+         }
+         model.stribeck = vs;
+      }
+   }
+
+   coulombAcc = (int32_t)model.coulomb << ACC_Q;
+   viscousAcc = model.viscous;
+   return FRIC_IDENT_DONE;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Advance the friction excitation routine by one tick
+ *  @details Ramps the torque slowly in each direction to find the breakaway
+ *           level, then holds a few constant torque levels above it and
+ *           fits |u| = Fc + Fv |v| to the steady state velocities.
+ *  @param   vel Arm velocity this tick in counts/tick
+ *  @param   torque Set to the torque to apply this tick
+ *  @return  FRIC_IDENT_RUNNING until the routine has finished
+ */
+fricIdentStatus_t frictionIdentStep(int32_t vel, int16_t * torque) {
+   id.velFilt += (vel * 16 - id.velFilt) >> 3;
+   id.ticks++;
+
+   switch(id.phase) {
+   case ID_BREAK_POS:
+   case ID_BREAK_NEG:
+      if(iabs(id.velFilt) > (FRIC_V_STILL << 4)) {
+         if(id.phase == ID_BREAK_POS) {
+            id.breakPos = id.torque;
+         } else {
+            id.breakNeg = -id.torque;
+         }
+         id.torque = 0;
+         id.ticks = 0;
+         id.phase++;
+         break;
+      }
+      if(id.ticks >= RAMP_TICKS) {
+         id.ticks = 0;
+         id.torque += (id.phase == ID_BREAK_POS) ? RAMP_STEP : -RAMP_STEP;
+         if(iabs(id.torque) > IDENT_MAX) {
+            id.phase = ID_DONE;
+            *torque = 0;
+            return FRIC_IDENT_FAILED;
+         }
+      }
+      break;
+
+   case ID_STOP_POS:
+   case ID_STOP_NEG:
+      if(iabs(id.velFilt) > (FRIC_V_STILL << 4)) {
+         id.ticks = 0;
+      } else if(id.ticks >= STOP_TICKS) {
+         id.ticks = 0;
+         id.phase++;
+         if(id.phase == ID_SWEEP) {
+            id.torque = (id.breakPos + id.breakNeg) / 2 + SWEEP_STEP;
+         }
+      }
+      break;
+
+   case ID_SWEEP:
+      if(id.ticks > SETTLE_TICKS) {
+         id.velSum += vel;
+      }
+      if(id.ticks == SETTLE_TICKS + AVG_TICKS) {
+         int64_t x = iabs(id.velSum) * 16 / AVG_TICKS;
+         int64_t y = iabs(id.torque);
+         id.sx += x;
+         id.sy += y;
+         id.sxx += x * x;
+         id.sxy += x * y;
+         if(id.level == 0) {
+            id.lowVel = x;
+            id.lowTorque = y;
+         }
+         id.velSum = 0;
+         id.ticks = 0;
+         if(++id.level == SWEEP_LEVELS) {
+            id.phase = ID_DONE;
+            *torque = 0;
+            return identSolve();
+         }
+         /* alternate direction so the arm does not wind up its cable */
+         id.torque = (id.torque < 0 ? 1 : -1) * (iabs(id.torque) + SWEEP_STEP);
+      }
+      break;
+
+   default:
+      *torque = 0;
+      return FRIC_IDENT_DONE;
+   }
+
+   *torque = clampTorque(id.torque);
+   return FRIC_IDENT_RUNNING;
+}
@@ -0,0 +1,34 @@
+#ifndef FRICTION_H
+#define FRICTION_H
+#include <stdint.h>
+
+/** @brief Q format used for the viscous coefficient and Stribeck shape **/
+#define FRIC_Q 15
+
+/** @brief Velocity (counts/tick) treated as standing still **/
+#define FRIC_V_STILL 2
+
+/** @brief Friction model of the arm, all torques in setMotorTorque() units **/
+typedef struct {
+   int16_t coulomb;   /**< Coulomb (kinetic) friction level */
+   int16_t stiction;  /**< Static (breakaway) friction level */
+   int32_t viscous;   /**< Viscous slope, Q15 torque per count/tick */
+   int32_t stribeck;  /**< Stribeck velocity in counts/tick */
+} friction_t;
+
+/** @brief Identification progress reported by frictionIdentStep() **/
+typedef enum {
+   FRIC_IDENT_RUNNING = 0,
+   FRIC_IDENT_DONE,
+   FRIC_IDENT_FAILED
+} fricIdentStatus_t;
+
+void frictionInit(void);
+const friction_t * frictionModel(void);
+int16_t frictionCompensate(int32_t vel, int32_t dir);
+void frictionUpdate(int16_t torque, int32_t vel, int32_t acc);
+
+void frictionIdentStart(void);
+fricIdentStatus_t frictionIdentStep(int32_t vel, int16_t * torque);
+
+#endif
@@ -0,0 +1,239 @@
+#include "ident.h"
+#include "rls.h"
+#include "trig.h"
+#include "ring.h"
+#include <string.h>
+
+/** @brief Samples each model needs before its estimates are published **/
+#define IDENT_MIN_SAMPLES 200
+
+/** @brief 2 * pi in Q15 **/
+#define TWO_PI_Q15 205887
+
+/** @brief Samples per second **/
+#define IDENT_RATE (IDENT_TICK_HZ / IDENT_DECIM)
+
+/* log written by the control loop, read by the background task; one
+   record more than IDENT_LOG_LEN since the ring never fills completely */
+static uint32_t logMem[(IDENT_LOG_LEN + 1) * RING_RECORD(sizeof(identSample_t)) / 4];
+static ring_t sampleLog;
+static volatile uint32_t overruns;
+
+/* decimation state, control loop side; gap is set when the next sample
+   does not follow on the last one logged */
+static int32_t torqueSum;
+static uint8_t decimCount;
+static uint8_t gap;
+
+/* estimator state, background side */
+static rls_t armRls;
+static rls_t pendRls;
+static identSample_t hist[2];
+static uint8_t histLen;
+
+/* published parameters, double buffered so readers never see a half update */
+static identParams_t params[2];
+static volatile uint8_t paramsActive;
+
+
+//-------------------------------------------------------------------------------------
+/** @brief   Clamp to the Q15 regressor range
+ *  @param   x Value to clamp
+ *  @return  x limited to +-32767
+ */
+static int16_t sat15(int32_t x) {
+   if(x > 32767) {
+      return 32767;
+   }
+   if(x < -32767) {
+      return -32767;
+   }
+   return x;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Sine of a 16 bit angle from the motor LUT
+ *  @param   angle 65536 per rev
+ *  @return  sin(angle), Q15
+ */
+static int16_t sinQ15(uint16_t angle) {
+   return sat15(((int32_t)sinShift03(angle >> 4) - 2048) * 16);
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Reset the log and both estimators
+ */
+void identInit(void) {
+   ringInit(&sampleLog, logMem, sizeof(logMem));
+   overruns = 0;
+   torqueSum = 0;
+   decimCount = 0;
+   gap = 0;
+   histLen = 0;
+   rlsInit(&armRls, 3, IDENT_LAMBDA, IDENT_P0);
+   rlsInit(&pendRls, 3, IDENT_LAMBDA, IDENT_P0);
+   params[0].valid = 0;
+   params[1].valid = 0;
+   paramsActive = 0;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   The arm origin moves, call on the control loop side
+ *  @details Velocities and accelerations are differences of consecutive
+ *           samples, so the estimators must not difference across the
+ *           jump. The next sample is preceded by an empty record in the
+ *           log, and identProcess() starts its history over there. The
+ *           estimates themselves are kept.
+ */
+void identRestart(void) {
+   torqueSum = 0;
+   decimCount = 0;
+   gap = 1;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Log the plant state, called once per control tick
+ *  @details Only averages the torque and stores every IDENT_DECIM-th
+ *           sample, so it is cheap enough for the control loop. If the
+ *           background task fell behind the sample is dropped and counted,
+ *           and the history starts over as after identRestart().
+ *  @param   arm Unwrapped arm position in counts, torque direction
+ *  @param   pend Pendulum angle, 65536 per rev, 0 hanging down
+ *  @param   torque Torque applied over this tick
+ */
+void identLog(int32_t arm, uint16_t pend, int16_t torque) {
+   identSample_t * s;
+
+   torqueSum += torque;
+   if(++decimCount < IDENT_DECIM) {
+      return;
+   }
+
+   if(gap && ringReserve(&sampleLog, 0)) {
+      ringCommit(&sampleLog, 0);
+      gap = 0;
+   }
+   s = gap ? 0 : ringReserve(&sampleLog, sizeof(*s));
+   if(!s) {
+      overruns++;
+      gap = 1;
+   } else {
+      s->arm = arm;
+      s->pend = pend;
+      s->torque = torqueSum / IDENT_DECIM;
+      ringCommit(&sampleLog, sizeof(*s));
+   }
+   torqueSum = 0;
+   decimCount = 0;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Convert the raw RLS parameters and publish them
+ *  @details See identParams_t for the models. With D control ticks per
+ *           sample the arm regression is
+ *           dw = D^2/ka u - D kv/ka w - D^2 coulomb/ka sgn(w) and the
+ *           pendulum regression
+ *           dw = -w0^2 T^2 sin(a) - damping T w + coupling cos(a) dwArm,
+ *           both in counts per sample.
+ */
+static void publish(void) {
+   identParams_t * p = &params[paramsActive ^ 1];
+   const int32_t * a = armRls.theta;
+   const int32_t * b = pendRls.theta;
+
+   p->valid = 0;
+   p->samples = armRls.updates;
+   if(a[1] > 0) {
+      p->armKa = (int32_t)(((int64_t)IDENT_DECIM * IDENT_DECIM * 1024 << 16) / a[1]);
+      p->armKv = (int32_t)(-((int64_t)a[0] * IDENT_DECIM << 16) / a[1]);
+      p->armCoulomb = (int16_t)(-((int64_t)a[2] * 1024) / a[1]);
+      p->motorGain = (int32_t)((int64_t)a[1] * 1000 * IDENT_RATE * IDENT_RATE >> 26);
+   }
+   if(b[0] < 0) {
+      p->pendW0Sq = (int32_t)(-(int64_t)b[0] * IDENT_RATE * IDENT_RATE * TWO_PI_Q15 >> 39);
+      p->pendLength = p->pendW0Sq > 0 ? 14715L * 256 / p->pendW0Sq : 0;
+   }
+   p->pendDamping = -b[1] * IDENT_RATE / 2048;
+   p->pendCoupling = b[2] / 128;
+   p->valid = a[1] > 0 && b[0] < 0 && armRls.updates >= IDENT_MIN_SAMPLES
+      && pendRls.updates >= IDENT_MIN_SAMPLES;
+
+   paramsActive ^= 1;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Run the estimators on everything logged so far
+ *  @details Meant for a low priority task: the control loop only pays for
+ *           identLog(). Velocities and accelerations are differences of
+ *           the decimated positions, which is where the decimation pays
+ *           off, the pendulum acceleration is a hundred times larger per
+ *           sample than per tick while the quantization stays one count.
+ *  @return  Number of samples processed
+ */
+uint16_t identProcess(void) {
+   uint16_t n = 0;
+   int16_t phi[RLS_MAX_N];
+   identSample_t s;
+   const void * p;
+   uint32_t len;
+
+   while((p = ringPeek(&sampleLog, &len)) != 0) {
+      if(len != sizeof(s)) {
+         /* gap marker, see identRestart() */
+         ringRelease(&sampleLog);
+         histLen = 0;
+         continue;
+      }
+      memcpy(&s, p, sizeof(s));
+      ringRelease(&sampleLog);
+      n++;
+
+      if(histLen < 2) {
+         hist[histLen++] = s;
+         continue;
+      }
+
+      /* arm, counts per sample, centred on the middle sample */
+      int32_t w2 = s.arm - hist[0].arm;
+      int32_t dw = s.arm - 2 * hist[1].arm + hist[0].arm;
+      phi[0] = sat15(w2 * 16);
+      phi[1] = sat15((s.torque + hist[1].torque) * 16);
+      phi[2] = w2 > 2 ? 32767 : (w2 < -2 ? -32767 : 0);
+      if(dw > -32768 && dw < 32768) {
+         rlsUpdate(&armRls, phi, dw * 65536);
+      }
+
+      /* pendulum, wraps at +-pi */
+      int32_t pw = (int16_t)(hist[1].pend - hist[0].pend);
+      int32_t pdw = (int16_t)(s.pend - hist[1].pend) - pw;
+      int32_t c = sinQ15(hist[1].pend + 16384);
+      phi[0] = sinQ15(hist[1].pend);
+      phi[1] = sat15(pw * 16);
+      phi[2] = sat15((int32_t)(((int64_t)c * dw) >> 7));
+      rlsUpdate(&pendRls, phi, pdw * 65536);
+
+      hist[0] = hist[1];
+      hist[1] = s;
+   }
+
+   if(n) {
+      publish();
+   }
+   return n;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Copy the latest identified parameters, e.g. to recompute gains
+ *  @param   out Where to copy the parameters; out->valid says if they can be used
+ */
+void identGetParams(identParams_t * out) {
+   *out = params[paramsActive];
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Samples dropped because the background task fell behind
+ *  @return  Number of dropped samples since identInit()
+ */
+uint32_t identOverruns(void) {
+   return overruns;
+}
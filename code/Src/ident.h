@@ -0,0 +1,49 @@
+#ifndef IDENT_H
+#define IDENT_H
+#include <stdint.h>
+
+/** @brief Control ticks averaged into one logged sample **/
+#define IDENT_DECIM 10
+/** @brief Logged samples that can wait for the background task **/
+#define IDENT_LOG_LEN 32
+/** @brief Control ticks per second, used to scale the identified parameters **/
+#define IDENT_TICK_HZ 1000
+
+/** @brief Forgetting factor, Q16 (0.995: ~2 s memory at 100 samples/s) **/
+#define IDENT_LAMBDA 65208
+/** @brief Initial covariance, Q16 **/
+#define IDENT_P0 (100L << 16)
+
+/** @brief One decimated sample of the plant, written by the control loop **/
+typedef struct {
+   int32_t arm;      /**< unwrapped arm position, counts, torque direction */
+   uint16_t pend;    /**< pendulum angle, 65536 per rev, 0 hanging down */
+   int16_t torque;   /**< average torque applied since the last sample */
+} identSample_t;
+
+/** @brief Identified parameters, in the units the controllers use
+ *
+ *  Arm model:      ka * acc + kv * vel + coulomb * sgn(vel) = u
+ *  Pendulum model: acc = -w0^2 sin(a) - damping * vel + coupling * cos(a) * armAcc
+ */
+typedef struct {
+   int32_t armKa;        /**< inertia, torque per count/tick^2 */
+   int32_t armKv;        /**< damping, Q16 torque per count/tick */
+   int16_t armCoulomb;   /**< Coulomb friction, torque */
+   int32_t motorGain;    /**< arm acceleration at full torque, counts/s^2 */
+   int32_t pendW0Sq;     /**< pendulum natural frequency squared, Q8 rad^2/s^2 */
+   int32_t pendLength;   /**< equivalent rod length 3g / (2 w0^2), mm */
+   int32_t pendDamping;  /**< pendulum damping, Q16 1/s */
+   int32_t pendCoupling; /**< arm to pendulum acceleration gain, Q16 */
+   uint32_t samples;     /**< samples the estimates are based on */
+   uint8_t valid;        /**< 1 once both models had enough samples */
+} identParams_t;
+
+void identInit(void);
+void identRestart(void);
+void identLog(int32_t arm, uint16_t pend, int16_t torque);
+uint16_t identProcess(void);
+void identGetParams(identParams_t * out);
+uint32_t identOverruns(void);
+
+#endif
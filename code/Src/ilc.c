@@ -0,0 +1,188 @@
+#include "ilc.h"
+#include "bsp.h"
+
+/** @brief Marks a valid profile in flash, bump when ilcFlash_t changes **/
+#define ILC_MAGIC 0x494C4301
+
+/** @brief Profile as kept in bspStore(), the reserved flash page **/
+typedef struct {
+   uint32_t magic;
+   uint16_t len;
+   uint16_t trials;
+   uint32_t lastErr;
+   uint16_t converged;
+   uint16_t check;
+   int16_t ff[ILC_LEN];
+} ilcFlash_t;
+
+_Static_assert(sizeof(ilcFlash_t) <= BSP_STORE_BYTES, "ILC profile does not fit the store");
+
+
+//-------------------------------------------------------------------------------------
+/** @brief   Checksum over a stored profile, everything but the check field
+ *  @param   f Profile to check
+ *  @return  16 bit Fletcher checksum
+ */
+static uint16_t ilcCheck(const ilcFlash_t * f) {
+   const uint16_t * h = (const uint16_t *)f;
+   uint16_t n = sizeof(ilcFlash_t) / 2;
+   uint16_t i;
+   uint16_t a = 0;
+   uint16_t b = 0;
+
+   for(i = 0; i < n; i++) {
+      if(&h[i] == &f->check) {
+         continue;
+      }
+      a = (a + (h[i] & 0xFF) + (h[i] >> 8)) % 255;
+      b = (b + a) % 255;
+   }
+   return b << 8 | a;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Start with the stored profile, or with no feedforward at all
+ *  @param   l Learning state to initialize
+ */
+void ilcInit(ilc_t * l) {
+   uint16_t k;
+
+   if(!ilcLoad(l)) {
+      for(k = 0; k < ILC_LEN; k++) {
+         l->ff[k] = 0;
+      }
+      l->trials = 0;
+      l->lastErr = 0;
+      l->converged = 0;
+   }
+   ilcTrialStart(l);
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Forget the previous recording, call before the maneuver starts
+ *  @param   l Learning state
+ */
+void ilcTrialStart(ilc_t * l) {
+   l->len = 0;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Learned feedforward for a sample of the trial
+ *  @param   l Learning state
+ *  @param   k Sample index since the trial started
+ *  @return  Feedforward torque, 0 past the end of the profile
+ */
+int16_t ilcFeedforward(const ilc_t * l, uint16_t k) {
+   return k < ILC_LEN ? l->ff[k] : 0;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Record the tracking error of one sample
+ *  @param   l Learning state
+ *  @param   k Sample index since the trial started, samples come in order
+ *  @param   err Tracking error, reference minus measurement
+ *  @param   dir +1 if more torque at this sample raises the measurement,
+ *               -1 if it lowers it, 0 if torque has no effect here
+ */
+void ilcRecord(ilc_t * l, uint16_t k, int32_t err, int8_t dir) {
+   if(k >= ILC_LEN) {
+      return;
+   }
+   if(err > 32767) {
+      err = 32767;
+   }
+   if(err < -32767) {
+      err = -32767;
+   }
+   l->err[k] = err;
+   l->dir[k] = dir;
+   l->len = k + 1;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Learn from the trial that just finished
+ *  @details P-type update ff(k) += gamma dir(k) e(k + lead), followed by a
+ *           zero phase [1 2 1] / 4 Q-filter so the high frequency part of
+ *           the error, which the plant cannot follow anyway, does not
+ *           accumulate from trial to trial. Samples the trial did not
+ *           reach (it ended early) keep their feedforward.
+ *  @param   l Learning state
+ *  @return  Mean absolute error of the trial
+ */
+uint32_t ilcTrialEnd(ilc_t * l) {
+   uint32_t sum = 0;
+   int32_t prev, cur, next;
+   uint16_t k;
+
+   if(l->len == 0) {
+      return l->lastErr;
+   }
+
+   for(k = 0; k < l->len; k++) {
+      int32_t e = k + ILC_LEAD < l->len ? l->err[k + ILC_LEAD] : 0;
+      int32_t f = l->ff[k] + ((e * l->dir[k] * ILC_GAMMA) >> 10);
+      l->ff[k] = f > ILC_FF_MAX ? ILC_FF_MAX : (f < -ILC_FF_MAX ? -ILC_FF_MAX : f);
+      sum += l->err[k] < 0 ? -l->err[k] : l->err[k];
+   }
+
+   prev = l->ff[0];
+   for(k = 0; k < l->len; k++) {
+      cur = l->ff[k];
+      next = k + 1 < ILC_LEN ? l->ff[k + 1] : cur;
+      l->ff[k] = (prev + 2 * cur + next) / 4;
+      prev = cur;
+   }
+
+   l->lastErr = sum / l->len;
+   l->trials++;
+   l->converged = l->lastErr < ILC_CONV_ERR;
+   l->len = 0;
+   return l->lastErr;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Load the profile stored in flash
+ *  @param   l Learning state to fill
+ *  @return  1 if a valid profile was loaded, 0 if the page is empty or stale
+ */
+uint8_t ilcLoad(ilc_t * l) {
+   const ilcFlash_t * store = bspStore();
+   uint16_t k;
+
+   if(store->magic != ILC_MAGIC || store->len != ILC_LEN
+      || store->check != ilcCheck(store)) {
+      return 0;
+   }
+   for(k = 0; k < ILC_LEN; k++) {
+      l->ff[k] = store->ff[k];
+   }
+   l->trials = store->trials;
+   l->lastErr = store->lastErr;
+   l->converged = store->converged;
+   return 1;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Store the profile in the reserved flash page
+ *  @details Erasing the page stalls the CPU for ~20 ms, including
+ *           interrupts that execute from flash, so only call this with
+ *           the motor off, between trials.
+ *  @param   l Learning state to store
+ *  @return  1 on success, 0 if erasing or programming failed, see
+ *           bspStoreWrite()
+ */
+uint8_t ilcSave(const ilc_t * l) {
+   static ilcFlash_t img;
+   uint16_t i;
+
+   img.magic = ILC_MAGIC;
+   img.len = ILC_LEN;
+   img.trials = l->trials;
+   img.lastErr = l->lastErr;
+   img.converged = l->converged;
+   for(i = 0; i < ILC_LEN; i++) {
+      img.ff[i] = l->ff[i];
+   }
+   img.check = ilcCheck(&img);
+   return bspStoreWrite(&img, sizeof(img));
+}
@@ -0,0 +1,41 @@
+#ifndef ILC_H
+#define ILC_H
+#include <stdint.h>
+
+/** @brief Samples in one trial **/
+#define ILC_LEN 256
+/** @brief Control ticks per trial sample **/
+#define ILC_DECIM 10
+/** @brief Learning gain, Q10 torque per unit of recorded error **/
+#define ILC_GAMMA 8
+/** @brief Samples the error is shifted back to account for the plant delay **/
+#define ILC_LEAD 1
+/** @brief Largest feedforward torque the profile may learn **/
+#define ILC_FF_MAX 600
+/** @brief Mean absolute trial error below which the profile is converged **/
+#define ILC_CONV_ERR 600
+/** @brief Trials after which learning stops even without convergence **/
+#define ILC_MAX_TRIALS 40
+
+/** @brief Iterative learning state: the feedforward profile and the trial
+ *  being recorded. Lives in RAM, ilcSave() copies the profile to flash.
+ */
+typedef struct {
+   int16_t ff[ILC_LEN];     /**< feedforward torque per sample */
+   int16_t err[ILC_LEN];    /**< error recorded in the current trial */
+   int8_t dir[ILC_LEN];     /**< sign of d(error)/d(torque) per sample */
+   uint16_t len;            /**< samples recorded in the current trial */
+   uint16_t trials;         /**< trials learned from so far */
+   uint32_t lastErr;        /**< mean absolute error of the last trial */
+   uint8_t converged;       /**< set once a trial was within ILC_CONV_ERR */
+} ilc_t;
+
+void ilcInit(ilc_t * l);
+void ilcTrialStart(ilc_t * l);
+int16_t ilcFeedforward(const ilc_t * l, uint16_t k);
+void ilcRecord(ilc_t * l, uint16_t k, int32_t err, int8_t dir);
+uint32_t ilcTrialEnd(ilc_t * l);
+uint8_t ilcLoad(ilc_t * l);
+uint8_t ilcSave(const ilc_t * l);
+
+#endif
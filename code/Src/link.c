@@ -0,0 +1,325 @@
+#include "link.h"
+#include "telemetry.h"
+#include "command.h"
+#include "ring.h"
+#include "clock.h"
+#include "cmsis_os.h"
+#include <string.h>
+
+/*
+ * USART1 link: receiving frames from the host, negotiating the baud rate
+ * (see proto.h for the handshake) and passing commands on to command.c.
+ * Runs in the telemetry task, which owns the transmit side.
+ *
+ * Receiving takes no interrupt per byte. DMA1 channel 5 writes into a
+ * circular buffer, and the bytes are picked up when the line goes idle
+ * after a burst (USART IDLE interrupt) or the buffer is half or all full
+ * (DMA interrupts), whichever comes first, so at most LINK_RX_LEN / 2
+ * bytes are handled per interrupt. Complete frames go into a ring for
+ * the task, each behind the clockUs() time it was picked up at, for
+ * CMD_PING; a frame that does not fit is dropped and the host, getting
+ * no reply, sends it again.
+ *
+ * Rates the board offers, fastest first. USART1 runs from PCLK2 = 72 MHz
+ * with 16x oversampling, so 4.5 Mbaud is the limit and all of these are
+ * exact or within 0.2 %; the host adapter decides how far down to go.
+ */
+static const uint32_t linkRates[] = {
+   4500000, 3000000, 2000000, 1500000, 1000000, 921600, 460800, 230400
+};
+
+static UART_HandleTypeDef * linkUart;
+static uint32_t baud;
+static uint32_t lastOffer;
+static uint32_t offerGap;
+
+/* written by DMA, rxTail is the next byte not looked at yet */
+static uint8_t rxDma[LINK_RX_LEN];
+static uint16_t rxTail;
+/* time and frame being collected, one more than fits marks it as broken */
+static uint8_t rxFrame[4 + LINK_FRAME_MAX];
+static uint16_t rxFill;
+/* time of the frame linkReceive() returned last */
+static uint32_t rxTime;
+/* complete frames, from the interrupts to the telemetry task */
+static uint32_t rxMem[(LINK_RX_FRAMES + 1) * RING_RECORD(sizeof(rxFrame)) / 4];
+static ring_t rxRing;
+
+
+//-------------------------------------------------------------------------------------
+/** @brief   Start receiving, call before the scheduler starts
+ *  @details The error interrupt stays off: the HAL would stop the
+ *           circular transfer on any framing or noise error, e.g. at a
+ *           baud change, and the CRC rejects such frames anyway.
+ *  @param   huart UART set up at PROTO_SAFE_BAUD, with an RX DMA channel
+ *           linked in circular mode
+ */
+void linkInit(UART_HandleTypeDef * huart) {
+   linkUart = huart;
+   baud = huart->Init.BaudRate;
+   lastOffer = 0;
+   offerGap = LINK_OFFER_MS;
+   rxTail = 0;
+   rxFill = 0;
+   ringInit(&rxRing, rxMem, sizeof(rxMem));
+   HAL_UART_Receive_DMA(huart, rxDma, LINK_RX_LEN);
+   huart->Instance->CR3 &= ~USART_CR3_EIE;
+   __HAL_UART_ENABLE_IT(huart, UART_IT_IDLE);
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Take one received byte
+ *  @details Interrupt context. Collects a frame up to its 0 and queues it
+ *           for linkReceive() with the time the 0 was handled.
+ *  @param   b Byte
+ */
+void linkRxByte(uint8_t b) {
+   uint32_t now;
+
+   if(b != 0) {
+      if(rxFill < LINK_FRAME_MAX) {
+         rxFrame[4 + rxFill++] = b;
+      } else {
+         rxFill = LINK_FRAME_MAX + 1;
+      }
+      return;
+   }
+   if(rxFill && rxFill <= LINK_FRAME_MAX) {
+      now = clockUs();
+      memcpy(rxFrame, &now, 4);
+      ringWrite(&rxRing, rxFrame, 4 + rxFill);
+   }
+   rxFill = 0;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Hand on what DMA received since the last call
+ *  @details Interrupt context, from the IDLE and the DMA half and full
+ *           interrupts, which share one priority and never nest.
+ */
+static void linkRxService(void) {
+   uint16_t head = LINK_RX_LEN - linkUart->hdmarx->Instance->CNDTR;
+
+   if(head == LINK_RX_LEN) {
+      head = 0;
+   }
+   while(rxTail != head) {
+      linkRxByte(rxDma[rxTail]);
+      if(++rxTail == LINK_RX_LEN) {
+         rxTail = 0;
+      }
+   }
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Idle line interrupt, call from USART1_IRQHandler() before the HAL
+ *  @details Reading SR then DR clears the flag.
+ */
+void linkIrq(void) {
+   if(linkUart->Instance->SR & USART_SR_IDLE) {
+      (void)linkUart->Instance->DR;
+      linkRxService();
+   }
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Receive buffer half full, from the DMA interrupt
+ *  @param   huart UART
+ */
+void HAL_UART_RxHalfCpltCallback(UART_HandleTypeDef * huart) {
+   if(huart == linkUart) {
+      linkRxService();
+   }
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Receive buffer full and wrapped, from the DMA interrupt
+ *  @param   huart UART
+ */
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef * huart) {
+   if(huart == linkUart) {
+      linkRxService();
+   }
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Next message from the host
+ *  @param   id Filled with the message id
+ *  @param   seq Filled with the frame counter
+ *  @param   body Filled with the body, room for PROTO_BODY_MAX bytes
+ *  @param   len Filled with the body bytes
+ *  @return  1 if a message with a good CRC was taken, 0 if none or corrupt
+ */
+uint8_t linkReceive(uint8_t * id, uint16_t * seq, uint8_t * body, uint16_t * len) {
+   uint8_t frame[sizeof(rxFrame)];
+   const void * p;
+   uint32_t size;
+   uint16_t n;
+
+   p = ringPeek(&rxRing, &size);
+   if(!p) {
+      return 0;
+   }
+   memcpy(frame, p, size);
+   ringRelease(&rxRing);
+   n = protoCobsDecode(frame + 4, size - 4);
+   if(!n || n - PROTO_OVERHEAD > PROTO_BODY_MAX || !protoParse(frame + 4, n, id, seq)) {
+      return 0;
+   }
+   memcpy(&rxTime, frame, 4);
+   *len = n - PROTO_OVERHEAD;
+   memcpy(body, frame + 7, *len);
+   return 1;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   When the message linkReceive() returned last came in
+ *  @details The time its frame's 0 was handled, a character time after it
+ *           arrived when the idle line interrupt picked it up.
+ *  @return  clockUs() time
+ */
+uint32_t linkRxTime(void) {
+   return rxTime;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Current baud rate
+ *  @return  Baud
+ */
+uint32_t linkBaud(void) {
+   return baud;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Switch the UART and the state record rate to another baud
+ *  @details Everything sent must be out, see telemDrain(). HAL_UART_Init()
+ *           on an initialized handle only rewrites the rate and framing;
+ *           the receive DMA and the IDLE interrupt keep running.
+ *  @param   rate Baud
+ */
+static void linkSetBaud(uint32_t rate) {
+   linkUart->Init.BaudRate = rate;
+   HAL_UART_Init(linkUart);
+   baud = rate;
+   telemSetBaud(rate);
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Whether a message is part of the link setup
+ *  @param   id Message id
+ *  @return  1 for LINK_OFFER to LINK_DOWN
+ */
+static uint8_t linkIsSetup(uint8_t id) {
+   return id >= PROTO_LINK_OFFER && id <= PROTO_LINK_DOWN;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Wait for a link setup message from the host
+ *  @details Commands arriving meanwhile are carried out as linkPoll()
+ *           would, other link setup messages are dropped.
+ *  @param   want Message id
+ *  @param   reply Filled with the body
+ *  @return  1 if it came within PROTO_LINK_TIMEOUT_MS
+ */
+static uint8_t linkWait(uint8_t want, protoLink_t * reply) {
+   uint8_t body[PROTO_BODY_MAX];
+   uint32_t start = osKernelSysTick();
+   uint16_t len, seq;
+   uint8_t id;
+
+   do {
+      while(linkReceive(&id, &seq, body, &len)) {
+         if(id == want && len == sizeof(protoLink_t)) {
+            memcpy(reply, body, sizeof(protoLink_t));
+            return 1;
+         }
+         if(!linkIsSetup(id)) {
+            cmdDispatch(id, seq, body, len);
+         }
+      }
+      osDelay(1);
+   } while(osKernelSysTick() - start < PROTO_LINK_TIMEOUT_MS);
+   return 0;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Offer the rates from the fastest down until one passes the test
+ *  @details Stops at the first offer nobody answers, the host is not
+ *           there. Records are not sent meanwhile; those that do not fit
+ *           the queue and the ring are dropped and counted.
+ *  @return  1 if the host answered the first offer, 0 if nobody did
+ */
+static uint8_t linkNegotiate(void) {
+   uint8_t test[sizeof(protoLink_t) + PROTO_LINK_PATTERN];
+   protoLink_t msg;
+   protoLink_t reply;
+   uint8_t i, k;
+
+   for(i = 0; i < sizeof(linkRates) / sizeof(linkRates[0]); i++) {
+      msg.baud = linkRates[i];
+      msg.n = 0;
+      telemSend(PROTO_LINK_OFFER, &msg, sizeof(msg));
+      telemDrain();
+      if(!linkWait(PROTO_LINK_ACCEPT, &reply)) {
+         return i > 0;
+      }
+      if(reply.baud != linkRates[i]) {
+         continue;
+      }
+
+      linkSetBaud(linkRates[i]);
+      osDelay(LINK_SETTLE_MS);
+      for(msg.n = 0; msg.n < PROTO_LINK_FRAMES; msg.n++) {
+         memcpy(test, &msg, sizeof(msg));
+         for(k = 0; k < PROTO_LINK_PATTERN; k++) {
+            test[sizeof(msg) + k] = PROTO_LINK_BYTE(msg.n, k);
+         }
+         telemSend(PROTO_LINK_TEST, test, sizeof(test));
+      }
+      telemDrain();
+      if(linkWait(PROTO_LINK_RESULT, &reply) && reply.baud == linkRates[i] &&
+         reply.n == PROTO_LINK_FRAMES) {
+         return 1;
+      }
+      linkSetBaud(PROTO_SAFE_BAUD);
+      osDelay(LINK_SETTLE_MS);
+   }
+   return 1;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Give the link a turn, from the telemetry task between rounds
+ *  @details Carries out up to LINK_CMDS_PER_POLL commands, so a flood of
+ *           them cannot hold up the telemetry, handles LINK_DOWN and,
+ *           while at the safe rate, offers a faster one every
+ *           LINK_OFFER_MS. Each offer nobody answers doubles the time to
+ *           the next, up to LINK_OFFER_MAX_MS, since every offer holds
+ *           the records back for PROTO_LINK_TIMEOUT_MS; an answer or a
+ *           LINK_DOWN brings it back to LINK_OFFER_MS.
+ */
+void linkPoll(void) {
+   uint8_t body[PROTO_BODY_MAX];
+   uint16_t len, seq;
+   uint8_t id, n;
+
+   for(n = 0; n < LINK_CMDS_PER_POLL && linkReceive(&id, &seq, body, &len); n++) {
+      if(id == PROTO_LINK_DOWN) {
+         offerGap = LINK_OFFER_MS;
+         if(baud != PROTO_SAFE_BAUD) {
+            telemDrain();
+            linkSetBaud(PROTO_SAFE_BAUD);
+            lastOffer = osKernelSysTick();
+         }
+      } else if(!linkIsSetup(id)) {
+         cmdDispatch(id, seq, body, len);
+      }
+   }
+   if(baud == PROTO_SAFE_BAUD && osKernelSysTick() - lastOffer >= offerGap) {
+      if(linkNegotiate()) {
+         offerGap = LINK_OFFER_MS;
+      } else if(offerGap < LINK_OFFER_MAX_MS) {
+         offerGap *= 2;
+      }
+      lastOffer = osKernelSysTick();
+   }
+}
@@ -0,0 +1,30 @@
+#ifndef LINK_H
+#define LINK_H
+#include <stdint.h>
+#include "stm32f1xx_hal.h"
+#include "proto.h"
+
+/** @brief Time between offers while no host answered, ms; it doubles
+    after each unanswered offer up to LINK_OFFER_MAX_MS **/
+#define LINK_OFFER_MS 1000
+#define LINK_OFFER_MAX_MS 16000
+/** @brief Pause after a baud change before sending, for the host to follow, ms **/
+#define LINK_SETTLE_MS 20
+/** @brief Circular receive buffer, bytes; half of it is the most handled per interrupt **/
+#define LINK_RX_LEN 128
+/** @brief Longest frame kept, without its 0 **/
+#define LINK_FRAME_MAX (PROTO_FRAME_MAX(PROTO_BODY_MAX) - 1)
+/** @brief Received frames waiting for the telemetry task **/
+#define LINK_RX_FRAMES 4
+/** @brief Most commands carried out per linkPoll() **/
+#define LINK_CMDS_PER_POLL 4
+
+void linkInit(UART_HandleTypeDef * huart);
+void linkIrq(void);
+void linkRxByte(uint8_t b);
+uint8_t linkReceive(uint8_t * id, uint16_t * seq, uint8_t * body, uint16_t * len);
+uint32_t linkRxTime(void);
+uint32_t linkBaud(void);
+void linkPoll(void);
+
+#endif
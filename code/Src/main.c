@@ -53,6 +53,20 @@
 
 /* USER CODE BEGIN Includes */
 #include "trig.h"
+#include "friction.h"
+#include "ident.h"
+#include "ilc.h"
+#include "control.h"
+#include "telemetry.h"
+#include "link.h"
+#include "capture.h"
+#include "chan.h"
+#include "clock.h"
+#include "fmt.h"
+#include "bsp.h"
+#include "motor.h"
+#include "rtstats.h"
+#include "seqlock.h"
 #include "math.h"
 /* USER CODE END Includes */
 
@@ -61,23 +75,36 @@ SPI_HandleTypeDef hspi1;
 
 TIM_HandleTypeDef htim2;
 TIM_HandleTypeDef htim3;
+TIM_HandleTypeDef htim4;
 
 UART_HandleTypeDef huart1;
+DMA_HandleTypeDef hdma_usart1_tx;
+DMA_HandleTypeDef hdma_usart1_rx;
 
 osThreadId defaultTaskHandle;
+uint32_t defaultTaskBuffer[ 192 ];
+osStaticThreadDef_t defaultTaskControlBlock;
 
 /* USER CODE BEGIN PV */
 /* Private variables ---------------------------------------------------------*/
+osThreadId telemTaskHandle;
+uint32_t telemTaskBuffer[ 192 ];
+osStaticThreadDef_t telemTaskControlBlock;
+osThreadId houseTaskHandle;
+uint32_t houseTaskBuffer[ 128 ];
+osStaticThreadDef_t houseTaskControlBlock;
 
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
 void SystemClock_Config(void);
 static void MX_GPIO_Init(void);
+static void MX_DMA_Init(void);
 static void MX_TIM3_Init(void);
 static void MX_SPI1_Init(void);
 static void MX_USART1_UART_Init(void);
 static void MX_TIM2_Init(void);
+static void MX_TIM4_Init(void);
 void StartDefaultTask(void const * argument);
                                     
 void HAL_TIM_MspPostInit(TIM_HandleTypeDef *htim);
@@ -85,11 +112,47 @@ void HAL_TIM_MspPostInit(TIM_HandleTypeDef *htim);
 
 /* USER CODE BEGIN PFP */
 /* Private function prototypes -----------------------------------------------*/
+void StartTelemetryTask(void const * argument);
+void StartHousekeepingTask(void const * argument);
 
 /* USER CODE END PFP */
 
 /* USER CODE BEGIN 0 */
 char * debug;
+
+/*
+ * Task layout
+ *
+ *   TIM4 update  NVIC priority 2                    control, every tick
+ *   USART1, DMA  NVIC priority 6                    telemetry sent, link bytes in
+ *   defaultTask  osPriorityRealtime     192 words  startup, then suspended
+ *   telemTask    osPriorityBelowNormal  192 words  packs and sends telemetry
+ *   houseTask    osPriorityLow          128 words  LED, identification, health
+ *
+ * controlTick() runs at priority 2, above
+ * configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY (5), so the kernel never
+ * delays it and it must not call FreeRTOS. Everything it shares is lock
+ * free (ring.h, seqlock.h, ctrlRequest()), and telemetry cannot hold it
+ * up (telemetry.c). All RTOS objects are static, there is no heap.
+ */
+
+/** @brief 1 sends the state every tick to prove telemetry cannot delay control **/
+#define TELEM_STRESS 0
+/** @brief Period of the health record, ms **/
+#define HEALTH_PERIOD_MS 1000
+
+/** @brief Control periods that started late **/
+volatile uint32_t ctrlOverruns;
+/** @brief Control interrupt timing of the last full second, see seqlock.h **/
+ctrlTiming_t ctrlTiming;
+volatile uint32_t ctrlTimingSeq;
+
+/** @brief Learned swing-up feedforward, loaded from and saved to flash **/
+ilc_t swingIlc;
+
+/** @brief State shared by the control laws, see control.h **/
+ctrlState_t ctrlState;
+
 /* USER CODE END 0 */
 
 /**
@@ -121,11 +184,19 @@ int main(void)
 
   /* Initialize all configured peripherals */
   MX_GPIO_Init();
+  MX_DMA_Init();
   MX_TIM3_Init();
   MX_SPI1_Init();
   MX_USART1_UART_Init();
   MX_TIM2_Init();
+  MX_TIM4_Init();
   /* USER CODE BEGIN 2 */
+  identInit();
+  clockInit();
+  captureInit();
+  chanInit();
+  telemInit(&huart1);
+  linkInit(&huart1);
 
   /* USER CODE END 2 */
 
@@ -143,11 +214,15 @@ int main(void)
 
   /* Create the thread(s) */
   /* definition and creation of defaultTask */
-  osThreadDef(defaultTask, StartDefaultTask, osPriorityNormal, 0, 128);
+  osThreadStaticDef(defaultTask, StartDefaultTask, osPriorityRealtime, 0, 192, defaultTaskBuffer, &defaultTaskControlBlock);
   defaultTaskHandle = osThreadCreate(osThread(defaultTask), NULL);
 
   /* USER CODE BEGIN RTOS_THREADS */
   /* add threads, ... */
+  osThreadStaticDef(telemTask, StartTelemetryTask, osPriorityBelowNormal, 0, 192, telemTaskBuffer, &telemTaskControlBlock);
+  telemTaskHandle = osThreadCreate(osThread(telemTask), NULL);
+  osThreadStaticDef(houseTask, StartHousekeepingTask, osPriorityLow, 0, 128, houseTaskBuffer, &houseTaskControlBlock);
+  houseTaskHandle = osThreadCreate(osThread(houseTask), NULL);
   /* USER CODE END RTOS_THREADS */
 
   /* USER CODE BEGIN RTOS_QUEUES */
@@ -352,12 +427,45 @@ static void MX_TIM3_Init(void)
 
 }
 
+/* TIM4 init function */
+static void MX_TIM4_Init(void)
+{
+
+  TIM_ClockConfigTypeDef sClockSourceConfig;
+  TIM_MasterConfigTypeDef sMasterConfig;
+
+  htim4.Instance = TIM4;
+  htim4.Init.Prescaler = 1;
+  htim4.Init.CounterMode = TIM_COUNTERMODE_UP;
+  htim4.Init.Period = 72000/2 - 1;
+  htim4.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+  htim4.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+  if (HAL_TIM_Base_Init(&htim4) != HAL_OK)
+  {
+    _Error_Handler(__FILE__, __LINE__);
+  }
+
+  sClockSourceConfig.ClockSource = TIM_CLOCKSOURCE_INTERNAL;
+  if (HAL_TIM_ConfigClockSource(&htim4, &sClockSourceConfig) != HAL_OK)
+  {
+    _Error_Handler(__FILE__, __LINE__);
+  }
+
+  sMasterConfig.MasterOutputTrigger = TIM_TRGO_RESET;
+  sMasterConfig.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
+  if (HAL_TIMEx_MasterConfigSynchronization(&htim4, &sMasterConfig) != HAL_OK)
+  {
+    _Error_Handler(__FILE__, __LINE__);
+  }
+
+}
+
 /* USART1 init function */
 static void MX_USART1_UART_Init(void)
 {
 
   huart1.Instance = USART1;
-  huart1.Init.BaudRate = 115200;
+  huart1.Init.BaudRate = PROTO_SAFE_BAUD;
   huart1.Init.WordLength = UART_WORDLENGTH_8B;
   huart1.Init.StopBits = UART_STOPBITS_1;
   huart1.Init.Parity = UART_PARITY_NONE;
@@ -371,6 +479,24 @@ static void MX_USART1_UART_Init(void)
 
 }
 
+/** 
+  * Enable DMA controller clock
+  */
+static void MX_DMA_Init(void) 
+{
+  /* DMA controller clock enable */
+  __HAL_RCC_DMA1_CLK_ENABLE();
+
+  /* DMA interrupt init */
+  /* DMA1_Channel4_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA1_Channel4_IRQn, 6, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel4_IRQn);
+  /* DMA1_Channel5_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA1_Channel5_IRQn, 6, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel5_IRQn);
+
+}
+
 /** Configure pins as 
         * Analog 
         * Input 
@@ -411,155 +537,188 @@ static void MX_GPIO_Init(void)
 /* USER CODE BEGIN 4 */
 
 //-------------------------------------------------------------------------------------
-/** @brief    Set PWM duty cycle for a, b, and c outputs (12 bit inputs)
- *  @details  This function is used to set the duty cycle for each of the
- *            3 pwm output waveforms by setting the timer compare register.
- *            It assumes a 12 bit input, thus bit shift..
- *          
- *  @param   a The 12 bit duty cycle for tim2 channel 1 output
- *  @param   b The 12 bit duty cycle for tim2 channel 1 output
- *  @param   c The 12 bit duty cycle for tim2 channel 1 output
+/** @brief   One control period, runs in the TIM4 update interrupt
+ *  @details Senses, steps the active law, drives the motor, logs for the
+ *           identification and telemetry and publishes the state. No
+ *           FreeRTOS calls allowed here, see the task layout at the top.
+ *           Timing is collected over CTRL_HZ ticks and then published in
+ *           ctrlTiming.
+ *  @param   latency Core cycles from the timer update to the handler
  */
-
-inline void pwmOut( uint16_t a, uint16_t b, uint16_t c) {
-   /* for some reason, the polarity must be low for the numbers
-      to make sense (i.e. bigger == longer high pulse) */
-   __HAL_TIM_SET_COMPARE(&htim2, TIM_CHANNEL_1, a << 3 ); 
-   __HAL_TIM_SET_COMPARE(&htim2, TIM_CHANNEL_2, b << 3 );
-   __HAL_TIM_SET_COMPARE(&htim2, TIM_CHANNEL_3, c << 3 );
+static void controlTick(uint32_t latency) {
+   static ctrlTiming_t window;
+   static uint16_t ticks;
+   static uint16_t telemTicks;
+   static uint32_t lastBusy;
+   uint32_t start = rtstatsCycles();
+   uint32_t busy;
+   telemRecord_t * rec;
+
+   ctrlState.time = clockUpdate();
+   ctrlSense(&ctrlState, bspArmCapture(), pendAngle());
+   setMotorTorque(ctrlStep(&ctrlState));
+   identLog(ctrlState.arm, ctrlState.pend, ctrlState.lastOut);
+   captureSample(&ctrlState);
+   chanSample(&ctrlState, latency, lastBusy, ctrlOverruns);
+   ctrlPublish(&ctrlState);
+
+   if(++telemTicks >= (TELEM_STRESS ? 1 : telemDecim())) {
+      telemTicks = 0;
+      rec = telemReserve();
+      if(rec) {
+         rec->type = TELEM_STATE;
+         rec->law = ctrlActive();
+         rec->torque = ctrlState.lastOut;
+         rec->time = ctrlState.time;
+         rec->v[0] = ctrlState.arm;
+         rec->v[1] = ctrlState.pend;
+         rec->v[2] = ctrlState.pendRate;
+         rec->v[3] = ctrlOverruns;
+         telemCommit();
+      }
+   }
+
+   /* the next update has already happened: this period ran too long */
+   if(__HAL_TIM_GET_FLAG(&htim4, TIM_FLAG_UPDATE)) {
+      ctrlOverruns++;
+   }
+
+   busy = rtstatsCycles() - start;
+   lastBusy = busy;
+   if(latency > window.latencyMax) {
+      window.latencyMax = latency;
+   }
+   if(busy > window.busyMax) {
+      window.busyMax = busy;
+   }
+   window.latencySum += latency;
+   window.busySum += busy;
+   if(++ticks >= CTRL_HZ) {
+      seqWriteBegin(&ctrlTimingSeq);
+      ctrlTiming = window;
+      seqWriteEnd(&ctrlTimingSeq);
+      window.latencyMax = window.latencySum = 0;
+      window.busyMax = window.busySum = 0;
+      ticks = 0;
+   }
 }
 
-
-
 //-------------------------------------------------------------------------------------
-/** @brief   When called, update the PWM output to keep specified torque (12 bit)
- *  @details This function uses the encoder to calculate the correct phase
- *           to output via PWM to generate a field 90 degrees to the current
- *           location. Then this value is scaled by the ratio of torque/1000
- *  @param   torque Controls how much 'torque' is applied from -1000 to 1000
+/** @brief   Timer update callback, TIM4 runs the control loop
+ *  @details Reading TIM4->CNT first gives the latency: the counter
+ *           restarted at 0 with the update event and counts at half the
+ *           core clock.
+ *  @param   htim Timer that overflowed
  */
-void setMotorTorque( int16_t torque) {
-   uint16_t theta;
-   int16_t offset = -1195 - 150; //65536/28;//-1146;
-   
-   theta = ( (4095 * 7 * htim3.Instance->CCR2 / 65535) + offset ) % 4096;n
-   pwmOut( torque * sinShift03(theta)/1000 + (torque<0 ? 4096: 0),
-	   torque * sinShift13(theta)/1000 + (torque<0 ? 4096: 0),
-	   torque * sinShift23(theta)/1000 + (torque<0 ? 4096: 0));
-      
-   /* At theta = 0, pulse =
-      64389 <-- ~zero  (0-1146)
-      54784
-      45064
-      35581
-      26081
-      16398
-      6892
-
-      1/7th of 2^16-1 ~= 9362
-      1/7th / 4 (to get 90 degrees ahead) ~= 2341
-      2341 - 1146 = 1195  <-- this is ~90 degrees to zero (maybe?)
-
-   */
-
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
+{
+   if(htim->Instance == TIM4) {
+      uint32_t latency = htim->Instance->CNT * (htim->Init.Prescaler + 1);
+      controlTick(latency);
+   }
 }
 
-
-//define addresses (lowest if multiple bytes) (lowest byte in higest addr)
-
-
-/** @brief 2 bytes Extended Write Address **/
-#define EWA 0x02
-/** @brief 4 bytes Extended Write Data **/
-#define EWD 0x04 //
-/** @brief 2 bytes Extended Write Control and Status **/
-#define EWCS 0x08 //
-/** @brief 2 bytes Extended Read Address **/
-#define ERA 0x0A //
-/** @brief 2 bytes Extended Read Control and Status **/
-#define ERCS 0x0C //
-/** @brief 4 bytes Extended Read Data **/
-#define ERD 0x0E //
-
-/** @brief Address of the control register  **/
-#define CTRL 0x1E //2 bytes 
-/** @brief address of the Angle register**/
-#define ANG 0x20 //2 bytes 
-/** @brief address of the status register**/
-#define STA 0x22 //2 bytes 
-/** @brief address of the field strength register**/
-#define FIELD 0x2A //2 bytes 
-/** @brief key needed to start running spi encoder**/
-#define CDS_KEYCODE 0x46 
-
-
-
 //-------------------------------------------------------------------------------------
-/** @brief   Writes val to the addr via SPI
- *  @details This function sets SS pin low, transmits the 16 bits
- *           (0x4000 | addr << 8 | val) and then releases SS pin.
- *           it returns the data recieved via spi.
- *  @param   addr The address to write to
- *  @param   val The value to put in the address
- *  @return   The data recieved via spi
+/** @brief   Telemetry task, see telemRun()
+ *  @param   argument Not used, but kept for rtos
  */
-uint16_t spiWrite(uint8_t addr, uint8_t val) {
-   uint16_t num = 0x4000 | addr << 8 | val;
-   uint16_t rxData;
-   HAL_GPIO_WritePin(GPIOA, GPIO_PIN_15, GPIO_PIN_RESET);
-   HAL_SPI_TransmitReceive(&hspi1, & num, &rxData, 1, 0xFF);
-   HAL_GPIO_WritePin(GPIOA, GPIO_PIN_15, GPIO_PIN_SET);
-   return rxData;
+void StartTelemetryTask(void const * argument)
+{
+   telemRun();
 }
 
 //-------------------------------------------------------------------------------------
-/** @brief   Reads the value at the given address
- *  @details Transmits the address to read, then transmits again to
- *           get the response. This function then returns the value
- *           recieved via spi
- *  @param   addr The address to read from the spi encoder
- *  @return   The value at the given address
+/** @brief   Low priority housekeeping: LED, online identification, health
+ *  @details The control loop only logs decimated samples with identLog();
+ *           the recursive least squares updates run here whenever nothing
+ *           else wants the CPU. The log holds IDENT_LOG_LEN samples, so
+ *           this task has to run at least every IDENT_LOG_LEN * IDENT_DECIM
+ *           ticks; samples logged while it is starved are dropped and
+ *           counted by identOverruns(). The pendulum's w0^2 goes to
+ *           ctrlParams.w0sq as soon as it is valid, identGetParams() has
+ *           the rest. A profile the learning law learned is stored
+ *           here once the motor is off. Once a second the LED toggles
+ *           and the run time stats go out as TELEM_TASK, TELEM_TIMING and
+ *           TELEM_HEALTH records.
+ *  @param   argument Not used, but kept for rtos
  */
-uint16_t spiRead(uint8_t addr) {
-   uint16_t num = addr << 8;
-   uint16_t pRxData;
-   HAL_GPIO_WritePin(GPIOA, GPIO_PIN_15, GPIO_PIN_RESET);
-   HAL_SPI_TransmitReceive(&hspi1, & num, &pRxData, 1, 0xFF);
-   HAL_GPIO_WritePin(GPIOA, GPIO_PIN_15, GPIO_PIN_SET);
-
-   num = 0;
-   HAL_GPIO_WritePin(GPIOA, GPIO_PIN_15, GPIO_PIN_RESET);
-   HAL_SPI_TransmitReceive(&hspi1, & num, &pRxData, 1, 0xFF);
-   HAL_GPIO_WritePin(GPIOA, GPIO_PIN_15, GPIO_PIN_SET);
-   return pRxData;
-}
+void StartHousekeepingTask(void const * argument)
+{
+   GPIO_InitTypeDef GPIO_InitStructure;
+   telemRecord_t rec;
+   rtstatsTask_t tasks[RTSTATS_MAX_TASKS];
+   ctrlTiming_t timing;
+   identParams_t id;
+   uint32_t seq, isr;
+   uint16_t idle;
+   uint8_t n, i;
+   uint32_t lastHealth = osKernelSysTick();
+   uint16_t saved = 0;
 
+   GPIO_InitStructure.Pin = GPIO_PIN_12;
+   GPIO_InitStructure.Mode = GPIO_MODE_OUTPUT_PP;
+   GPIO_InitStructure.Speed = GPIO_SPEED_FREQ_HIGH;
+   HAL_GPIO_Init(GPIOB, &GPIO_InitStructure);
 
-//-------------------------------------------------------------------------------------
-/** @brief   Calculate the torque to return motor to setpoint (using simple P controller)
- *  @details This functions returns the torque calculated by a simple P controller
- *           that attempts to keep a constant setpoint. The output is not linear with
- *           positon, but instead has an adjustment to increase low end values to make
- *           sure the motor has enough torque at the low end to reach the target.
- *  @param   setpoint The position that the motor tries to maintain (16 bit number)
- *  @return  The new torque value that should be sent to the motor from -1000 to 1000
- */
-int16_t getNewTorque(int16_t setpoint){
-   int32_t out = (htim3.Instance->CCR2 -setpoint +65536/2) % 65536 -65536/2;
-   out = out >> 4;		/* bit shift to get scalling right */
-
-   /* Adjusting the respones of our motor so that there is more torque on the low end*/
-   out = 32*sqrt(abs(out)) * out /abs(out) ;
-
-   /* constrain output to valid numbers */
-    if(out>1000){
-        out = 1000;
-    } 
-    if(out<-1000){
-        out = -1000;
-    }
-
-    return out;
+   for(;;) {
+      /* the swing-up uses the identified pendulum once there is one */
+      if(identProcess()) {
+         identGetParams(&id);
+         if(id.valid) {
+            ctrlParams.w0sq = id.pendW0Sq;
+         }
+      }
+
+      /* store what the learning law learned once the motor is off */
+      if(ctrlLearnedTrials() != saved && ctrlActive() == CTRL_OFF) {
+         saved = ctrlLearnedTrials();
+         ilcSave(&swingIlc);
+      }
+
+      if(osKernelSysTick() - lastHealth >= HEALTH_PERIOD_MS) {
+         lastHealth += HEALTH_PERIOD_MS;
+         HAL_GPIO_TogglePin(GPIOB, GPIO_PIN_12);
+
+         n = rtstatsSample(tasks, RTSTATS_MAX_TASKS, &idle);
+         rec.time = clockUs();
+         for(i = 0; i < n; i++) {
+            rec.type = TELEM_TASK;
+            rec.law = tasks[i].number;
+            rec.torque = tasks[i].cpu;
+            rec.v[0] = tasks[i].stackFree;
+            rec.v[1] = tasks[i].cycles;
+            rec.v[2] = tasks[i].idle;
+            rec.v[3] = 0;
+            telemPost(&rec);
+         }
+
+         do {
+            seq = seqReadBegin(&ctrlTimingSeq);
+            timing = ctrlTiming;
+         } while(seqReadRetry(&ctrlTimingSeq, seq));
+         rec.type = TELEM_TIMING;
+         rec.law = ctrlActive();
+         rec.torque = 0;
+         rec.v[0] = timing.latencyMax;
+         rec.v[1] = timing.latencySum / CTRL_HZ;
+         rec.v[2] = timing.busyMax;
+         rec.v[3] = ctrlOverruns;
+         telemPost(&rec);
+
+         /* interrupt share of the last second, 1/1000 */
+         isr = timing.busySum / (SystemCoreClock / 1000);
+         if(isr > idle) {
+            isr = idle;
+         }
+         rec.type = TELEM_HEALTH;
+         rec.v[0] = 1000 - idle + isr;
+         rec.v[1] = idle - isr;
+         rec.v[2] = isr;
+         rec.v[3] = telemDrops();
+         telemPost(&rec);
+      }
+      osDelay(IDENT_LOG_LEN * IDENT_DECIM / 4);
+   }
 }
 
 /* USER CODE END 4 */
@@ -567,11 +726,12 @@ int16_t getNewTorque(int16_t setpoint){
 
 
 //-------------------------------------------------------------------------------------
-/** @brief   Task that sets up the pins, timers, etc. and run basic constant torque example
- *  @details This task configures the gpio to blink an led, enables interrupts for
- *           pwm input, starts the 3 pwm output channels, configures the spi encoder.
- *           Then, this task loops, blinking the led, updating torque, and printing
- *           the current angle of the motor via uart.
+/** @brief   Control task: sets up the timers, etc. and starts the control loop
+ *  @details This task starts the pwm input capture and the 3 pwm output
+ *           channels, configures the spi encoder and loads the friction
+ *           model and the swing-up profile. Then it starts TIM4, whose interrupt runs the active control law from
+ *           the registry in control.h every tick, which also sends the
+ *           state, and suspends itself. See the task layout at the top.
  *  @param   argument Not used, but kept for rtos
  */
 void StartDefaultTask(void const * argument)
@@ -579,97 +739,31 @@ void StartDefaultTask(void const * argument)
 
   /* USER CODE BEGIN 5 */
 
-   GPIO_InitTypeDef GPIO_InitStructure;
- 
-   GPIO_InitStructure.Pin = GPIO_PIN_12;
- 
-   GPIO_InitStructure.Mode = GPIO_MODE_OUTPUT_PP;
-   GPIO_InitStructure.Speed = GPIO_SPEED_FREQ_HIGH;
-   //GPIO_InitStructure.Pull = GPIO_NOPULL;
-   HAL_GPIO_Init(GPIOB, &GPIO_InitStructure);
-
    debug = "none";
 
-   //Enable interrupt
-   HAL_TIM_IC_Start_IT(&htim3, TIM_CHANNEL_2);
-   HAL_TIM_IC_Start(&htim3, TIM_CHANNEL_1);
+   bspInit();
 
-   
-   HAL_TIM_PWM_Start(&htim2, TIM_CHANNEL_1); 
-   HAL_TIM_PWM_Start(&htim2, TIM_CHANNEL_2);
-   HAL_TIM_PWM_Start(&htim2, TIM_CHANNEL_3);
-
-   setMotorTorque(0);
-   HAL_GPIO_WritePin(GPIOB, GPIO_PIN_12, GPIO_PIN_SET);
-   osDelay(100);
-   
-   spiWrite(CTRL, 0xC0);
-   spiWrite(CTRL, 0xC0);
-   spiWrite(CTRL+1, CDS_KEYCODE);
-   spiRead(ANG);
+   /* nominal friction; CMD_MODE CTRL_FRICTION identifies the rig's */
+   frictionInit();
+   /* stored swing-up profile; CMD_MODE CTRL_LEARN learns it */
+   ilcInit(&swingIlc);
 
+   /* constant torque demo; switch laws at runtime with ctrlRequest() */
+   ctrlParams.openLoop = 1000;
+   ctrlParams.ilc = &swingIlc;
+   ctrlInit(&ctrlState, CTRL_OPEN_LOOP, bspArmCapture(), pendAngle());
+   ctrlPublish(&ctrlState);
+   clockHandOver();
+   HAL_TIM_Base_Start_IT(&htim4);
    
-   uint32_t count=0;
-   uint32_t loop=0;
   /* Infinite loop */
   for(;;)
   {
-     /* if(count % 50 == 0) { */
-     /* 	osDelay(1); */
-     /* } */
-    if ( count == 2000) {
-       HAL_GPIO_WritePin(GPIOB, GPIO_PIN_12, GPIO_PIN_SET);
-    }
-    if (count == 4095) {
-       HAL_GPIO_WritePin(GPIOB, GPIO_PIN_12, GPIO_PIN_RESET);
-       count=0;
-
-       /* loop++; */
-
-       /* if(loop == 300) { */
-       /* 	  setMotorTorque( -250); */
-       /* } */
-       /* if(loop == 600) { */
-       /* 	  setMotorTorque( 250); */
-       /* 	  loop=0; */
-       // }       
-       char buffer[100];
-       sprintf(buffer, "Angle: %d\n", spiRead(ANG));
-       HAL_UART_Transmit(&huart1, buffer ,strlen(buffer) , HAL_MAX_DELAY);
-
-    }
-    count++;
-    
-
-    /* setMotorTorque(getNewTorque(10000)); */
-    setMotorTorque(1000);
-
-
-    
+    osThreadSuspend(NULL);
   }
   /* USER CODE END 5 */ 
 }
 
-/**
-  * @brief  Period elapsed callback in non blocking mode
-  * @note   This function is called  when TIM4 interrupt took place, inside
-  * HAL_TIM_IRQHandler(). It makes a direct call to HAL_IncTick() to increment
-  * a global variable "uwTick" used as application time base.
-  * @param  htim : TIM handle
-  * @retval None
-  */
-void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
-{
-  /* USER CODE BEGIN Callback 0 */
-  /* USER CODE END Callback 0 */
-  if (htim->Instance == TIM4) {
-    HAL_IncTick();
-  }
-  /* USER CODE BEGIN Callback 1 */
-
-  /* USER CODE END Callback 1 */
-}
-
 /**
   * @brief  This function is executed in case of error occurrence.
   * @param  file: The file name as string.
@@ -679,7 +773,16 @@ void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
 void _Error_Handler(char *file, int line)
 {
   /* USER CODE BEGIN Error_Handler_Debug */
-  /* User can add his own implementation to report the HAL error return state */
+  /* report where on the link, then stop */
+  char text[PROTO_BODY_MAX];
+  fmt_t f;
+
+  fmtStart(&f, text, sizeof(text));
+  fmtStr(&f, "error ");
+  fmtStr(&f, file);
+  fmtStr(&f, ":");
+  fmtInt(&f, line);
+  telemPanic(text, f.len);
   while(1)
   {
   }
@@ -697,8 +800,8 @@ void _Error_Handler(char *file, int line)
 void assert_failed(uint8_t* file, uint32_t line)
 { 
   /* USER CODE BEGIN 6 */
-  /* User can add his own implementation to report the file name and line number,
-     tex: printf("Wrong parameters value: file %s on line %d\r\n", file, line) */
+  /* a wrong HAL argument is as fatal as a HAL error */
+  _Error_Handler((char *)file, line);
   /* USER CODE END 6 */
 }
 #endif /* USE_FULL_ASSERT */
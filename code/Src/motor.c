@@ -0,0 +1,64 @@
+#include "motor.h"
+#include "bsp.h"
+#include "trig.h"
+
+/*
+ * Arm motor commutation and the pendulum angle, on top of bsp.h so the
+ * control loop runs the same on the board and on the host.
+ */
+
+
+//-------------------------------------------------------------------------------------
+/** @brief   Phase the field has to be at for torque, 90 degrees ahead of
+ *           the rotor
+ *  @details 7 pole pairs, so 7 electrical turns per capture turn.
+ *  @param   capture Arm capture count
+ *  @return  Electrical angle, THETA_MAX per turn
+ */
+uint16_t motorTheta(uint16_t capture) {
+   int16_t offset = -1195 - 150; //65536/28;//-1146;
+
+   /* unsigned like the CCR2 register this was written for, so a negative
+      sum wraps modulo 4096 */
+   return ( (4095 * 7 * (uint32_t)capture / 65535) + offset ) % 4096;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   When called, update the PWM output to keep specified torque (12 bit)
+ *  @details This function uses the encoder to calculate the correct phase
+ *           to output via PWM to generate a field 90 degrees to the current
+ *           location. Then this value is scaled by the ratio of torque/1000
+ *  @param   torque Controls how much 'torque' is applied from -1000 to 1000
+ */
+void setMotorTorque( int16_t torque) {
+   uint16_t theta;
+   
+   theta = motorTheta(bspArmCapture());
+   bspPwm( torque * sinShift03(theta)/1000 + (torque<0 ? 4096: 0),
+	   torque * sinShift13(theta)/1000 + (torque<0 ? 4096: 0),
+	   torque * sinShift23(theta)/1000 + (torque<0 ? 4096: 0));
+      
+   /* At theta = 0, pulse =
+      64389 <-- ~zero  (0-1146)
+      54784
+      45064
+      35581
+      26081
+      16398
+      6892
+
+      1/7th of 2^16-1 ~= 9362
+      1/7th / 4 (to get 90 degrees ahead) ~= 2341
+      2341 - 1146 = 1195  <-- this is ~90 degrees to zero (maybe?)
+
+   */
+
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Reads the pendulum angle
+ *  @return  The pendulum angle, 65536 per rev, 0 with the pendulum hanging down
+ */
+uint16_t pendAngle(void) {
+   return bspPendEncoder() - PEND_DOWN;
+}
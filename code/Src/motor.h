@@ -0,0 +1,12 @@
+#ifndef MOTOR_H
+#define MOTOR_H
+#include <stdint.h>
+
+/** @brief Pendulum encoder reading with the pendulum hanging at rest **/
+#define PEND_DOWN 0
+
+uint16_t motorTheta(uint16_t capture);
+void setMotorTorque(int16_t torque);
+uint16_t pendAngle(void);
+
+#endif
@@ -0,0 +1,213 @@
+#include "proto.h"
+#include <string.h>
+
+/** @brief CRC-16/CCITT-FALSE start value **/
+#define CRC_INIT 0xFFFF
+
+/** @brief The channel registry, indexed by protoChanId_t **/
+const protoChanInfo_t protoChans[PROTO_CHAN_COUNT] = {
+   [PROTO_CHAN_PEND] = { "pend", 2, 0 },
+   [PROTO_CHAN_ARM] = { "arm", 4, 1 },
+   [PROTO_CHAN_PEND_RATE] = { "pendRate", 4, 1 },
+   [PROTO_CHAN_ARM_RATE] = { "armRate", 4, 1 },
+   [PROTO_CHAN_TORQUE] = { "torque", 2, 1 },
+   [PROTO_CHAN_ARM_REF] = { "armRef", 4, 1 },
+   [PROTO_CHAN_LAW] = { "law", 1, 0 },
+   [PROTO_CHAN_PWM_A] = { "pwmA", 2, 0 },
+   [PROTO_CHAN_PWM_B] = { "pwmB", 2, 0 },
+   [PROTO_CHAN_PWM_C] = { "pwmC", 2, 0 },
+   [PROTO_CHAN_LATENCY] = { "latency", 4, 0 },
+   [PROTO_CHAN_BUSY] = { "busy", 4, 0 },
+   [PROTO_CHAN_OVERRUNS] = { "overruns", 4, 0 },
+   [PROTO_CHAN_DROPS] = { "drops", 4, 0 }
+};
+
+/* CRC-16/CCITT (0x1021) of each nibble; 32 bytes of flash instead of 512 */
+static const uint16_t crcNibble[16] = {
+   0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+   0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+
+//-------------------------------------------------------------------------------------
+/** @brief   Continue a CRC-16/CCITT-FALSE
+ *  @param   crc 0xFFFF to start, or the value returned for the previous data
+ *  @param   data Bytes
+ *  @param   len Number of bytes
+ *  @return  CRC including data; 0x29B1 for "123456789"
+ */
+uint16_t protoCrc16(uint16_t crc, const uint8_t * data, uint16_t len) {
+   while(len--) {
+      uint8_t b = *data++;
+      crc = (crc << 4) ^ crcNibble[(crc >> 12) ^ (b >> 4)];
+      crc = (crc << 4) ^ crcNibble[(crc >> 12) ^ (b & 0x0F)];
+   }
+   return crc;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   COBS encode a packet and terminate it with 0
+ *  @param   in Packet
+ *  @param   len Packet bytes
+ *  @param   out Frame, room for len + len / 254 + 2 bytes
+ *  @return  Frame bytes including the 0
+ */
+uint16_t protoCobsEncode(const uint8_t * in, uint16_t len, uint8_t * out) {
+   uint16_t code = 0;
+   uint16_t o = 1;
+   uint8_t run = 1;
+   uint16_t i;
+
+   for(i = 0; i < len; i++) {
+      if(in[i] == 0) {
+         out[code] = run;
+         code = o++;
+         run = 1;
+      } else {
+         out[o++] = in[i];
+         if(++run == 0xFF) {
+            out[code] = run;
+            code = o++;
+            run = 1;
+         }
+      }
+   }
+   out[code] = run;
+   out[o++] = 0;
+   return o;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   COBS decode a frame in place
+ *  @param   buf Frame without the terminating 0, replaced by the packet
+ *  @param   len Frame bytes
+ *  @return  Packet bytes, 0 if the frame is malformed
+ */
+uint16_t protoCobsDecode(uint8_t * buf, uint16_t len) {
+   uint16_t i = 0;
+   uint16_t o = 0;
+
+   while(i < len) {
+      uint8_t code = buf[i++];
+      uint8_t n;
+      if(code == 0 || i + code - 1 > len) {
+         return 0;
+      }
+      for(n = 1; n < code; n++) {
+         buf[o++] = buf[i++];
+      }
+      if(code != 0xFF && i < len) {
+         buf[o++] = 0;
+      }
+   }
+   return o;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Build a complete frame
+ *  @param   id Message id
+ *  @param   seq Frame counter
+ *  @param   body Body, little endian
+ *  @param   len Body bytes, at most PROTO_BODY_MAX
+ *  @param   out Frame, room for PROTO_FRAME_MAX(len) bytes
+ *  @return  Frame bytes, 0 if the body is too long
+ */
+uint16_t protoFrame(uint8_t id, uint16_t seq, const void * body, uint16_t len, uint8_t * out) {
+   uint8_t packet[PROTO_BODY_MAX + PROTO_OVERHEAD];
+   uint16_t crc;
+
+   if(len > PROTO_BODY_MAX) {
+      return 0;
+   }
+   packet[0] = id;
+   packet[1] = seq & 0xFF;
+   packet[2] = seq >> 8;
+   memcpy(packet + 3, body, len);
+   crc = protoCrc16(CRC_INIT, packet, len + 3);
+   packet[len + 3] = crc & 0xFF;
+   packet[len + 4] = crc >> 8;
+   return protoCobsEncode(packet, len + PROTO_OVERHEAD, out);
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Check a decoded packet and read its header
+ *  @details The body starts at packet + 3 and has len - PROTO_OVERHEAD bytes.
+ *  @param   packet Packet from protoCobsDecode()
+ *  @param   len Packet bytes
+ *  @param   id Filled with the message id
+ *  @param   seq Filled with the frame counter
+ *  @return  1 if the packet is complete and its CRC matches
+ */
+uint8_t protoParse(const uint8_t * packet, uint16_t len, uint8_t * id, uint16_t * seq) {
+   uint16_t crc;
+
+   if(len < PROTO_OVERHEAD) {
+      return 0;
+   }
+   crc = packet[len - 2] | packet[len - 1] << 8;
+   if(protoCrc16(CRC_INIT, packet, len - 2) != crc) {
+      return 0;
+   }
+   *id = packet[0];
+   *seq = packet[1] | packet[2] << 8;
+   return 1;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Start delta coding from a keyframe
+ *  @param   d Coder state
+ *  @param   key Record sent in full
+ */
+void protoDeltaKey(protoDelta_t * d, const protoRecord_t * key) {
+   d->last = *key;
+   d->step = 0;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Append a zigzag varint
+ *  @param   x Value
+ *  @param   out Room for 5 bytes
+ *  @return  Bytes written
+ */
+static uint16_t protoVarint(int32_t x, uint8_t * out) {
+   uint32_t v = ((uint32_t)x << 1) ^ (uint32_t)(x >> 31);
+   uint16_t n = 0;
+
+   while(v >= 0x80) {
+      out[n++] = v | 0x80;
+      v >>= 7;
+   }
+   out[n++] = v;
+   return n;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Code a state record against the previous one
+ *  @details Differences wrap like the fields, so any record can be coded.
+ *  @param   d Coder state, advanced to r
+ *  @param   r Record
+ *  @param   out Room for PROTO_DELTA_MAX bytes
+ *  @return  Bytes written, 1 if nothing changed but the time at its step
+ */
+uint16_t protoDeltaEncode(protoDelta_t * d, const protoRecord_t * r, uint8_t * out) {
+   int32_t diff[PROTO_DELTA_FIELDS];
+   uint16_t n = 1;
+   uint8_t i;
+
+   diff[0] = (int8_t)(r->law - d->last.law);
+   diff[1] = r->torque - d->last.torque;
+   diff[2] = r->time - d->last.time - d->step;
+   for(i = 0; i < 4; i++) {
+      diff[3 + i] = (uint32_t)r->v[i] - (uint32_t)d->last.v[i];
+   }
+   out[0] = 0;
+   for(i = 0; i < PROTO_DELTA_FIELDS; i++) {
+      if(diff[i]) {
+         out[0] |= 1 << i;
+         n += protoVarint(diff[i], out + n);
+      }
+   }
+   d->step = r->time - d->last.time;
+   d->last = *r;
+   return n;
+}
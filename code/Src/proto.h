@@ -0,0 +1,329 @@
+#ifndef PROTO_H
+#define PROTO_H
+#include <stdint.h>
+
+/*
+ * Wire format of everything sent over USART1, shared by the firmware and
+ * the host decoder (host/telemdec.hpp).
+ *
+ * A frame is a COBS encoded packet followed by a 0 byte. COBS removes all
+ * zeros from the packet, so after any error a receiver is back in sync at
+ * the next 0. The packet is
+ *
+ *    id     1 byte   protoId_t, says how to read the body
+ *    seq    2 bytes  frame counter, +1 per frame sent
+ *    body   n bytes  little endian, layout given by id
+ *    crc    2 bytes  CRC-16/CCITT-FALSE over id, seq and body
+ *
+ * all little endian. A gap in seq means frames were lost on the link;
+ * records the firmware could not even queue are counted in the health
+ * record.
+ *
+ * Link setup. The board starts at PROTO_SAFE_BAUD and, until a host
+ * answers, offers its fastest rate once a second, backing off to once in
+ * 16 s while nobody answers; LINK_DOWN at the safe rate brings it back to
+ * once a second:
+ *
+ *    board                              host
+ *    LINK_OFFER {baud}           ->
+ *                                <-     LINK_ACCEPT {baud, or 0 to refuse}
+ *    both switch to baud
+ *    PROTO_LINK_FRAMES x LINK_TEST ->   counts the good ones
+ *                                <-     LINK_RESULT {baud, good frames}
+ *
+ * If the host refuses, or the result is missing or short, both go back to
+ * the safe rate and the board offers its next lower rate. A host that
+ * sees no good frame for PROTO_LINK_TIMEOUT_MS / 2 at another rate goes
+ * back to the safe rate by itself, in time for the board's next offer;
+ * LINK_DOWN asks the board to do the same.
+ *
+ * Commands. The host sends CMD_SET, CMD_GET, CMD_MODE, CMD_LOG,
+ * CMD_CAPTURE or CMD_SUBSCRIBE, the board answers each with a CMD_REPLY
+ * carrying the seq of the command, a protoStatus_t and the resulting
+ * value.
+ *
+ * Time. Records, channels and captures are stamped with the board's
+ * microsecond clock (clock.h), 32 bits that wrap every 71 minutes. To
+ * turn that into host time, the host sends CMD_PING now and then, noting
+ * its clock at sending (t1) and when the CMD_PONG arrives (t4); the pong
+ * carries the board's clock when the ping's frame ended (t2) and when the
+ * pong was made (t3). (t4 - t1) - (t3 - t2) is the time on the wire,
+ * about the same both ways when nothing was queued, so the pings that
+ * came back fastest give the offset, and a line through them over a few
+ * minutes the drift of the board's crystal (telemdec::ClockSync).
+ *
+ * State compression. With CMD_LOG 2 the board sends state records as
+ * STATE_DELTA messages, each carrying as many records as fit, every one
+ * coded against the record before it (protoDeltaEncode()): a byte with
+ * bit i set for each field i (law, torque, time, v[0..3]) that differs,
+ * then for those fields the difference as a zigzag varint, 7 bits per
+ * byte, low first, top bit set on all but the last. The time is coded
+ * against the previous record's time plus the step between the two
+ * before, so a steady rate costs only its jitter. Every PROTO_KEY_EVERY records
+ * and after any stop a full STATE record is sent as a keyframe. After a
+ * gap in seq a receiver skips STATE_DELTA until the next keyframe.
+ *
+ * Channels (chan.h). CMD_SUBSCRIBE picks any of the protoChanId_t
+ * signals, each at its own decimation. A CHANNELS message carries the
+ * time of the tick, a mask of the channels due at that tick and their
+ * values in channel order, each protoChans[ch].size bytes; channels
+ * whose decimations divide the tick go out together.
+ *
+ * Burst capture (capture.h). CMD_CAPTURE arms a recording of selected
+ * channels at the full control rate, triggers it and asks for the result,
+ * which follows as one CAPTURE_INFO and then CAPTURE_DATA messages of up
+ * to PROTO_CAPTURE_CHUNK samples, channel after channel, oldest first.
+ *
+ * Every few seconds the board sends an INFO message with its firmware
+ * build and link settings, for recordings to say what they came from.
+ * TEXT messages are lines for people, e.g. why the board stopped (fmt.h,
+ * telemPanic()): just the characters, no terminator, no line end.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Largest body of any message **/
+#define PROTO_BODY_MAX 64
+/** @brief Bytes of id, seq and crc around the body **/
+#define PROTO_OVERHEAD 5
+/** @brief Worst case frame for a body of n bytes: packet, COBS codes, delimiter **/
+#define PROTO_FRAME_MAX(n) ((n) + PROTO_OVERHEAD + ((n) + PROTO_OVERHEAD) / 254 + 2)
+
+/** @brief Rate the board boots at and falls back to **/
+#define PROTO_SAFE_BAUD 115200
+/** @brief Test frames sent at a new rate **/
+#define PROTO_LINK_FRAMES 16
+/** @brief Test pattern bytes after the protoLink_t of a test frame **/
+#define PROTO_LINK_PATTERN 48
+/** @brief Byte k of the pattern in test frame n, covers 0 and 0xFF **/
+#define PROTO_LINK_BYTE(n, k) ((uint8_t)((n) * 37 + (k) * 11))
+/** @brief Longest wait for the other side during link setup, ms **/
+#define PROTO_LINK_TIMEOUT_MS 200
+/** @brief Delta coded state records between two keyframes at most **/
+#define PROTO_KEY_EVERY 32
+/** @brief Fields of a state record in the delta coding **/
+#define PROTO_DELTA_FIELDS 7
+/** @brief Longest delta coded record: mask and a 5 byte varint per field **/
+#define PROTO_DELTA_MAX (1 + 5 * PROTO_DELTA_FIELDS)
+/** @brief Samples in a CAPTURE_DATA message **/
+#define PROTO_CAPTURE_CHUNK 28
+
+/** @brief Message ids **/
+typedef enum {
+   PROTO_STATE = 1,          /**< protoRecord_t, see TELEM_STATE */
+   PROTO_HEALTH,             /**< protoRecord_t, see TELEM_HEALTH */
+   PROTO_TASK,               /**< protoRecord_t, see TELEM_TASK */
+   PROTO_TIMING,             /**< protoRecord_t, see TELEM_TIMING */
+   PROTO_STATE_DELTA,        /**< delta coded state records, see above */
+   PROTO_CHANNELS,           /**< protoChannels_t, then the values */
+   PROTO_INFO,               /**< protoInfo_t, board: build and link settings */
+   PROTO_TEXT,               /**< characters, board: a line of text */
+   PROTO_LINK_OFFER = 0x10,  /**< protoLink_t, board: can switch to baud */
+   PROTO_LINK_ACCEPT,        /**< protoLink_t, host: switching to baud, 0 if not */
+   PROTO_LINK_TEST,          /**< protoLink_t with n = frame number, then the pattern */
+   PROTO_LINK_RESULT,        /**< protoLink_t with n = good test frames */
+   PROTO_LINK_DOWN,          /**< protoLink_t, host: back to the safe rate */
+   PROTO_CMD_SET = 0x20,     /**< protoParam_t, host: set a parameter */
+   PROTO_CMD_GET,            /**< protoParam_t, host: read a parameter, value unused */
+   PROTO_CMD_MODE,           /**< 1 byte, host: switch to that ctrlId_t */
+   PROTO_CMD_LOG,            /**< 1 byte, host: records 0 off, 1 full, 2 delta */
+   PROTO_CMD_REPLY,          /**< protoReply_t, board */
+   PROTO_CMD_CAPTURE,        /**< protoCapture_t, host: burst capture control */
+   PROTO_CMD_SUBSCRIBE,      /**< protoSubscribe_t, host: channel decimation */
+   PROTO_CMD_PING,           /**< no body, host: clock sync request */
+   PROTO_CMD_PONG,           /**< protoPong_t, board */
+   PROTO_CAPTURE_INFO = 0x30, /**< protoCaptureInfo_t, board: a dump follows */
+   PROTO_CAPTURE_DATA         /**< protoCaptureData_t header, then int16 samples */
+} protoId_t;
+
+/** @brief Parameters of CMD_SET and CMD_GET, fields of ctrlParams **/
+typedef enum {
+   PROTO_PARAM_OPEN_LOOP = 0,
+   PROTO_PARAM_KP,
+   PROTO_PARAM_KI,
+   PROTO_PARAM_KD,
+   PROTO_PARAM_LQR0,          /**< to PROTO_PARAM_LQR0 + 3 */
+   PROTO_PARAM_W0SQ = PROTO_PARAM_LQR0 + 4,
+   PROTO_PARAM_CATCH_WITH,
+   PROTO_PARAM_ARM_SETPOINT,
+   PROTO_PARAM_COUNT
+} protoParamId_t;
+
+/** @brief Outcome of a command **/
+typedef enum {
+   PROTO_OK = 0,
+   PROTO_BAD_ID,       /**< unknown command */
+   PROTO_BAD_LEN,      /**< body has the wrong size */
+   PROTO_BAD_PARAM,    /**< no such parameter or law */
+   PROTO_BAD_VALUE,    /**< value out of range, nothing changed */
+   PROTO_BAD_STATE     /**< not possible right now, nothing changed */
+} protoStatus_t;
+
+/** @brief Signals the host can subscribe to, see protoChans for their sizes **/
+typedef enum {
+   PROTO_CHAN_PEND = 0,       /**< pendulum angle, 65536 per rev, 0 hanging down */
+   PROTO_CHAN_ARM,            /**< unwrapped arm angle, counts */
+   PROTO_CHAN_PEND_RATE,      /**< counts/s, filtered */
+   PROTO_CHAN_ARM_RATE,       /**< counts/s, filtered */
+   PROTO_CHAN_TORQUE,         /**< torque command */
+   PROTO_CHAN_ARM_REF,        /**< arm setpoint, counts */
+   PROTO_CHAN_LAW,            /**< active ctrlId_t */
+   PROTO_CHAN_PWM_A,          /**< phase duty, timer counts */
+   PROTO_CHAN_PWM_B,
+   PROTO_CHAN_PWM_C,
+   PROTO_CHAN_LATENCY,        /**< timer update to control interrupt, cycles */
+   PROTO_CHAN_BUSY,           /**< previous control period, cycles */
+   PROTO_CHAN_OVERRUNS,       /**< control periods that started late */
+   PROTO_CHAN_DROPS,          /**< telemetry records dropped */
+   PROTO_CHAN_COUNT
+} protoChanId_t;
+
+/** @brief How a channel goes on the wire **/
+typedef struct {
+   const char * name;
+   uint8_t size;              /**< bytes, little endian */
+   uint8_t isSigned;          /**< 1 if the value is two's complement */
+} protoChanInfo_t;
+
+/** @brief Channels of a burst capture, all int16 per sample
+ *
+ *  Positions are the low 16 bits, the host unwraps them; rates are in
+ *  units of 32 counts/s, saturated.
+ */
+typedef enum {
+   PROTO_CH_ARM = 0,          /**< ctrlState_t arm */
+   PROTO_CH_ARM_RATE,         /**< armRate */
+   PROTO_CH_PEND,             /**< pend */
+   PROTO_CH_PEND_RATE,        /**< pendRate */
+   PROTO_CH_TORQUE,           /**< lastOut */
+   PROTO_CH_ARM_REF,          /**< armRef */
+   PROTO_CH_COUNT
+} protoCapChannel_t;
+
+/** @brief What a CMD_CAPTURE asks for **/
+typedef enum {
+   PROTO_CAP_STOP = 0,        /**< back to idle, drops the capture */
+   PROTO_CAP_ARM,             /**< start recording the history, wait for the trigger */
+   PROTO_CAP_TRIGGER,         /**< trigger now */
+   PROTO_CAP_DUMP             /**< send the finished capture */
+} protoCapOp_t;
+
+/** @brief Trigger sources of an armed capture **/
+typedef enum {
+   PROTO_TRIG_CMD = 0,        /**< CMD_CAPTURE PROTO_CAP_TRIGGER only */
+   PROTO_TRIG_LAW             /**< also any switch of the active law */
+} protoCapTrigger_t;
+
+/** @brief Capture states, the value of a CMD_CAPTURE reply **/
+typedef enum {
+   PROTO_CAP_IDLE = 0,
+   PROTO_CAP_ARMED,           /**< recording the history */
+   PROTO_CAP_TRIGGERED,       /**< recording the rest */
+   PROTO_CAP_DONE             /**< complete, may be dumped any number of times */
+} protoCapState_t;
+
+/** @brief Body of the telemetry messages: a telemRecord_t without its type **/
+typedef struct __attribute__((packed)) {
+   uint8_t law;
+   int16_t torque;
+   uint32_t time;      /**< clockUs() */
+   int32_t v[4];
+} protoRecord_t;
+
+/** @brief Bytes of a protoRecord_t body **/
+#define PROTO_RECORD_LEN 23
+
+/** @brief Delta coder state, the same on both ends of the link **/
+typedef struct {
+   protoRecord_t last;    /**< previous record */
+   uint32_t step;         /**< its time minus the one before */
+} protoDelta_t;
+
+/** @brief Body of INFO, sent every few seconds **/
+typedef struct __attribute__((packed)) {
+   uint32_t baud;      /**< link rate */
+   uint16_t ctrlHz;    /**< control ticks per second */
+   uint16_t decim;     /**< control ticks per state record */
+   uint8_t logging;    /**< state record mode, see CMD_LOG */
+   char build[32];     /**< firmware build, 0 terminated unless all 32 are used */
+} protoInfo_t;
+
+/** @brief Body of the link setup messages **/
+typedef struct __attribute__((packed)) {
+   uint32_t baud;
+   uint32_t n;
+} protoLink_t;
+
+/** @brief Body of CMD_SET and CMD_GET **/
+typedef struct __attribute__((packed)) {
+   uint16_t param;     /**< protoParamId_t */
+   int32_t value;
+} protoParam_t;
+
+/** @brief Body of CMD_REPLY **/
+typedef struct __attribute__((packed)) {
+   uint16_t seq;       /**< seq of the command frame */
+   uint8_t cmd;        /**< its id */
+   uint8_t status;     /**< protoStatus_t */
+   int32_t value;      /**< parameter, law or logging state after the command */
+} protoReply_t;
+
+/** @brief Body of CMD_PONG **/
+typedef struct __attribute__((packed)) {
+   uint16_t seq;       /**< seq of the ping frame */
+   uint32_t rx;        /**< clockUs() when the ping's frame ended */
+   uint32_t tx;        /**< clockUs() when the pong was queued */
+} protoPong_t;
+
+/** @brief Body of CMD_SUBSCRIBE **/
+typedef struct __attribute__((packed)) {
+   uint8_t chan;       /**< protoChanId_t */
+   uint16_t decim;     /**< control ticks per value, 0 unsubscribes */
+} protoSubscribe_t;
+
+/** @brief Start of the body of CHANNELS **/
+typedef struct __attribute__((packed)) {
+   uint32_t time;      /**< clockUs() at the control tick of the values */
+   uint16_t mask;      /**< bit n set if channel n follows */
+} protoChannels_t;
+
+/** @brief Body of CMD_CAPTURE **/
+typedef struct __attribute__((packed)) {
+   uint8_t op;         /**< protoCapOp_t */
+   uint8_t channels;   /**< PROTO_CAP_ARM: bit n records protoCapChannel_t n */
+   uint8_t trigger;    /**< PROTO_CAP_ARM: protoCapTrigger_t */
+   uint16_t pre;       /**< PROTO_CAP_ARM: samples kept from before the trigger */
+} protoCapture_t;
+
+/** @brief Body of CAPTURE_INFO **/
+typedef struct __attribute__((packed)) {
+   uint8_t channels;   /**< as armed */
+   uint16_t len;       /**< samples per channel */
+   uint16_t trigger;   /**< index of the trigger sample */
+   uint32_t time;      /**< clockUs() at the first sample, the rest 1/rate s apart */
+   uint16_t rate;      /**< samples per second */
+} protoCaptureInfo_t;
+
+/** @brief Start of the body of CAPTURE_DATA **/
+typedef struct __attribute__((packed)) {
+   uint8_t channel;    /**< protoCapChannel_t */
+   uint16_t index;     /**< of the first sample in this message */
+} protoCaptureData_t;
+
+extern const protoChanInfo_t protoChans[PROTO_CHAN_COUNT];
+
+uint16_t protoCrc16(uint16_t crc, const uint8_t * data, uint16_t len);
+uint16_t protoCobsEncode(const uint8_t * in, uint16_t len, uint8_t * out);
+uint16_t protoCobsDecode(uint8_t * buf, uint16_t len);
+uint16_t protoFrame(uint8_t id, uint16_t seq, const void * body, uint16_t len, uint8_t * out);
+uint8_t protoParse(const uint8_t * packet, uint16_t len, uint8_t * id, uint16_t * seq);
+void protoDeltaKey(protoDelta_t * d, const protoRecord_t * key);
+uint16_t protoDeltaEncode(protoDelta_t * d, const protoRecord_t * r, uint8_t * out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,187 @@
+#ifndef RING_H
+#define RING_H
+#include <stdint.h>
+#include <string.h>
+#include "stm32f1xx.h"
+
+/*
+ * Lock-free single producer, single consumer ring of variable size
+ * records, for handing data from an interrupt to a task or between two
+ * tasks without a kernel call. Works from interrupts above
+ * configMAX_SYSCALL_INTERRUPT_PRIORITY and never blocks either side.
+ *
+ * The producer owns head, the consumer owns tail; each only reads the
+ * other's. Aligned 32 bit loads and stores are atomic on the M3, so no
+ * LDREX/STREX is needed as long as there is one writer per index, the
+ * barriers only order the record contents against the index that
+ * publishes or frees them.
+ *
+ * Records are written in place and stay contiguous: each is a 32 bit
+ * length followed by the payload padded to 4 bytes. One that does not fit
+ * before the end of the buffer leaves a wrap marker and starts over at
+ * the beginning. Head never catches up with tail, so a ring of n bytes
+ * holds at most n - 4 bytes of records.
+ *
+ *    producer                          consumer
+ *    p = ringReserve(&r, max);         p = ringPeek(&r, &len);
+ *    if(p) {                           if(p) {
+ *       len = fill(p);                    use(p, len);
+ *       ringCommit(&r, len);              ringRelease(&r);
+ *    }                                 }
+ */
+
+/** @brief Bytes a record of len payload bytes takes in the ring **/
+#define RING_RECORD(len) (4 + (((len) + 3) & ~3UL))
+/** @brief Length word marking the rest of the buffer as unused **/
+#define RING_WRAP 0xFFFFFFFFUL
+
+/** @brief Ring state, see ringInit() **/
+typedef struct {
+   uint8_t * buf;            /**< storage, 4 byte aligned */
+   uint32_t size;            /**< bytes, multiple of 4 */
+   volatile uint32_t head;   /**< offset of the next record, producer */
+   volatile uint32_t tail;   /**< offset of the oldest record, consumer */
+   uint32_t rec;             /**< producer: offset of the reserved record */
+   uint32_t next;            /**< consumer: tail after the peeked record */
+} ring_t;
+
+//-------------------------------------------------------------------------------------
+/** @brief   Set up an empty ring
+ *  @details Neither side may run yet.
+ *  @param   r Ring
+ *  @param   buf Storage, 4 byte aligned, e.g. a uint32_t array
+ *  @param   size Bytes of storage, multiple of 4
+ */
+static inline void ringInit(ring_t * r, void * buf, uint32_t size) {
+   r->buf = buf;
+   r->size = size;
+   r->head = 0;
+   r->tail = 0;
+   r->rec = 0;
+   r->next = 0;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Reserve space for a record, producer side
+ *  @details Nothing is visible to the consumer until ringCommit(). A
+ *           reservation that is not committed is simply dropped by the
+ *           next one.
+ *  @param   r Ring
+ *  @param   len Largest payload the record will have, bytes
+ *  @return  Where to write the payload, NULL if the ring is too full
+ */
+static inline void * ringReserve(ring_t * r, uint32_t len) {
+   uint32_t need = RING_RECORD(len);
+   uint32_t h = r->head;
+   uint32_t t = r->tail;
+   uint32_t at = h;
+
+   if(h >= t) {
+      if(need > r->size - h || (need == r->size - h && t == 0)) {
+         if(need >= t) {
+            return NULL;
+         }
+         at = 0;
+      }
+   } else if(need >= t - h) {
+      return NULL;
+   }
+   r->rec = at;
+   return r->buf + at + 4;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Publish the reserved record, producer side
+ *  @param   r Ring
+ *  @param   len Payload bytes written, at most what was reserved
+ */
+static inline void ringCommit(ring_t * r, uint32_t len) {
+   uint32_t h = r->head;
+   uint32_t next = r->rec + RING_RECORD(len);
+
+   if(r->rec != h) {
+      *(uint32_t *)(r->buf + h) = RING_WRAP;
+   }
+   *(uint32_t *)(r->buf + r->rec) = len;
+   if(next == r->size) {
+      next = 0;
+   }
+   __DMB();
+   r->head = next;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Oldest record, consumer side
+ *  @details The record stays valid until ringRelease().
+ *  @param   r Ring
+ *  @param   len Filled with the payload bytes
+ *  @return  The payload, NULL if the ring is empty
+ */
+static inline const void * ringPeek(ring_t * r, uint32_t * len) {
+   uint32_t t = r->tail;
+   uint32_t n;
+
+   if(t == r->head) {
+      return NULL;
+   }
+   __DMB();
+   n = *(const uint32_t *)(r->buf + t);
+   if(n == RING_WRAP) {
+      t = 0;
+      n = *(const uint32_t *)r->buf;
+   }
+   r->next = t + RING_RECORD(n);
+   if(r->next == r->size) {
+      r->next = 0;
+   }
+   *len = n;
+   return r->buf + t + 4;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Free the record returned by ringPeek(), consumer side
+ *  @param   r Ring
+ */
+static inline void ringRelease(ring_t * r) {
+   __DMB();
+   r->tail = r->next;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Copy a record in, producer side
+ *  @param   r Ring
+ *  @param   data Payload
+ *  @param   len Payload bytes
+ *  @return  1 if written, 0 if the ring was too full
+ */
+static inline uint8_t ringWrite(ring_t * r, const void * data, uint32_t len) {
+   void * p = ringReserve(r, len);
+
+   if(!p) {
+      return 0;
+   }
+   memcpy(p, data, len);
+   ringCommit(r, len);
+   return 1;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Copy the oldest record out and free it, consumer side
+ *  @param   r Ring
+ *  @param   data Filled with the payload, truncated to len
+ *  @param   len Room in data, bytes
+ *  @return  1 if a record was read, 0 if the ring was empty
+ */
+static inline uint8_t ringRead(ring_t * r, void * data, uint32_t len) {
+   uint32_t n;
+   const void * p = ringPeek(r, &n);
+
+   if(!p) {
+      return 0;
+   }
+   memcpy(data, p, n < len ? n : len);
+   ringRelease(r);
+   return 1;
+}
+
+#endif
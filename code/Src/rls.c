@@ -0,0 +1,97 @@
+#include "rls.h"
+
+
+//-------------------------------------------------------------------------------------
+/** @brief   Set up an estimator with zero parameters and P = p0 I
+ *  @param   r Estimator to initialize
+ *  @param   n Number of parameters, at most RLS_MAX_N
+ *  @param   lambda Forgetting factor in Q16 (e.g. 0.995 -> 65208)
+ *  @param   p0 Initial covariance diagonal in Q16, also used to cap the trace
+ */
+void rlsInit(rls_t * r, uint8_t n, int32_t lambda, int32_t p0) {
+   uint8_t i, j;
+
+   r->n = n > RLS_MAX_N ? RLS_MAX_N : n;
+   r->lambda = lambda;
+   r->pMax = p0 * r->n;
+   r->updates = 0;
+   for(i = 0; i < RLS_MAX_N; i++) {
+      r->theta[i] = 0;
+      for(j = 0; j < RLS_MAX_N; j++) {
+         r->p[i][j] = (i == j) ? p0 : 0;
+      }
+   }
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Add one observation
+ *  @details Standard RLS step, k = P phi / (lambda + phi' P phi),
+ *           theta += k e, P = (P - k phi' P) / lambda, with 64 bit
+ *           intermediates. P is kept symmetric, and it is only divided by
+ *           lambda while its trace is below the cap, so it cannot wind up
+ *           while the input is not exciting.
+ *  @param   r Estimator to update
+ *  @param   phi Regressor vector, Q15, |phi| <= 1
+ *  @param   y Measured output, Q16
+ *  @return  Prediction error before the update, Q16
+ */
+int32_t rlsUpdate(rls_t * r, const int16_t * phi, int32_t y) {
+   int32_t pphi[RLS_MAX_N];
+   int32_t k[RLS_MAX_N];
+   int64_t acc;
+   int32_t den, e, trace;
+   uint8_t i, j, n = r->n;
+
+   /* P phi, Q16 */
+   for(i = 0; i < n; i++) {
+      acc = 0;
+      for(j = 0; j < n; j++) {
+         acc += (int64_t)r->p[i][j] * phi[j];
+      }
+      pphi[i] = (int32_t)(acc >> 15);
+   }
+
+   /* lambda + phi' P phi, Q16 */
+   acc = 0;
+   for(i = 0; i < n; i++) {
+      acc += (int64_t)phi[i] * pphi[i];
+   }
+   den = r->lambda + (int32_t)(acc >> 15);
+   if(den <= 0) {
+      return 0;
+   }
+
+   /* prediction error, Q16 */
+   acc = 0;
+   for(i = 0; i < n; i++) {
+      acc += (int64_t)phi[i] * r->theta[i];
+   }
+   e = y - (int32_t)(acc >> 15);
+
+   /* gain and parameter step */
+   for(i = 0; i < n; i++) {
+      k[i] = (int32_t)(((int64_t)pphi[i] << RLS_Q) / den);
+      r->theta[i] += (int32_t)(((int64_t)k[i] * e) >> RLS_Q);
+   }
+
+   /* covariance update */
+   trace = 0;
+   for(i = 0; i < n; i++) {
+      for(j = i; j < n; j++) {
+         int32_t v = r->p[i][j] - (int32_t)(((int64_t)k[i] * pphi[j]) >> RLS_Q);
+         r->p[i][j] = v;
+         r->p[j][i] = v;
+      }
+      trace += r->p[i][i];
+   }
+   if(trace < r->pMax) {
+      for(i = 0; i < n; i++) {
+         for(j = 0; j < n; j++) {
+            r->p[i][j] = (int32_t)(((int64_t)r->p[i][j] << RLS_Q) / r->lambda);
+         }
+      }
+   }
+
+   r->updates++;
+   return e;
+}
@@ -0,0 +1,28 @@
+#ifndef RLS_H
+#define RLS_H
+#include <stdint.h>
+
+/** @brief Largest number of parameters an estimator can have **/
+#define RLS_MAX_N 3
+
+/** @brief Fractional bits of parameters, covariance and forgetting factor **/
+#define RLS_Q 16
+
+/** @brief Recursive least squares estimator with exponential forgetting
+ *
+ *  Fits y = phi' * theta. Regressors are Q15 and must be scaled by the
+ *  caller to |phi| <= 1; y and theta are Q16.
+ */
+typedef struct {
+   uint8_t n;
+   int32_t lambda;                      /**< forgetting factor, Q16 */
+   int32_t pMax;                        /**< covariance trace cap, Q16 */
+   int32_t theta[RLS_MAX_N];            /**< parameters, Q16 */
+   int32_t p[RLS_MAX_N][RLS_MAX_N];     /**< covariance, Q16 */
+   uint32_t updates;
+} rls_t;
+
+void rlsInit(rls_t * r, uint8_t n, int32_t lambda, int32_t p0);
+int32_t rlsUpdate(rls_t * r, const int16_t * phi, int32_t y);
+
+#endif
@@ -0,0 +1,97 @@
+#include "rtstats.h"
+#include "bsp.h"
+#include "stm32f1xx_hal.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* uxTaskGetSystemState() output, too big for the housekeeping stack */
+static TaskStatus_t status[RTSTATS_MAX_TASKS];
+/* run time of each task and in total at the previous sample, by task number */
+static uint32_t lastRun[RTSTATS_MAX_TASKS + 1];
+static uint32_t lastTotal;
+/* task names by task number, for the telemetry task */
+static const char * names[RTSTATS_MAX_TASKS + 1];
+
+
+//-------------------------------------------------------------------------------------
+/** @brief   Start the DWT cycle counter used as the run time clock
+ *  @details Called by the kernel (portCONFIGURE_TIMER_FOR_RUN_TIME_STATS)
+ *           when the scheduler starts. Counting core cycles costs nothing at
+ *           run time and reading it at a context switch is a single load.
+ *           The count is not reset: clock.c may have started it already
+ *           and counts on it running on.
+ */
+void rtstatsTimerInit(void) {
+   CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+   DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Core cycles, from whenever the counter started
+ *  @details Wraps every 2^32 cycles, about 60 s at 72 MHz. Only differences
+ *           are used, so intervals must stay shorter than that.
+ *  @return  bspCycles()
+ */
+uint32_t rtstatsCycles(void) {
+   return bspCycles();
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Per-task CPU share and stack headroom since the last call
+ *  @details Meant to be called periodically from a low priority task, at
+ *           most every 60 s so no counter wraps twice between two calls.
+ *           The first call reports the time since the scheduler started.
+ *           The scheduler is suspended while the task list is walked, a few
+ *           microseconds with the handful of tasks here.
+ *  @param   out Filled with one entry per task
+ *  @param   max Size of out
+ *  @param   idle Set to the idle share, 1/1000, may be 0
+ *  @return  Entries filled, 0 if there are more than RTSTATS_MAX_TASKS tasks
+ */
+uint8_t rtstatsSample(rtstatsTask_t * out, uint8_t max, uint16_t * idle) {
+   TaskHandle_t idleTask = xTaskGetIdleTaskHandle();
+   uint32_t total, span;
+   uint8_t n, i, k = 0;
+
+   n = uxTaskGetSystemState(status, RTSTATS_MAX_TASKS, &total);
+   span = (total - lastTotal) / 1000;
+   lastTotal = total;
+   if(idle) {
+      *idle = 0;
+   }
+
+   for(i = 0; i < n && k < max; i++) {
+      uint8_t num = status[i].xTaskNumber;
+      uint32_t run = status[i].ulRunTimeCounter;
+
+      out[k].number = num;
+      out[k].idle = status[i].xHandle == idleTask;
+      out[k].stackFree = status[i].usStackHighWaterMark;
+      out[k].cycles = 0;
+      if(num <= RTSTATS_MAX_TASKS) {
+         out[k].cycles = run - lastRun[num];
+         lastRun[num] = run;
+         names[num] = status[i].pcTaskName;
+      }
+      out[k].cpu = span ? out[k].cycles / span : 0;
+      if(out[k].idle && idle) {
+         *idle = out[k].cpu;
+      }
+      k++;
+   }
+   return k;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Name of a task seen by rtstatsSample()
+ *  @details Points into the task control block; all tasks are static and
+ *           never deleted, so the pointer stays valid.
+ *  @param   number Task number from rtstatsTask_t
+ *  @return  The name, "?" if the task has not been sampled yet
+ */
+const char * rtstatsName(uint8_t number) {
+   if(number > RTSTATS_MAX_TASKS || names[number] == 0) {
+      return "?";
+   }
+   return names[number];
+}
@@ -0,0 +1,22 @@
+#ifndef RTSTATS_H
+#define RTSTATS_H
+#include <stdint.h>
+
+/** @brief Most tasks rtstatsSample() reports, including the idle task **/
+#define RTSTATS_MAX_TASKS 6
+
+/** @brief Per-task result of one rtstatsSample() **/
+typedef struct {
+   uint8_t number;      /**< FreeRTOS task number, stable for the task's life */
+   uint8_t idle;        /**< 1 for the idle task */
+   uint16_t cpu;        /**< share of the CPU since the last sample, 1/1000 */
+   uint32_t cycles;     /**< cycles run since the last sample */
+   uint16_t stackFree;  /**< stack high-water mark, words never used */
+} rtstatsTask_t;
+
+void rtstatsTimerInit(void);
+uint32_t rtstatsCycles(void);
+uint8_t rtstatsSample(rtstatsTask_t * out, uint8_t max, uint16_t * idle);
+const char * rtstatsName(uint8_t number);
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+#include <stdint.h>
+#include "stm32f1xx.h"
+
+/*
+ * Sequence lock for handing a snapshot from an interrupt to tasks without
+ * disabling interrupts. The writer makes the sequence odd, copies the
+ * data and makes it even again; a reader copies the data between two reads
+ * of the sequence and retries if it changed. The writer must be the only
+ * one and must not be preempted by a reader, which holds for an interrupt
+ * writing and tasks reading: a reader never waits on the writer, it only
+ * retries when it was interrupted by it.
+ *
+ *    seqWriteBegin(&seq);          do {
+ *    shared = local;                  s = seqReadBegin(&seq);
+ *    seqWriteEnd(&seq);               local = shared;
+ *                                  } while(seqReadRetry(&seq, s));
+ */
+
+//-------------------------------------------------------------------------------------
+/** @brief   Start writing, the data may now be inconsistent
+ *  @param   seq Sequence of the protected data
+ */
+static inline void seqWriteBegin(volatile uint32_t * seq) {
+   *seq = *seq + 1;
+   __DMB();
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Done writing, the data is consistent again
+ *  @param   seq Sequence of the protected data
+ */
+static inline void seqWriteEnd(volatile uint32_t * seq) {
+   __DMB();
+   *seq = *seq + 1;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Start reading
+ *  @param   seq Sequence of the protected data
+ *  @return  Sequence to pass to seqReadRetry()
+ */
+static inline uint32_t seqReadBegin(const volatile uint32_t * seq) {
+   uint32_t s;
+
+   while((s = *seq) & 1) {
+   }
+   __DMB();
+   return s;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Check whether the copy just made may be torn
+ *  @param   seq Sequence of the protected data
+ *  @param   s Value returned by seqReadBegin()
+ *  @return  1 if the writer ran in between and the copy must be redone
+ */
+static inline uint8_t seqReadRetry(const volatile uint32_t * seq, uint32_t s) {
+   __DMB();
+   return *seq != s;
+}
+
+#endif
@@ -37,12 +37,18 @@
 #include "cmsis_os.h"
 
 /* USER CODE BEGIN 0 */
+#include "link.h"
+#include "telemetry.h"
+#include "fmt.h"
+#include "clock.h"
 
 /* USER CODE END 0 */
 
 /* External variables --------------------------------------------------------*/
-
 extern TIM_HandleTypeDef htim4;
+extern DMA_HandleTypeDef hdma_usart1_tx;
+extern DMA_HandleTypeDef hdma_usart1_rx;
+extern UART_HandleTypeDef huart1;
 
 /******************************************************************************/
 /*            Cortex-M3 Processor Interruption and Exception Handlers         */ 
@@ -67,7 +73,18 @@ void NMI_Handler(void)
 void HardFault_Handler(void)
 {
   /* USER CODE BEGIN HardFault_IRQn 0 */
-
+  /* say why on the link, the fault status registers as they are */
+  char text[PROTO_BODY_MAX];
+  fmt_t f;
+
+  fmtStart(&f, text, sizeof(text));
+  fmtStr(&f, "hard fault cfsr ");
+  fmtHex(&f, SCB->CFSR, 8);
+  fmtStr(&f, " hfsr ");
+  fmtHex(&f, SCB->HFSR, 8);
+  fmtStr(&f, " bfar ");
+  fmtHex(&f, SCB->BFAR, 8);
+  telemPanic(text, f.len);
   /* USER CODE END HardFault_IRQn 0 */
   while (1)
   {
@@ -152,11 +169,19 @@ void DebugMon_Handler(void)
 void SysTick_Handler(void)
 {
   /* USER CODE BEGIN SysTick_IRQn 0 */
-
+  /* the only 1 ms interrupt: HAL time base and RTOS tick both run from
+     SysTick, TIM4 is free for the application */
   /* USER CODE END SysTick_IRQn 0 */
+  HAL_IncTick();
   osSystickHandler();
   /* USER CODE BEGIN SysTick_IRQn 1 */
-
+  /* the microsecond clock until the control interrupt keeps it, with the
+     interrupts that read it (USART1, DMA) masked */
+  {
+     UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+     clockTick();
+     taskEXIT_CRITICAL_FROM_ISR(mask);
+  }
   /* USER CODE END SysTick_IRQn 1 */
 }
 
@@ -167,6 +192,34 @@ void SysTick_Handler(void)
 /* please refer to the startup file (startup_stm32f1xx.s).                    */
 /******************************************************************************/
 
+/**
+* @brief This function handles DMA1 channel4 global interrupt.
+*/
+void DMA1_Channel4_IRQHandler(void)
+{
+  /* USER CODE BEGIN DMA1_Channel4_IRQn 0 */
+
+  /* USER CODE END DMA1_Channel4_IRQn 0 */
+  HAL_DMA_IRQHandler(&hdma_usart1_tx);
+  /* USER CODE BEGIN DMA1_Channel4_IRQn 1 */
+
+  /* USER CODE END DMA1_Channel4_IRQn 1 */
+}
+
+/**
+* @brief This function handles DMA1 channel5 global interrupt.
+*/
+void DMA1_Channel5_IRQHandler(void)
+{
+  /* USER CODE BEGIN DMA1_Channel5_IRQn 0 */
+
+  /* USER CODE END DMA1_Channel5_IRQn 0 */
+  HAL_DMA_IRQHandler(&hdma_usart1_rx);
+  /* USER CODE BEGIN DMA1_Channel5_IRQn 1 */
+
+  /* USER CODE END DMA1_Channel5_IRQn 1 */
+}
+
 /**
 * @brief This function handles TIM4 global interrupt.
 */
@@ -181,6 +234,21 @@ void TIM4_IRQHandler(void)
   /* USER CODE END TIM4_IRQn 1 */
 }
 
+/**
+* @brief This function handles USART1 global interrupt.
+*/
+void USART1_IRQHandler(void)
+{
+  /* USER CODE BEGIN USART1_IRQn 0 */
+  linkIrq();
+
+  /* USER CODE END USART1_IRQn 0 */
+  HAL_UART_IRQHandler(&huart1);
+  /* USER CODE BEGIN USART1_IRQn 1 */
+
+  /* USER CODE END USART1_IRQn 1 */
+}
+
 /* USER CODE BEGIN 1 */
 
 /* USER CODE END 1 */
@@ -0,0 +1,101 @@
+#include "swingup.h"
+#include "trig.h"
+
+
+//-------------------------------------------------------------------------------------
+/** @brief   Pendulum energy relative to hanging at rest
+ *  @details E / (m g l) = 1 - cos(a) + v^2 / (2 w0^2), with v converted
+ *           from counts per ILC sample to rad/s.
+ *  @param   pend Pendulum angle, 65536 per rev, 0 hanging down
+ *  @param   vel Pendulum velocity in counts per ILC sample
+ *  @param   w0sq Pendulum w0^2, Q8 rad^2/s^2
+ *  @return  Energy, Q14 (SWING_E_TOP when balanced upright)
+ */
+int32_t swingupEnergy(uint16_t pend, int32_t vel, int32_t w0sq) {
+   /* (2 pi / 65536 * 1000)^2 / 2 * 2^14 * 2^8, per tick instead of per sample */
+   const int64_t kin = 19276;
+   int32_t pot = (1L << 14) - ((int32_t)sinShift03(((pend >> 4) + 1024) & (THETA_MAX - 1)) - 2048) * 8;
+
+   if(w0sq <= 0) {
+      return pot;
+   }
+   return pot + (int32_t)(kin * vel * vel / ((int64_t)w0sq * ILC_DECIM * ILC_DECIM));
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Begin a trial from the pendulum hanging at rest
+ *  @param   s Swing-up state
+ *  @param   ilc Learning state whose profile is played and recorded into
+ *  @param   w0sq Pendulum w0^2, Q8 rad^2/s^2, e.g. from identGetParams()
+ *  @param   pend Current pendulum angle
+ */
+void swingupStart(swingup_t * s, ilc_t * ilc, int32_t w0sq, uint16_t pend) {
+   s->ilc = ilc;
+   s->w0sq = w0sq > 0 ? w0sq : SWING_W0SQ_DEFAULT;
+   s->energy = 0;
+   s->fb = 0;
+   s->dir = 1;
+   s->k = 0;
+   s->tick = 0;
+   s->lastPend = pend;
+   s->status = SWING_RUNNING;
+   ilcTrialStart(ilc);
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   One control tick of the swing-up
+ *  @details Once per ILC sample the energy is measured, its error against
+ *           the ramp is recorded for learning, and the energy feedback
+ *           k (Eref - E) is signed with the direction in which arm torque
+ *           currently pumps energy, sgn(cos(a) da/dt). The learned
+ *           feedforward for the sample is added on top and a weak PD
+ *           keeps the arm near where it started. The trial ends when the
+ *           pendulum gets within SWING_CATCH of upright or the profile runs out.
+ *  @param   s Swing-up state
+ *  @param   arm Arm position relative to the start, counts, torque direction
+ *  @param   armVel Arm velocity, counts/tick, torque direction
+ *  @param   pend Pendulum angle, 65536 per rev, 0 hanging down
+ *  @return  Torque for setMotorTorque(), 0 once the trial has ended
+ */
+int16_t swingupStep(swingup_t * s, int32_t arm, int32_t armVel, uint16_t pend) {
+   int32_t out;
+
+   if(s->status != SWING_RUNNING) {
+      return 0;
+   }
+
+   if(++s->tick >= ILC_DECIM) {
+      int32_t vel = (int16_t)(pend - s->lastPend);
+      int32_t c = (int32_t)sinShift03(((pend >> 4) + 1024) & (THETA_MAX - 1)) - 2048;
+      int32_t ref = s->k >= SWING_RAMP ? SWING_E_TOP : SWING_E_TOP * s->k / SWING_RAMP;
+      int32_t err;
+
+      s->tick = 0;
+      s->lastPend = pend;
+      s->energy = swingupEnergy(pend, vel, s->w0sq);
+      s->dir = (vel * c * SWING_SIGN) < 0 ? -1 : 1;
+      err = ref - s->energy;
+      ilcRecord(s->ilc, s->k, err, s->dir);
+      s->fb = (err * SWING_KE) >> 10;
+      s->k++;
+
+      if((int16_t)(pend - 32768) < SWING_CATCH && (int16_t)(pend - 32768) > -SWING_CATCH) {
+         s->status = SWING_UP;
+         return 0;
+      }
+      if(s->k >= ILC_LEN) {
+         s->status = SWING_TIMEOUT;
+         return 0;
+      }
+   }
+
+   out = s->dir * s->fb + ilcFeedforward(s->ilc, s->k);
+   out -= (arm * SWING_ARM_KP) / 256 + SWING_ARM_KD * armVel;
+   if(out > SWING_TORQUE_MAX) {
+      out = SWING_TORQUE_MAX;
+   }
+   if(out < -SWING_TORQUE_MAX) {
+      out = -SWING_TORQUE_MAX;
+   }
+   return out;
+}
@@ -0,0 +1,53 @@
+#ifndef SWINGUP_H
+#define SWINGUP_H
+#include <stdint.h>
+#include "ilc.h"
+
+/** @brief Pendulum energy of the upright position, Q14 of m g l **/
+#define SWING_E_TOP (2L << 14)
+/** @brief Samples the reference energy takes to reach SWING_E_TOP **/
+#define SWING_RAMP (ILC_LEN * 3 / 4)
+/** @brief Energy feedback, Q10 torque per Q14 energy error **/
+#define SWING_KE 64
+/** @brief Arm centering, Q8 torque per count and torque per count/tick **/
+#define SWING_ARM_KP 2
+#define SWING_ARM_KD 4
+/** @brief Torque limit while swinging **/
+#define SWING_TORQUE_MAX 600
+/** @brief Distance from upright (65536 per rev) counted as swung up, ~30 deg **/
+#define SWING_CATCH 5461
+/** @brief Sign of the arm to pendulum coupling, see identParams_t **/
+#define SWING_SIGN 1
+/** @brief w0^2 used until identification has a value, Q8 rad^2/s^2 **/
+#define SWING_W0SQ_DEFAULT (114L << 8)
+
+/** @brief Progress of a swing-up trial **/
+typedef enum {
+   SWING_RUNNING = 0,
+   SWING_UP,
+   SWING_TIMEOUT
+} swingStatus_t;
+
+/** @brief Energy based swing-up with learned feedforward
+ *
+ *  The pendulum energy is servoed to a reference that ramps from hanging
+ *  to upright in SWING_RAMP samples; the ILC profile supplies the torque
+ *  that the feedback would otherwise have to be late with.
+ */
+typedef struct {
+   ilc_t * ilc;           /**< profile to use and record into */
+   int32_t w0sq;          /**< pendulum w0^2, Q8 rad^2/s^2 */
+   int32_t energy;        /**< last energy, Q14 */
+   int16_t fb;            /**< energy feedback held over a sample */
+   int8_t dir;            /**< torque direction that adds energy */
+   uint16_t k;            /**< sample index in the trial */
+   uint8_t tick;          /**< ticks into the current sample */
+   uint16_t lastPend;     /**< pendulum angle at the last sample */
+   swingStatus_t status;
+} swingup_t;
+
+int32_t swingupEnergy(uint16_t pend, int32_t vel, int32_t w0sq);
+void swingupStart(swingup_t * s, ilc_t * ilc, int32_t w0sq, uint16_t pend);
+int16_t swingupStep(swingup_t * s, int32_t arm, int32_t armVel, uint16_t pend);
+
+#endif
@@ -0,0 +1,411 @@
+#include "telemetry.h"
+#include "cmsis_os.h"
+#include "ring.h"
+#include "link.h"
+#include "capture.h"
+#include <string.h>
+
+/*
+ * Telemetry: state records from the control interrupt, records from the
+ * tasks and the messages of link.c, command.c and capture.c, packed into
+ * frames (proto.h) in a double buffer that DMA sends on USART1.
+ *
+ * Telemetry never delays a control period. The control interrupt writes
+ * its state records in place into a ring with telemReserve(): no copy,
+ * no kernel call, and a full ring drops the record instead of waiting.
+ * The telemetry task packs, DMA sends. ctrlOverruns, in every state
+ * record, shows that this holds; TELEM_STRESS in main.c sends the state
+ * every tick, more than the safe rate carries, to check it with the ring
+ * full.
+ */
+
+/* CMSIS-RTOS v1 message queues only carry 32 bit words, so the record
+   queue is a plain FreeRTOS queue */
+static QueueHandle_t telemQueue;
+static StaticQueue_t telemQueueBlock;
+static uint8_t telemQueueStorage[TELEM_QUEUE_LEN * sizeof(telemRecord_t)];
+static volatile uint32_t drops;
+
+/* state records from the control interrupt, which must not call the
+   kernel; one record more since the ring never fills completely */
+static uint32_t stateMem[(TELEM_RING_LEN + 1) * RING_RECORD(sizeof(telemRecord_t)) / 4];
+static ring_t stateRing;
+static volatile uint32_t stateDrops;
+static volatile uint16_t stateDecim;
+static volatile uint8_t stateLogging;
+static uint32_t stateBaud;
+
+/* delta coding, task side: the batch being filled and the coder state */
+static uint8_t batch[PROTO_BODY_MAX];
+static uint16_t batchFill;
+static protoDelta_t delta;
+static uint8_t deltaLeft;
+
+/* the task packs into one half while DMA sends the other */
+static uint8_t txBuf[2][TELEM_TX_LEN];
+static uint16_t txFill;
+static uint8_t txHalf;
+static volatile uint8_t txBusy;
+static uint16_t txSeq;
+static UART_HandleTypeDef * telemUart;
+
+
+//-------------------------------------------------------------------------------------
+/** @brief   Create the record queue, call before the scheduler starts
+ *  @param   huart UART the telemetry task owns, with a TX DMA channel linked
+ *  @return  1 on success, 0 if the queue could not be created
+ */
+uint8_t telemInit(UART_HandleTypeDef * huart) {
+   telemUart = huart;
+   drops = 0;
+   stateDrops = 0;
+   txFill = 0;
+   txHalf = 0;
+   txBusy = 0;
+   txSeq = 0;
+   batchFill = 0;
+   deltaLeft = 0;
+   stateLogging = TELEM_LOG_FULL;
+   telemSetBaud(huart->Init.BaudRate);
+   ringInit(&stateRing, stateMem, sizeof(stateMem));
+   telemQueue = xQueueCreateStatic(TELEM_QUEUE_LEN, sizeof(telemRecord_t),
+                                   telemQueueStorage, &telemQueueBlock);
+   return telemQueue != NULL;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Hand a record to the telemetry task without ever waiting
+ *  @details For tasks: if the queue is full the record is dropped and
+ *           counted instead of blocking.
+ *  @param   r Record to send, copied
+ *  @return  1 if queued, 0 if dropped
+ */
+uint8_t telemPost(const telemRecord_t * r) {
+   if(xQueueSendToBack(telemQueue, r, 0) != pdPASS) {
+      drops++;
+      return 0;
+   }
+   return 1;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Space for a state record, for the control interrupt
+ *  @details No kernel call and no copy: fill the record in place and
+ *           publish it with telemCommit(). Only one context may use this,
+ *           the ring has a single producer.
+ *  @return  The record to fill, NULL if the ring is full (counted as
+ *           dropped) or logging is stopped
+ */
+telemRecord_t * telemReserve(void) {
+   telemRecord_t * r;
+
+   if(!stateLogging) {
+      return NULL;
+   }
+   r = ringReserve(&stateRing, sizeof(telemRecord_t));
+
+   if(!r) {
+      stateDrops++;
+   }
+   return r;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Publish the record filled after telemReserve()
+ */
+void telemCommit(void) {
+   ringCommit(&stateRing, sizeof(telemRecord_t));
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Space for any other message, for the control interrupt
+ *  @details Shares the ring and the rules of telemReserve(); the body is
+ *           published with telemCommitBody() and sent as one frame.
+ *  @param   id Message id
+ *  @param   len Largest body, at most PROTO_BODY_MAX
+ *  @return  Where to write the body, NULL if the ring is full (counted)
+ */
+uint8_t * telemReserveBody(uint8_t id, uint16_t len) {
+   uint8_t * r = ringReserve(&stateRing, 1 + len);
+
+   if(!r) {
+      stateDrops++;
+      return NULL;
+   }
+   r[0] = id;
+   return r + 1;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Publish the body filled after telemReserveBody()
+ *  @param   len Body bytes written
+ */
+void telemCommitBody(uint16_t len) {
+   ringCommit(&stateRing, 1 + len);
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Records dropped because the queue or the ring was full
+ *  @return  Number of dropped records since telemInit()
+ */
+uint32_t telemDrops(void) {
+   return drops + stateDrops;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Control ticks per state record
+ *  @return  Decimation for the current baud rate, see TELEM_DECIM()
+ */
+uint16_t telemDecim(void) {
+   return stateDecim;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Set the state record decimation for the link rate and mode
+ *  @param   baud Rate of the UART, e.g. after a baud change
+ */
+void telemSetBaud(uint32_t baud) {
+   uint16_t decim;
+
+   stateBaud = baud;
+   decim = TELEM_DECIM(baud, stateLogging == TELEM_LOG_DELTA ? TELEM_DELTA_WIRE_LEN : TELEM_WIRE_LEN);
+   stateDecim = decim ? decim : 1;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Start, stop or compress the state records, task records keep going
+ *  @details Telemetry task only, once it runs. Delta coding starts with a
+ *           keyframe and lowers the decimation to match.
+ *  @param   mode telemLog_t
+ *  @return  1 if set, 0 if there is no such mode
+ */
+uint8_t telemSetLogging(uint8_t mode) {
+   if(mode > TELEM_LOG_DELTA) {
+      return 0;
+   }
+   stateLogging = mode;
+   deltaLeft = 0;
+   telemSetBaud(stateBaud);
+   return 1;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   How state records are sent
+ *  @return  telemLog_t, see telemSetLogging()
+ */
+uint8_t telemLogging(void) {
+   return stateLogging;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Append a message to the half being filled as one frame
+ *  @param   id Message id
+ *  @param   body Body, little endian
+ *  @param   len Body bytes
+ *  @return  1 if appended, 0 if that half is full
+ */
+static uint8_t telemFrame(uint8_t id, const void * body, uint16_t len) {
+   if(txFill + PROTO_FRAME_MAX(len) > TELEM_TX_LEN) {
+      return 0;
+   }
+   txFill += protoFrame(id, txSeq++, body, len, &txBuf[txHalf][txFill]);
+   return 1;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Append the delta coded records collected so far as one frame
+ *  @return  1 if appended or there were none, 0 if the half is full
+ */
+static uint8_t telemBatch(void) {
+   if(!batchFill) {
+      return 1;
+   }
+   if(!telemFrame(PROTO_STATE_DELTA, batch, batchFill)) {
+      return 0;
+   }
+   batchFill = 0;
+   return 1;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Append a record from the control interrupt
+ *  @details State records go out in the current mode. Delta coded ones
+ *           go into the batch, which goes out when the next one does not
+ *           fit, before a keyframe, or whenever the link is idle at the
+ *           end of a round, so it only fills up while the link is busy.
+ *           Anything else is a message from telemReserveBody().
+ *  @param   s Record
+ *  @param   len Record bytes
+ *  @return  1 if taken, 0 if the half is full
+ */
+static uint8_t telemState(const telemRecord_t * s, uint32_t len) {
+   uint8_t code[PROTO_DELTA_MAX];
+   protoDelta_t next;
+   protoRecord_t r;
+   uint16_t n;
+
+   if(s->type != TELEM_STATE) {
+      return telemFrame(s->type, &s->law, len - 1);
+   }
+   if(stateLogging != TELEM_LOG_DELTA) {
+      return telemBatch() && telemFrame(s->type, &s->law, PROTO_RECORD_LEN);
+   }
+   memcpy(&r, &s->law, PROTO_RECORD_LEN);
+   if(!deltaLeft) {
+      if(!telemBatch() || !telemFrame(PROTO_STATE, &r, PROTO_RECORD_LEN)) {
+         return 0;
+      }
+      protoDeltaKey(&delta, &r);
+      deltaLeft = PROTO_KEY_EVERY;
+      return 1;
+   }
+   next = delta;
+   n = protoDeltaEncode(&next, &r, code);
+   if(batchFill + n > PROTO_BODY_MAX && !telemBatch()) {
+      return 0;
+   }
+   memcpy(batch + batchFill, code, n);
+   batchFill += n;
+   delta = next;
+   deltaLeft--;
+   return 1;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Send the filled half if the previous transfer is done
+ */
+static void telemFlush(void) {
+   if(txBusy || !txFill) {
+      return;
+   }
+   txBusy = 1;
+   if(HAL_UART_Transmit_DMA(telemUart, txBuf[txHalf], txFill) != HAL_OK) {
+      txBusy = 0;
+      return;
+   }
+   txHalf ^= 1;
+   txFill = 0;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Transfer done, the other half may go
+ *  @details Runs in the USART1 interrupt. Only clears a flag, the task
+ *           polls it, so the interrupt needs no kernel call.
+ *  @param   huart UART that finished sending
+ */
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef * huart) {
+   if(huart == telemUart) {
+      txBusy = 0;
+   }
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Send a message, waiting for room if need be
+ *  @details Telemetry task only, for the link setup (link.c); records go
+ *           through telemPost() and telemReserve().
+ *  @param   id Message id
+ *  @param   body Body, little endian
+ *  @param   len Body bytes, at most PROTO_BODY_MAX
+ */
+void telemSend(uint8_t id, const void * body, uint16_t len) {
+   while(!telemFrame(id, body, len)) {
+      telemFlush();
+      osDelay(1);
+   }
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Wait until everything packed so far has left the UART
+ *  @details Telemetry task only. The transfer complete callback comes
+ *           with the last stop bit, so the baud rate may change after.
+ */
+void telemDrain(void) {
+   while(txFill || txBusy) {
+      telemFlush();
+      osDelay(1);
+   }
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Tell the host what it is talking to, see protoInfo_t
+ */
+static void telemInfo(void) {
+   protoInfo_t info;
+
+   info.baud = stateBaud;
+   info.ctrlHz = CTRL_HZ;
+   info.decim = stateDecim;
+   info.logging = stateLogging;
+   strncpy(info.build, BUILD_ID, sizeof(info.build));
+   telemSend(PROTO_INFO, &info, sizeof(info));
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Body of the telemetry task, never returns
+ *  @details Packs records as framed binary (proto.h) into one half of the
+ *           transmit buffer and hands the filled half to DMA once the other
+ *           is sent, so per record the CPU only frames about 30 bytes, or
+ *           delta codes it (telemState()).
+ *           Wakes on task records and at least every tick for the
+ *           interrupt's state records, which wait in the ring until there
+ *           is room. Between rounds it gives the link a turn (linkPoll()),
+ *           which may stop the stream for a baud negotiation, and sends
+ *           part of a capture dump if one was asked for, and an INFO
+ *           message every TELEM_INFO_MS. This and
+ *           link.c are the only code that touches the UART.
+ */
+void telemRun(void) {
+   telemRecord_t r;
+   const telemRecord_t * s;
+   uint32_t lastInfo = osKernelSysTick() - TELEM_INFO_MS;
+   uint32_t len;
+   uint8_t held = 0;
+
+   for(;;) {
+      if(held) {
+         osDelay(1);
+      } else {
+         held = xQueueReceive(telemQueue, &r, 1) == pdPASS;
+      }
+      while(held && telemFrame(r.type, &r.law, PROTO_RECORD_LEN)) {
+         held = xQueueReceive(telemQueue, &r, 0) == pdPASS;
+      }
+      while((s = ringPeek(&stateRing, &len)) != NULL && telemState(s, len)) {
+         ringRelease(&stateRing);
+      }
+      if(!txBusy) {
+         telemBatch();
+      }
+      telemFlush();
+      linkPoll();
+      capturePoll();
+      if(osKernelSysTick() - lastInfo >= TELEM_INFO_MS) {
+         telemInfo();
+         lastInfo = osKernelSysTick();
+      }
+   }
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Send a line of text with everything else stopped, for the error
+ *           and fault handlers
+ *  @details Turns the interrupts off for good, cuts off any transfer in
+ *           progress and sends one TEXT frame by polling the UART at its
+ *           current rate; a host that lost the frame cut off before it
+ *           resyncs at this one's leading 0. Nothing before telemInit().
+ *  @param   text Characters, see PROTO_TEXT
+ *  @param   len Characters, at most PROTO_BODY_MAX are sent
+ */
+void telemPanic(const char * text, uint16_t len) {
+   uint8_t frame[1 + PROTO_FRAME_MAX(PROTO_BODY_MAX)];
+   uint16_t n;
+
+   __disable_irq();
+   if(!telemUart) {
+      return;
+   }
+   HAL_UART_AbortTransmit(telemUart);
+   frame[0] = 0;
+   n = protoFrame(PROTO_TEXT, txSeq++, text, len < PROTO_BODY_MAX ? len : PROTO_BODY_MAX, frame + 1);
+   HAL_UART_Transmit(telemUart, frame, 1 + n, HAL_MAX_DELAY);
+}
@@ -0,0 +1,77 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+#include <stdint.h>
+#include "stm32f1xx_hal.h"
+#include "proto.h"
+#include "control.h"
+
+/** @brief Records from tasks that can wait for the telemetry task **/
+#define TELEM_QUEUE_LEN 16
+/** @brief State records from the control interrupt that can wait **/
+#define TELEM_RING_LEN 16
+/** @brief Period of the INFO message, ms **/
+#define TELEM_INFO_MS 5000
+/** @brief Firmware build sent in INFO, the Makefile sets it from git **/
+#ifndef BUILD_ID
+#define BUILD_ID "unknown"
+#endif
+/** @brief Bytes in each half of the transmit double buffer **/
+#define TELEM_TX_LEN 256
+/** @brief Bytes of one record on the wire at most, see proto.h **/
+#define TELEM_WIRE_LEN PROTO_FRAME_MAX(PROTO_RECORD_LEN)
+/** @brief Bytes of a delta coded state record on the wire, typical while
+ *  swinging, batch overhead and keyframes included **/
+#define TELEM_DELTA_WIRE_LEN 10
+/** @brief Control ticks per state record at a baud rate and record size,
+ *  so that state records take at most half the link: full records 6 at
+ *  the safe rate and 1 from 921600, delta coded 2 and 1 from 230400 **/
+#define TELEM_DECIM(baud, wire) ((2UL * (wire) * 10 * CTRL_HZ + (baud) - 1) / (baud))
+
+/** @brief Kind of a telemetry record, sent as the message id **/
+typedef enum {
+   TELEM_STATE = PROTO_STATE,   /**< v = arm, pendulum, pendulum rate, control overruns */
+   TELEM_HEALTH = PROTO_HEALTH, /**< v = CPU load, idle share and control interrupt
+                                     share (1/1000), dropped records */
+   TELEM_TASK = PROTO_TASK,     /**< law = task number, torque = CPU share (1/1000),
+                                     v = stack high-water mark (words), cycles run,
+                                     1 for the idle task */
+   TELEM_TIMING = PROTO_TIMING  /**< v = worst and mean control interrupt latency,
+                                     longest control period (cycles), overruns */
+} telemType_t;
+
+/** @brief What happens to the state records, see telemSetLogging() **/
+typedef enum {
+   TELEM_LOG_OFF = 0,     /**< not sent */
+   TELEM_LOG_FULL,        /**< one STATE message each */
+   TELEM_LOG_DELTA        /**< batched in STATE_DELTA messages, see proto.h */
+} telemLog_t;
+
+/** @brief One telemetry record, copied by value through the queue: 24
+ *  bytes, no padding. Everything after type is sent as is as the
+ *  protoRecord_t body.
+ */
+typedef struct {
+   uint8_t type;
+   uint8_t law;
+   int16_t torque;
+   uint32_t time;      /**< clockUs() */
+   int32_t v[4];
+} telemRecord_t;
+
+uint8_t telemInit(UART_HandleTypeDef * huart);
+uint8_t telemPost(const telemRecord_t * r);
+telemRecord_t * telemReserve(void);
+void telemCommit(void);
+uint8_t * telemReserveBody(uint8_t id, uint16_t len);
+void telemCommitBody(uint16_t len);
+uint32_t telemDrops(void);
+uint16_t telemDecim(void);
+uint8_t telemSetLogging(uint8_t mode);
+uint8_t telemLogging(void);
+void telemSetBaud(uint32_t baud);
+void telemSend(uint8_t id, const void * body, uint16_t len);
+void telemDrain(void);
+void telemRun(void);
+void telemPanic(const char * text, uint16_t len);
+
+#endif
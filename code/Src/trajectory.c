@@ -0,0 +1,170 @@
+#include "trajectory.h"
+
+
+//-------------------------------------------------------------------------------------
+/** @brief   Integer square root
+ *  @param   x Value to take the root of
+ *  @return  floor(sqrt(x))
+ */
+static uint32_t isqrt64(uint64_t x) {
+   uint64_t res = 0;
+   uint64_t bit = (uint64_t)1 << 62;
+
+   while(bit > x) {
+      bit >>= 2;
+   }
+   while(bit) {
+      if(x >= res + bit) {
+         x -= res + bit;
+         res = (res >> 1) + bit;
+      } else {
+         res >>= 1;
+      }
+      bit >>= 2;
+   }
+   return (uint32_t)res;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Start a trajectory at rest at the given position
+ *  @param   t Trajectory to initialize
+ *  @param   pos Starting position in counts
+ *  @param   vmax Velocity limit, Q16 counts/tick
+ *  @param   amax Acceleration limit, Q16 counts/tick^2
+ *  @param   jmax Jerk limit, Q16 counts/tick^3
+ */
+void trajInit(traj_t * t, int32_t pos, int32_t vmax, int32_t amax, int32_t jmax) {
+   t->pos = (int64_t)pos << TRAJ_Q;
+   t->target = t->pos;
+   t->vel = 0;
+   t->acc = 0;
+   trajSetLimits(t, vmax, amax, jmax);
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Change the motion limits, takes effect on the next step
+ *  @param   t Trajectory to update
+ *  @param   vmax Velocity limit, Q16 counts/tick
+ *  @param   amax Acceleration limit, Q16 counts/tick^2
+ *  @param   jmax Jerk limit, Q16 counts/tick^3
+ */
+void trajSetLimits(traj_t * t, int32_t vmax, int32_t amax, int32_t jmax) {
+   t->vmax = vmax > 0 ? vmax : 1;
+   t->amax = amax > 0 ? amax : 1;
+   t->jmax = jmax > 0 ? jmax : 1;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Move the target; the reference keeps its current velocity and
+ *           acceleration, so the target can change mid-move
+ *  @param   t Trajectory to update
+ *  @param   target New target position in counts
+ */
+void trajSetTarget(traj_t * t, int32_t target) {
+   t->target = (int64_t)target << TRAJ_Q;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Distance needed to come to rest with jerk limited braking
+ *  @details Closed form for the S-curve that first brings the acceleration
+ *           to zero (or, when already braking, for the virtual profile that
+ *           started at zero acceleration) and then brakes to rest with the
+ *           deceleration ramped in and out at jmax.
+ *  @param   t Trajectory holding the limits
+ *  @param   v Velocity toward the target, Q16
+ *  @param   a Acceleration toward the target, Q16; v must be positive if
+ *           a is negative, and v + a^2 / 2j must be positive either way
+ *  @return  Stopping distance in Q16 counts
+ */
+static int64_t stopDistance(const traj_t * t, int64_t v, int64_t a) {
+   int64_t j = t->jmax;
+   int64_t am = t->amax;
+   int64_t v1 = v + a * a / (2 * j);
+   int64_t pre, d;
+
+   if(a >= 0) {
+      /* distance covered while ramping a down to zero */
+      pre = v * a / j + a * a * a / (3 * j * j);
+   } else {
+      /* distance the virtual profile already covered before now */
+      pre = -(v1 * -a / j - (-a) * a * a / (6 * j * j));
+   }
+
+   if(v1 >= am * am / j) {
+      d = v1 * v1 / (2 * am) + v1 * am / (2 * j);
+   } else {
+      d = v1 * isqrt64(((uint64_t)v1 << 32) / j) >> TRAJ_Q;
+   }
+   return d + pre;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Advance the reference by one tick
+ *  @details The problem is mirrored so the target is ahead. If braking now
+ *           would still overshoot, the acceleration is driven toward
+ *           -amax but never below -sqrt(2 jmax v), the curve on which a
+ *           ramp back to zero removes exactly the remaining velocity.
+ *           Otherwise the reference accelerates toward vmax the same way.
+ *           The jerk is the clamped change of acceleration, so all three
+ *           limits hold every tick.
+ *  @param   t Trajectory to advance
+ */
+void trajStep(traj_t * t) {
+   int64_t e = t->target - t->pos;
+   int64_t s = e < 0 ? -1 : 1;
+   int64_t v = s * t->vel;
+   int64_t a = s * t->acc;
+   int64_t j = t->jmax;
+   int64_t at;
+
+   if(s * e <= (1 << TRAJ_Q) && (v < 0 ? -v : v) <= t->amax
+      && (a < 0 ? -a : a) <= j) {
+      t->pos = t->target;
+      t->vel = 0;
+      t->acc = 0;
+      return;
+   }
+
+   /* brake if stopping from the state one tick ahead would overshoot */
+   if((v > 0 || a > 0) && v + a * a / (2 * j) > 0
+      && stopDistance(t, v, a) + v >= s * e) {
+      /* brake, following a = -sqrt(2 j v) at the end so a and v reach
+         zero together */
+      at = -(int64_t)isqrt64(2 * (uint64_t)j * v);
+      if(at < -t->amax) {
+         at = -t->amax;
+      }
+   } else {
+      /* speed up, easing a to zero the same way as v reaches vmax */
+      at = t->vmax > v ? isqrt64(2 * (uint64_t)j * (t->vmax - v)) : 0;
+      if(at > t->amax) {
+         at = t->amax;
+      }
+   }
+
+   if(at > a + j) {
+      at = a + j;
+   }
+   if(at < a - j) {
+      at = a - j;
+   }
+   t->acc = s * at;
+
+   t->vel += t->acc;
+   if(t->vel > t->vmax) {
+      t->vel = t->vmax;
+   }
+   if(t->vel < -t->vmax) {
+      t->vel = -t->vmax;
+   }
+   t->pos += t->vel;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Check if the reference has settled on the target
+ *  @param   t Trajectory to check
+ *  @return  1 when at rest on the target, 0 while moving
+ */
+uint8_t trajDone(const traj_t * t) {
+   return t->pos == t->target && t->vel == 0 && t->acc == 0;
+}
@@ -0,0 +1,32 @@
+#ifndef TRAJECTORY_H
+#define TRAJECTORY_H
+#include <stdint.h>
+
+/** @brief Fractional bits of the trajectory state **/
+#define TRAJ_Q 16
+
+/** @brief Jerk limited (S-curve) setpoint generator, one step per control tick
+ *
+ *  Position is in capture counts, velocity in counts/tick, acceleration in
+ *  counts/tick^2 and jerk in counts/tick^3, all in Q16.
+ */
+typedef struct {
+   int32_t vmax;
+   int32_t amax;
+   int32_t jmax;
+   int64_t target;
+   int64_t pos;
+   int32_t vel;
+   int32_t acc;
+} traj_t;
+
+void trajInit(traj_t * t, int32_t pos, int32_t vmax, int32_t amax, int32_t jmax);
+void trajSetLimits(traj_t * t, int32_t vmax, int32_t amax, int32_t jmax);
+void trajSetTarget(traj_t * t, int32_t target);
+void trajStep(traj_t * t);
+uint8_t trajDone(const traj_t * t);
+
+/** @brief Reference position in whole counts **/
+#define trajPos(t) ((int32_t)((t)->pos >> TRAJ_Q))
+
+#endif
@@ -1,7 +1,7 @@
 #include "trig.h"
 
-
-uint16_t LUT[THETA_MAX] = {  2048, 2051, 2054, 2057, 2060, 2063, 2066, 2069, 2073, 2076, 2079, 2082, 2085, 2088, 2091, 2095, 2098, 2101, 2104, 2107, 2110, 2113, 2117, 2120, 2123, 2126, 2129, 2132, 2135, 2139, 2142, 2145, 2148, 2151, 2154, 2157, 2161, 2164, 2167, 2170, 2173, 2176, 2179, 2182, 2186, 2189, 2192, 2195, 2198, 2201, 2204, 2208, 2211, 2214, 2217, 2220, 2223, 2226, 2229, 2233, 2236, 2239, 2242, 2245, 2248, 2251, 2254, 2258, 2261, 2264, 2267, 2270, 2273, 2276, 2279, 2283, 2286, 2289, 2292, 2295, 2298, 2301, 2304, 2308, 2311, 2314, 2317, 2320, 2323, 2326, 2329, 2332, 2336, 2339, 2342, 2345, 2348, 2351, 2354, 2357, 2360, 2364, 2367, 2370, 2373, 2376, 2379, 2382, 2385, 2388, 2391, 2395, 2398, 2401, 2404, 2407, 2410, 2413, 2416, 2419, 2422, 2425, 2429, 2432, 2435, 2438, 2441, 2444, 2447, 2450, 2453, 2456, 2459, 2462, 2466, 2469, 2472, 2475, 2478, 2481, 2484, 2487, 2490, 2493, 2496, 2499, 2502, 2505, 2508, 2512, 2515, 2518, 2521, 2524, 2527, 2530, 2533, 2536, 2539, 2542, 2545, 2548, 2551, 2554, 2557, 2560, 2563, 2566, 2569, 2573, 2576, 2579, 2582, 2585, 2588, 2591, 2594, 2597, 2600, 2603, 2606, 2609, 2612, 2615, 2618, 2621, 2624, 2627, 2630, 2633, 2636, 2639, 2642, 2645, 2648, 2651, 2654, 2657, 2660, 2663, 2666, 2669, 2672, 2675, 2678, 2681, 2684, 2687, 2690, 2693, 2696, 2699, 2702, 2705, 2708, 2711, 2714, 2717, 2720, 2723, 2726, 2729, 2732, 2734, 2737, 2740, 2743, 2746, 2749, 2752, 2755, 2758, 2761, 2764, 2767, 2770, 2773, 2776, 2779, 2782, 2785, 2787, 2790, 2793, 2796, 2799, 2802, 2805, 2808, 2811, 2814, 2817, 2820, 2823, 2825, 2828, 2831, 2834, 2837, 2840, 2843, 2846, 2849, 2852, 2854, 2857, 2860, 2863, 2866, 2869, 2872, 2875, 2877, 2880, 2883, 2886, 2889, 2892, 2895, 2897, 2900, 2903, 2906, 2909, 2912, 2915, 2917, 2920, 2923, 2926, 2929, 2932, 2934, 2937, 2940, 2943, 2946, 2949, 2951, 2954, 2957, 2960, 2963, 2965, 2968, 2971, 2974, 2977, 2980, 2982, 2985, 2988, 2991, 2993, 2996, 2999, 3002, 3005, 3007, 3010, 3013, 3016, 3018, 3021, 3024, 3027, 3030, 3032, 3035, 3038, 3041, 3043, 3046, 3049, 3051, 3054, 3057, 3060, 3062, 3065, 3068, 3071, 3073, 3076, 3079, 3081, 3084, 3087, 3090, 3092, 3095, 3098, 3100, 3103, 3106, 3108, 3111, 3114, 3117, 3119, 3122, 3125, 3127, 3130, 3133, 3135, 3138, 3141, 3143, 3146, 3148, 3151, 3154, 3156, 3159, 3162, 3164, 3167, 3170, 3172, 3175, 3177, 3180, 3183, 3185, 3188, 3191, 3193, 3196, 3198, 3201, 3204, 3206, 3209, 3211, 3214, 3216, 3219, 3222, 3224, 3227, 3229, 3232, 3234, 3237, 3240, 3242, 3245, 3247, 3250, 3252, 3255, 3257, 3260, 3262, 3265, 3267, 3270, 3273, 3275, 3278, 3280, 3283, 3285, 3288, 3290, 3293, 3295, 3298, 3300, 3303, 3305, 3307, 3310, 3312, 3315, 3317, 3320, 3322, 3325, 3327, 3330, 3332, 3335, 3337, 3339, 3342, 3344, 3347, 3349, 3352, 3354, 3356, 3359, 3361, 3364, 3366, 3368, 3371, 3373, 3376, 3378, 3380, 3383, 3385, 3388, 3390, 3392, 3395, 3397, 3399, 3402, 3404, 3406, 3409, 3411, 3414, 3416, 3418, 3421, 3423, 3425, 3428, 3430, 3432, 3434, 3437, 3439, 3441, 3444, 3446, 3448, 3451, 3453, 3455, \
+/* const, so the table stays in flash instead of taking 8 KB of RAM */
+const uint16_t LUT[THETA_MAX] = {  2048, 2051, 2054, 2057, 2060, 2063, 2066, 2069, 2073, 2076, 2079, 2082, 2085, 2088, 2091, 2095, 2098, 2101, 2104, 2107, 2110, 2113, 2117, 2120, 2123, 2126, 2129, 2132, 2135, 2139, 2142, 2145, 2148, 2151, 2154, 2157, 2161, 2164, 2167, 2170, 2173, 2176, 2179, 2182, 2186, 2189, 2192, 2195, 2198, 2201, 2204, 2208, 2211, 2214, 2217, 2220, 2223, 2226, 2229, 2233, 2236, 2239, 2242, 2245, 2248, 2251, 2254, 2258, 2261, 2264, 2267, 2270, 2273, 2276, 2279, 2283, 2286, 2289, 2292, 2295, 2298, 2301, 2304, 2308, 2311, 2314, 2317, 2320, 2323, 2326, 2329, 2332, 2336, 2339, 2342, 2345, 2348, 2351, 2354, 2357, 2360, 2364, 2367, 2370, 2373, 2376, 2379, 2382, 2385, 2388, 2391, 2395, 2398, 2401, 2404, 2407, 2410, 2413, 2416, 2419, 2422, 2425, 2429, 2432, 2435, 2438, 2441, 2444, 2447, 2450, 2453, 2456, 2459, 2462, 2466, 2469, 2472, 2475, 2478, 2481, 2484, 2487, 2490, 2493, 2496, 2499, 2502, 2505, 2508, 2512, 2515, 2518, 2521, 2524, 2527, 2530, 2533, 2536, 2539, 2542, 2545, 2548, 2551, 2554, 2557, 2560, 2563, 2566, 2569, 2573, 2576, 2579, 2582, 2585, 2588, 2591, 2594, 2597, 2600, 2603, 2606, 2609, 2612, 2615, 2618, 2621, 2624, 2627, 2630, 2633, 2636, 2639, 2642, 2645, 2648, 2651, 2654, 2657, 2660, 2663, 2666, 2669, 2672, 2675, 2678, 2681, 2684, 2687, 2690, 2693, 2696, 2699, 2702, 2705, 2708, 2711, 2714, 2717, 2720, 2723, 2726, 2729, 2732, 2734, 2737, 2740, 2743, 2746, 2749, 2752, 2755, 2758, 2761, 2764, 2767, 2770, 2773, 2776, 2779, 2782, 2785, 2787, 2790, 2793, 2796, 2799, 2802, 2805, 2808, 2811, 2814, 2817, 2820, 2823, 2825, 2828, 2831, 2834, 2837, 2840, 2843, 2846, 2849, 2852, 2854, 2857, 2860, 2863, 2866, 2869, 2872, 2875, 2877, 2880, 2883, 2886, 2889, 2892, 2895, 2897, 2900, 2903, 2906, 2909, 2912, 2915, 2917, 2920, 2923, 2926, 2929, 2932, 2934, 2937, 2940, 2943, 2946, 2949, 2951, 2954, 2957, 2960, 2963, 2965, 2968, 2971, 2974, 2977, 2980, 2982, 2985, 2988, 2991, 2993, 2996, 2999, 3002, 3005, 3007, 3010, 3013, 3016, 3018, 3021, 3024, 3027, 3030, 3032, 3035, 3038, 3041, 3043, 3046, 3049, 3051, 3054, 3057, 3060, 3062, 3065, 3068, 3071, 3073, 3076, 3079, 3081, 3084, 3087, 3090, 3092, 3095, 3098, 3100, 3103, 3106, 3108, 3111, 3114, 3117, 3119, 3122, 3125, 3127, 3130, 3133, 3135, 3138, 3141, 3143, 3146, 3148, 3151, 3154, 3156, 3159, 3162, 3164, 3167, 3170, 3172, 3175, 3177, 3180, 3183, 3185, 3188, 3191, 3193, 3196, 3198, 3201, 3204, 3206, 3209, 3211, 3214, 3216, 3219, 3222, 3224, 3227, 3229, 3232, 3234, 3237, 3240, 3242, 3245, 3247, 3250, 3252, 3255, 3257, 3260, 3262, 3265, 3267, 3270, 3273, 3275, 3278, 3280, 3283, 3285, 3288, 3290, 3293, 3295, 3298, 3300, 3303, 3305, 3307, 3310, 3312, 3315, 3317, 3320, 3322, 3325, 3327, 3330, 3332, 3335, 3337, 3339, 3342, 3344, 3347, 3349, 3352, 3354, 3356, 3359, 3361, 3364, 3366, 3368, 3371, 3373, 3376, 3378, 3380, 3383, 3385, 3388, 3390, 3392, 3395, 3397, 3399, 3402, 3404, 3406, 3409, 3411, 3414, 3416, 3418, 3421, 3423, 3425, 3428, 3430, 3432, 3434, 3437, 3439, 3441, 3444, 3446, 3448, 3451, 3453, 3455, \
 3457, 3460, 3462, 3464, 3466, 3469, 3471, 3473, 3476, 3478, 3480, 3482, 3485, 3487, 3489, 3491, 3493, 3496, 3498, 3500, 3502, 3505, 3507, 3509, 3511, 3513, 3516, 3518, 3520, 3522, 3524, 3526, 3529, 3531, 3533, 3535, 3537, 3539, 3542, 3544, 3546, 3548, 3550, 3552, 3554, 3557, 3559, 3561, 3563, 3565, 3567, 3569, 3571, 3573, 3575, 3578, 3580, 3582, 3584, 3586, 3588, 3590, 3592, 3594, 3596, 3598, 3600, 3602, 3604, 3606, 3608, 3611, 3613, 3615, 3617, 3619, 3621, 3623, 3625, 3627, 3629, 3631, 3633, 3635, 3637, 3639, 3641, 3643, 3644, 3646, 3648, 3650, 3652, 3654, 3656, 3658, 3660, 3662, 3664, 3666, 3668, 3670, 3672, 3674, 3675, 3677, 3679, 3681, 3683, 3685, 3687, 3689, 3691, 3692, 3694, 3696, 3698, 3700, 3702, 3704, 3705, 3707, 3709, 3711, 3713, 3715, 3716, 3718, 3720, 3722, 3724, 3726, 3727, 3729, 3731, 3733, 3734, 3736, 3738, 3740, 3742, 3743, 3745, 3747, 3749, 3750, 3752, 3754, 3756, 3757, 3759, 3761, 3762, 3764, 3766, 3768, 3769, 3771, 3773, 3774, 3776, 3778, 3779, 3781, 3783, 3784, 3786, 3788, 3789, 3791, 3793, 3794, 3796, 3798, 3799, 3801, 3803, 3804, 3806, 3807, 3809, 3811, 3812, 3814, 3815, 3817, 3818, 3820, 3822, 3823, 3825, 3826, 3828, 3829, 3831, 3833, 3834, 3836, 3837, 3839, 3840, 3842, 3843, 3845, 3846, 3848, 3849, 3851, 3852, 3854, 3855, 3857, 3858, 3860, 3861, 3862, 3864, 3865, 3867, 3868, 3870, 3871, 3873, 3874, 3875, 3877, 3878, 3880, 3881, 3882, 3884, 3885, 3887, 3888, 3889, 3891, 3892, 3893, 3895, 3896, 3898, 3899, 3900, 3902, 3903, 3904, 3906, 3907, 3908, 3909, 3911, 3912, 3913, 3915, 3916, 3917, 3919, 3920, 3921, 3922, 3924, 3925, 3926, 3927, 3929, 3930, 3931, 3932, 3934, 3935, 3936, 3937, 3938, 3940, 3941, 3942, 3943, 3944, 3946, 3947, 3948, 3949, 3950, 3951, 3953, 3954, 3955, 3956, 3957, 3958, 3959, 3961, 3962, 3963, 3964, 3965, 3966, 3967, 3968, 3969, 3970, 3972, 3973, 3974, 3975, 3976, 3977, 3978, 3979, 3980, 3981, 3982, 3983, 3984, 3985, 3986, 3987, 3988, 3989, 3990, 3991, 3992, 3993, 3994, 3995, 3996, 3997, 3998, 3999, 4000, 4001, 4002, 4003, 4004, 4005, 4005, 4006, 4007, 4008, 4009, 4010, 4011, 4012, 4013, 4014, 4014, 4015, 4016, 4017, 4018, 4019, 4020, 4020, 4021, 4022, 4023, 4024, 4025, 4025, 4026, 4027, 4028, 4029, 4029, 4030, 4031, 4032, 4033, 4033, 4034, 4035, 4036, 4036, 4037, 4038, 4039, 4039, 4040, 4041, 4042, 4042, 4043, 4044, 4044, 4045, 4046, 4046, 4047, 4048, 4048, 4049, 4050, 4050, 4051, 4052, 4052, 4053, 4054, 4054, 4055, 4056, 4056, 4057, 4057, 4058, 4059, 4059, 4060, 4060, 4061, 4061, 4062, 4063, 4063, 4064, 4064, 4065, 4065, 4066, 4066, 4067, 4067, 4068, 4068, 4069, 4069, 4070, 4070, 4071, 4071, 4072, 4072, 4073, 4073, 4074, 4074, 4075, 4075, 4076, 4076, 4076, 4077, 4077, 4078, 4078, 4079, 4079, 4079, 4080, 4080, 4080, 4081, 4081, 4082, 4082, 4082, 4083, 4083, 4083, 4084, 4084, 4084, 4085, 4085, 4085, 4086, 4086, 4086, 4087, 4087, 4087, 4087, 4088, 4088, 4088, 4088, 4089, 4089, 4089, 4089, 4090, 4090, 4090, 4090, 4091, 4091, 4091, 4091, 4091, 4092, 4092, 4092, 4092, 4092, 4093, 4093, 4093, 4093, 4093, \
 4093, 4093, 4094, 4094, 4094, 4094, 4094, 4094, 4094, 4094, 4095, 4095, 4095, 4095, 4095, 4095, 4095, 4095, 4095, 4095, 4095, 4095, 4095, 4095, 4095, 4095, 4095, 4095, 4095, 4095, 4096, 4095, 4095, 4095, 4095, 4095, 4095, 4095, 4095, 4095, 4095, 4095, 4095, 4095, 4095, 4095, 4095, 4095, 4095, 4095, 4095, 4094, 4094, 4094, 4094, 4094, 4094, 4094, 4094, 4093, 4093, 4093, 4093, 4093, 4093, 4093, 4092, 4092, 4092, 4092, 4092, 4091, 4091, 4091, 4091, 4091, 4090, 4090, 4090, 4090, 4089, 4089, 4089, 4089, 4088, 4088, 4088, 4088, 4087, 4087, 4087, 4087, 4086, 4086, 4086, 4085, 4085, 4085, 4084, 4084, 4084, 4083, 4083, 4083, 4082, 4082, 4082, 4081, 4081, 4080, 4080, 4080, 4079, 4079, 4079, 4078, 4078, 4077, 4077, 4076, 4076, 4076, 4075, 4075, 4074, 4074, 4073, 4073, 4072, 4072, 4071, 4071, 4070, 4070, 4069, 4069, 4068, 4068, 4067, 4067, 4066, 4066, 4065, 4065, 4064, 4064, 4063, 4063, 4062, 4061, 4061, 4060, 4060, 4059, 4059, 4058, 4057, 4057, 4056, 4056, 4055, 4054, 4054, 4053, 4052, 4052, 4051, 4050, 4050, 4049, 4048, 4048, 4047, 4046, 4046, 4045, 4044, 4044, 4043, 4042, 4042, 4041, 4040, 4039, 4039, 4038, 4037, 4036, 4036, 4035, 4034, 4033, 4033, 4032, 4031, 4030, 4029, 4029, 4028, 4027, 4026, 4025, 4025, 4024, 4023, 4022, 4021, 4020, 4020, 4019, 4018, 4017, 4016, 4015, 4014, 4014, 4013, 4012, 4011, 4010, 4009, 4008, 4007, 4006, 4005, 4005, 4004, 4003, 4002, 4001, 4000, 3999, 3998, 3997, 3996, 3995, 3994, 3993, 3992, 3991, 3990, 3989, 3988, 3987, 3986, 3985, 3984, 3983, 3982, 3981, 3980, 3979, 3978, 3977, 3976, 3975, 3974, 3973, 3972, 3970, 3969, 3968, 3967, 3966, 3965, 3964, 3963, 3962, 3961, 3959, 3958, 3957, 3956, 3955, 3954, 3953, 3951, 3950, 3949, 3948, 3947, 3946, 3944, 3943, 3942, 3941, 3940, 3938, 3937, 3936, 3935, 3934, 3932, 3931, 3930, 3929, 3927, 3926, 3925, 3924, 3922, 3921, 3920, 3919, 3917, 3916, 3915, 3913, 3912, 3911, 3909, 3908, 3907, 3906, 3904, 3903, 3902, 3900, 3899, 3898, 3896, 3895, 3893, 3892, 3891, 3889, 3888, 3887, 3885, 3884, 3882, 3881, 3880, 3878, 3877, 3875, 3874, 3873, 3871, 3870, 3868, 3867, 3865, 3864, 3862, 3861, 3860, 3858, 3857, 3855, 3854, 3852, 3851, 3849, 3848, 3846, 3845, 3843, 3842, 3840, 3839, 3837, 3836, 3834, 3833, 3831, 3829, 3828, 3826, 3825, 3823, 3822, 3820, 3818, 3817, 3815, 3814, 3812, 3811, 3809, 3807, 3806, 3804, 3803, 3801, 3799, 3798, 3796, 3794, 3793, 3791, 3789, 3788, 3786, 3784, 3783, 3781, 3779, 3778, 3776, 3774, 3773, 3771, 3769, 3768, 3766, 3764, 3762, 3761, 3759, 3757, 3756, 3754, 3752, 3750, 3749, 3747, 3745, 3743, 3742, 3740, 3738, 3736, 3734, 3733, 3731, 3729, 3727, 3726, 3724, 3722, 3720, 3718, 3716, 3715, 3713, 3711, 3709, 3707, 3705, 3704, 3702, 3700, 3698, 3696, 3694, 3692, 3691, 3689, 3687, 3685, 3683, 3681, 3679, 3677, 3675, 3674, 3672, 3670, 3668, 3666, 3664, 3662, 3660, 3658, 3656, 3654, 3652, 3650, 3648, 3646, 3644, 3643, 3641, 3639, 3637, 3635, 3633, 3631, 3629, 3627, 3625, 3623, 3621, 3619, 3617, 3615, 3613, 3611, 3608, 3606, 3604, 3602, 3600, 3598, 3596, 3594, 3592, 3590, \
 3588, 3586, 3584, 3582, 3580, 3578, 3575, 3573, 3571, 3569, 3567, 3565, 3563, 3561, 3559, 3557, 3554, 3552, 3550, 3548, 3546, 3544, 3542, 3539, 3537, 3535, 3533, 3531, 3529, 3526, 3524, 3522, 3520, 3518, 3516, 3513, 3511, 3509, 3507, 3505, 3502, 3500, 3498, 3496, 3493, 3491, 3489, 3487, 3485, 3482, 3480, 3478, 3476, 3473, 3471, 3469, 3466, 3464, 3462, 3460, 3457, 3455, 3453, 3451, 3448, 3446, 3444, 3441, 3439, 3437, 3434, 3432, 3430, 3428, 3425, 3423, 3421, 3418, 3416, 3414, 3411, 3409, 3406, 3404, 3402, 3399, 3397, 3395, 3392, 3390, 3388, 3385, 3383, 3380, 3378, 3376, 3373, 3371, 3368, 3366, 3364, 3361, 3359, 3356, 3354, 3352, 3349, 3347, 3344, 3342, 3339, 3337, 3335, 3332, 3330, 3327, 3325, 3322, 3320, 3317, 3315, 3312, 3310, 3307, 3305, 3303, 3300, 3298, 3295, 3293, 3290, 3288, 3285, 3283, 3280, 3278, 3275, 3273, 3270, 3267, 3265, 3262, 3260, 3257, 3255, 3252, 3250, 3247, 3245, 3242, 3240, 3237, 3234, 3232, 3229, 3227, 3224, 3222, 3219, 3216, 3214, 3211, 3209, 3206, 3204, 3201, 3198, 3196, 3193, 3191, 3188, 3185, 3183, 3180, 3177, 3175, 3172, 3170, 3167, 3164, 3162, 3159, 3156, 3154, 3151, 3148, 3146, 3143, 3141, 3138, 3135, 3133, 3130, 3127, 3125, 3122, 3119, 3117, 3114, 3111, 3108, 3106, 3103, 3100, 3098, 3095, 3092, 3090, 3087, 3084, 3081, 3079, 3076, 3073, 3071, 3068, 3065, 3062, 3060, 3057, 3054, 3051, 3049, 3046, 3043, 3041, 3038, 3035, 3032, 3030, 3027, 3024, 3021, 3018, 3016, 3013, 3010, 3007, 3005, 3002, 2999, 2996, 2993, 2991, 2988, 2985, 2982, 2980, 2977, 2974, 2971, 2968, 2965, 2963, 2960, 2957, 2954, 2951, 2949, 2946, 2943, 2940, 2937, 2934, 2932, 2929, 2926, 2923, 2920, 2917, 2915, 2912, 2909, 2906, 2903, 2900, 2897, 2895, 2892, 2889, 2886, 2883, 2880, 2877, 2875, 2872, 2869, 2866, 2863, 2860, 2857, 2854, 2852, 2849, 2846, 2843, 2840, 2837, 2834, 2831, 2828, 2825, 2823, 2820, 2817, 2814, 2811, 2808, 2805, 2802, 2799, 2796, 2793, 2790, 2787, 2785, 2782, 2779, 2776, 2773, 2770, 2767, 2764, 2761, 2758, 2755, 2752, 2749, 2746, 2743, 2740, 2737, 2734, 2732, 2729, 2726, 2723, 2720, 2717, 2714, 2711, 2708, 2705, 2702, 2699, 2696, 2693, 2690, 2687, 2684, 2681, 2678, 2675, 2672, 2669, 2666, 2663, 2660, 2657, 2654, 2651, 2648, 2645, 2642, 2639, 2636, 2633, 2630, 2627, 2624, 2621, 2618, 2615, 2612, 2609, 2606, 2603, 2600, 2597, 2594, 2591, 2588, 2585, 2582, 2579, 2576, 2573, 2569, 2566, 2563, 2560, 2557, 2554, 2551, 2548, 2545, 2542, 2539, 2536, 2533, 2530, 2527, 2524, 2521, 2518, 2515, 2512, 2508, 2505, 2502, 2499, 2496, 2493, 2490, 2487, 2484, 2481, 2478, 2475, 2472, 2469, 2466, 2462, 2459, 2456, 2453, 2450, 2447, 2444, 2441, 2438, 2435, 2432, 2429, 2425, 2422, 2419, 2416, 2413, 2410, 2407, 2404, 2401, 2398, 2395, 2391, 2388, 2385, 2382, 2379, 2376, 2373, 2370, 2367, 2364, 2360, 2357, 2354, 2351, 2348, 2345, 2342, 2339, 2336, 2332, 2329, 2326, 2323, 2320, 2317, 2314, 2311, 2308, 2304, 2301, 2298, 2295, 2292, 2289, 2286, 2283, 2279, 2276, 2273, 2270, 2267, 2264, 2261, 2258, 2254, 2251, 2248, 2245, 2242, 2239, 2236, 2233, 2229, 2226, \
@@ -0,0 +1,55 @@
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+/*
+ * Kernel configuration for the host build, which takes the kernel and its
+ * Posix port from a FreeRTOS-Kernel checkout (see the Makefile). Kept as close to Inc/FreeRTOSConfig.h as the port allows: same
+ * priorities, tick rate, allocation scheme and API set, so the tasks see
+ * the same scheduler. The differences:
+ *
+ *  - generic task selection, the optimised one needs CLZ
+ *  - the tick hook is on, the latency benchmark timestamps ticks with it
+ *  - the run time counter is the port's own, portmacro.h defines it
+ *  - configASSERT reports and aborts instead of spinning
+ */
+
+#include <stdint.h>
+extern uint32_t SystemCoreClock;
+void hostAssert(const char * file, int line);
+
+#define configUSE_PREEMPTION                     1
+#define configSUPPORT_STATIC_ALLOCATION          1
+#define configSUPPORT_DYNAMIC_ALLOCATION         0
+#define configUSE_IDLE_HOOK                      0
+#define configUSE_TICK_HOOK                      1
+#define configGENERATE_RUN_TIME_STATS            1
+#define configUSE_TRACE_FACILITY                 1
+#define configUSE_STATS_FORMATTING_FUNCTIONS     0
+#define configCPU_CLOCK_HZ                       ( SystemCoreClock )
+#define configTICK_RATE_HZ                       ((TickType_t)1000)
+#define configMAX_PRIORITIES                     ( 7 )
+#define configMINIMAL_STACK_SIZE                 ((uint16_t)128)
+#define configMAX_TASK_NAME_LEN                  ( 16 )
+#define configUSE_16_BIT_TICKS                   0
+#define configUSE_MUTEXES                        1
+#define configQUEUE_REGISTRY_SIZE                8
+#define configUSE_PORT_OPTIMISED_TASK_SELECTION  0
+#define configUSE_TIMERS                         0
+
+#define configUSE_CO_ROUTINES                    0
+#define configMAX_CO_ROUTINE_PRIORITIES          ( 2 )
+
+#define INCLUDE_vTaskPrioritySet            1
+#define INCLUDE_uxTaskPriorityGet           1
+#define INCLUDE_vTaskDelete                 1
+#define INCLUDE_vTaskCleanUpResources       0
+#define INCLUDE_vTaskSuspend                1
+#define INCLUDE_vTaskDelayUntil             1
+#define INCLUDE_vTaskDelay                  1
+#define INCLUDE_xTaskGetSchedulerState      1
+#define INCLUDE_uxTaskGetStackHighWaterMark 1
+#define INCLUDE_xTaskGetIdleTaskHandle      1
+
+#define configASSERT( x ) if ((x) == 0) { hostAssert(__FILE__, __LINE__); }
+
+#endif /* FREERTOS_CONFIG_H */
@@ -0,0 +1,404 @@
+/*
+ * Scheduling latency benchmark for the host build.
+ *
+ * Runs the unmodified firmware (tasks, control interrupt, telemetry) on
+ * the FreeRTOS Posix port and measures, alongside it:
+ *
+ *  - control interrupt latency, period boundary to callback entry
+ *  - task wake-up latency, tick to the return from vTaskDelayUntil(), for
+ *    a probe task at the top priority and one at the lowest application
+ *    priority
+ *
+ * and decodes the firmware's own framed telemetry for the control
+ * overruns and the dropped records. It also plays the host side of the
+ * link setup (proto.h), so the firmware negotiates its fastest rate and
+ * sends every state record, and once the link is up reads a gain back
+ * through the command channel. Nothing runs the motor at boot, so the
+ * control interrupt starts right away.
+ *
+ * Usage: host-bench [seconds [max latency us [max overruns]]] [-v]
+ * Exits non-zero if no state records arrive, if the top priority probe
+ * sees a wake-up later than the limit, if the control tick overran more
+ * often than allowed, if a frame is corrupt or missing (the emulated
+ * link is lossless), if the link stays at the safe rate, or if the
+ * command is not answered correctly. -v prints every record: type, time, law,
+ * torque, v[0..3].
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "telemetry.h"
+#include "link.h"
+#include "control.h"
+#include "host.h"
+
+/** @brief Histogram buckets, 1 us each, the last one collects the rest **/
+#define BENCH_BUCKETS 5000
+/** @brief Ticks the tick time ring remembers **/
+#define BENCH_TICK_RING 1024
+/** @brief Seconds to wait for the control interrupt to start **/
+#define BENCH_START_TIMEOUT 60
+
+/** @brief Latency distribution of one source **/
+typedef struct {
+   const char * name;
+   uint32_t n;
+   uint64_t sum;
+   uint64_t max;
+   uint32_t bucket[BENCH_BUCKETS];
+} latency_t;
+
+static latency_t irqLatency = {"control irq"};
+static latency_t highLatency = {"top prio task"};
+static latency_t lowLatency = {"low prio task"};
+
+static volatile uint64_t tickNs[BENCH_TICK_RING];
+static volatile uint64_t irqStartNs;
+
+static uint32_t runSeconds = 10;
+static uint32_t maxLatencyUs = 2000;
+static uint32_t maxOverruns = 0;
+static uint8_t verbose;
+
+/* decoded telemetry */
+static uint32_t stateRecords, healthRecords, taskRecords, timingRecords;
+static long overruns, drops, fwLatencyMax;
+static uint32_t badFrames, lostFrames, linkOffers, cmdReplies;
+
+static StaticTask_t highTcb, lowTcb;
+static StackType_t highStack[configMINIMAL_STACK_SIZE];
+static StackType_t lowStack[configMINIMAL_STACK_SIZE];
+
+
+//-------------------------------------------------------------------------------------
+/** @brief   Add a sample to a distribution
+ *  @param   l Distribution
+ *  @param   ns Latency in ns
+ */
+static void latencyAdd(latency_t * l, uint64_t ns) {
+   uint64_t us = ns / 1000;
+
+   l->bucket[us < BENCH_BUCKETS ? us : BENCH_BUCKETS - 1]++;
+   l->sum += ns;
+   if(ns > l->max) {
+      l->max = ns;
+   }
+   l->n++;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Latency below which a share of the samples lie
+ *  @param   l Distribution
+ *  @param   permille Share in 1/1000
+ *  @return  Upper bucket edge in us
+ */
+static uint32_t latencyQuantile(const latency_t * l, uint32_t permille) {
+   uint64_t want = (uint64_t)l->n * permille / 1000;
+   uint64_t seen = 0;
+   uint32_t us;
+
+   for(us = 0; us < BENCH_BUCKETS - 1; us++) {
+      seen += l->bucket[us];
+      if(seen >= want) {
+         break;
+      }
+   }
+   return us + 1;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Print one distribution
+ *  @param   l Distribution
+ */
+static void latencyPrint(const latency_t * l) {
+   printf("%-14s n %7lu  mean %6.1f  p99 %5lu  p999 %5lu  max %7.1f us\n",
+          l->name, (unsigned long)l->n, l->n ? l->sum / 1000.0 / l->n : 0.0,
+          (unsigned long)latencyQuantile(l, 990), (unsigned long)latencyQuantile(l, 999),
+          l->max / 1000.0);
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Print the results and exit with the verdict
+ *  @details Called from a task, with the scheduler suspended so no other
+ *           task is stopped holding the stdio lock.
+ */
+static void benchReport(void) {
+   int fail = 0;
+
+   vTaskSuspendAll();
+   latencyPrint(&irqLatency);
+   latencyPrint(&highLatency);
+   latencyPrint(&lowLatency);
+   printf("telemetry      state %lu  timing %lu  health %lu  task %lu\n",
+          (unsigned long)stateRecords, (unsigned long)timingRecords,
+          (unsigned long)healthRecords, (unsigned long)taskRecords);
+   printf("firmware       overruns %ld  dropped %ld  worst latency %ld cycles\n",
+          overruns, drops, fwLatencyMax);
+   printf("link           %lu baud after %lu offers  bad frames %lu  lost frames %lu"
+          "  command replies %lu\n", (unsigned long)linkBaud(), (unsigned long)linkOffers,
+          (unsigned long)badFrames, (unsigned long)lostFrames, (unsigned long)cmdReplies);
+
+   if(!stateRecords) {
+      printf("FAIL: no state records\n");
+      fail = 1;
+   }
+   if(badFrames || lostFrames) {
+      printf("FAIL: telemetry frames corrupt or lost\n");
+      fail = 1;
+   }
+   if(linkBaud() == PROTO_SAFE_BAUD) {
+      printf("FAIL: link stayed at the safe rate\n");
+      fail = 1;
+   }
+   if(!cmdReplies) {
+      printf("FAIL: no good command reply\n");
+      fail = 1;
+   }
+   if(highLatency.max > maxLatencyUs * 1000ULL) {
+      printf("FAIL: top priority wake-up latency above %lu us\n", (unsigned long)maxLatencyUs);
+      fail = 1;
+   }
+   if(overruns > (long)maxOverruns) {
+      printf("FAIL: %ld control overruns, %lu allowed\n", overruns, (unsigned long)maxOverruns);
+      fail = 1;
+   }
+   if(!fail) {
+      printf("PASS\n");
+   }
+   fflush(stdout);
+   exit(fail);
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Timestamp every tick
+ *  @details Called by the kernel after the tick count was incremented and
+ *           the delayed tasks were unblocked.
+ */
+void vApplicationTickHook(void) {
+   tickNs[xTaskGetTickCountFromISR() % BENCH_TICK_RING] = hostNs();
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Control interrupt entry, called by the emulated TIM4
+ *  @param   ns Time since the period boundary
+ */
+void hostIrqLatency(uint64_t ns) {
+   if(!irqStartNs) {
+      irqStartNs = hostNs();
+   }
+   latencyAdd(&irqLatency, ns);
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Take in one telemetry record
+ *  @param   r Record as sent
+ */
+static void benchRecord(const telemRecord_t * r) {
+   char line[96];
+   int len;
+
+   if(r->type == TELEM_STATE) {
+      stateRecords++;
+   } else if(r->type == TELEM_TASK) {
+      taskRecords++;
+   } else if(r->type == TELEM_HEALTH) {
+      healthRecords++;
+      drops = r->v[3];
+   } else if(r->type == TELEM_TIMING) {
+      timingRecords++;
+      if(r->v[0] > fwLatencyMax) {
+         fwLatencyMax = r->v[0];
+      }
+      overruns = r->v[3];
+   }
+   if(verbose) {
+      len = snprintf(line, sizeof(line), "%u %lu %u %d %ld %ld %ld %ld\n", r->type,
+                     (unsigned long)r->time, r->law, r->torque, (long)r->v[0],
+                     (long)r->v[1], (long)r->v[2], (long)r->v[3]);
+      (void)!write(STDOUT_FILENO, line, len);
+   }
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Send a message to the firmware
+ *  @details Fed straight into the receive path, as if from the interrupt.
+ *  @param   id Message id
+ *  @param   body Body
+ *  @param   len Body bytes
+ */
+static void benchSend(uint8_t id, const void * body, uint16_t len) {
+   static uint16_t seq;
+   uint8_t frame[PROTO_FRAME_MAX(PROTO_BODY_MAX)];
+   uint16_t n, i;
+
+   n = protoFrame(id, seq++, body, len, frame);
+   for(i = 0; i < n; i++) {
+      linkRxByte(frame[i]);
+   }
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Send a link setup message to the firmware
+ *  @param   id Message id
+ *  @param   baud Body baud
+ *  @param   n Body count
+ */
+static void benchReply(uint8_t id, uint32_t baud, uint32_t n) {
+   protoLink_t msg;
+
+   msg.baud = baud;
+   msg.n = n;
+   benchSend(id, &msg, sizeof(msg));
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Host side of the link setup: accept every rate, check the test
+ *  @param   id Message id
+ *  @param   body Body
+ *  @param   len Body bytes
+ */
+static void benchLink(uint8_t id, const uint8_t * body, uint16_t len) {
+   static uint32_t good;
+   protoLink_t msg;
+   uint8_t k;
+
+   memcpy(&msg, body, sizeof(msg));
+   if(id == PROTO_LINK_OFFER) {
+      linkOffers++;
+      good = 0;
+      benchReply(PROTO_LINK_ACCEPT, msg.baud, 0);
+   } else if(id == PROTO_LINK_TEST && len == sizeof(msg) + PROTO_LINK_PATTERN) {
+      for(k = 0; k < PROTO_LINK_PATTERN; k++) {
+         if(body[sizeof(msg) + k] != PROTO_LINK_BYTE(msg.n, k)) {
+            badFrames++;
+            return;
+         }
+      }
+      if(++good == PROTO_LINK_FRAMES) {
+         protoParam_t get = { PROTO_PARAM_KP, 0 };
+         benchReply(PROTO_LINK_RESULT, msg.baud, good);
+         benchSend(PROTO_CMD_GET, &get, sizeof(get));
+      }
+   } else {
+      badFrames++;
+   }
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   UART output of the firmware, split into frames
+ *  @details Called from the emulated DMA only. Collects bytes up to the 0
+ *           that ends a frame, then decodes and checks it (proto.h) and
+ *           counts gaps in the frame counter. The echo uses write(),
+ *           which takes no lock a suspended task could be holding.
+ *  @param   data Bytes sent
+ *  @param   len Number of bytes
+ */
+void hostUartWrite(const uint8_t * data, uint16_t len) {
+   static uint8_t frame[PROTO_FRAME_MAX(PROTO_BODY_MAX)];
+   static uint16_t fill;
+   static uint16_t nextSeq;
+   static uint8_t synced;
+   telemRecord_t r;
+   uint16_t n;
+   uint16_t seq;
+   uint16_t i;
+
+   for(i = 0; i < len; i++) {
+      if(data[i] != 0) {
+         if(fill < sizeof(frame)) {
+            frame[fill] = data[i];
+         }
+         fill++;
+         continue;
+      }
+      n = fill <= sizeof(frame) ? protoCobsDecode(frame, fill) : 0;
+      fill = 0;
+      if(!protoParse(frame, n, &r.type, &seq)) {
+         badFrames++;
+         continue;
+      }
+      if(synced) {
+         lostFrames += (uint16_t)(seq - nextSeq);
+      }
+      synced = 1;
+      nextSeq = seq + 1;
+      n -= PROTO_OVERHEAD;
+      if(r.type == PROTO_CMD_REPLY && n == sizeof(protoReply_t)) {
+         protoReply_t reply;
+         memcpy(&reply, frame + 3, sizeof(reply));
+         if(reply.cmd == PROTO_CMD_GET && reply.status == PROTO_OK &&
+            reply.value == ctrlParams.kp) {
+            cmdReplies++;
+         } else {
+            badFrames++;
+         }
+      } else if(r.type >= PROTO_LINK_OFFER && r.type <= PROTO_LINK_DOWN &&
+                n >= sizeof(protoLink_t)) {
+         benchLink(r.type, frame + 3, n);
+      } else if(r.type >= PROTO_STATE && r.type <= PROTO_TIMING && n == PROTO_RECORD_LEN) {
+         memcpy(&r.law, frame + 3, PROTO_RECORD_LEN);
+         benchRecord(&r);
+      } else {
+         badFrames++;
+      }
+   }
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Wake up every tick and record how late
+ *  @details The top priority probe also ends the run, once the control
+ *           interrupt ran for the requested time.
+ *  @param   arg Distribution to record into
+ */
+static void probeTask(void * arg) {
+   latency_t * l = arg;
+   TickType_t wake = xTaskGetTickCount();
+   uint64_t start = hostNs();
+
+   for(;;) {
+      vTaskDelayUntil(&wake, 1);
+      latencyAdd(l, hostNs() - tickNs[wake % BENCH_TICK_RING]);
+
+      if(l != &highLatency) {
+         continue;
+      }
+      if(irqStartNs && hostNs() - irqStartNs >= runSeconds * 1000000000ULL) {
+         benchReport();
+      }
+      if(!irqStartNs && hostNs() - start >= BENCH_START_TIMEOUT * 1000000000ULL) {
+         vTaskSuspendAll();
+         printf("FAIL: control interrupt not started after %d s\n", BENCH_START_TIMEOUT);
+         exit(1);
+      }
+   }
+}
+
+void hostAssert(const char * file, int line) {
+   fprintf(stderr, "assert %s:%d\n", file, line);
+   abort();
+}
+
+int main(int argc, char ** argv) {
+   uint32_t * arg[] = {&runSeconds, &maxLatencyUs, &maxOverruns};
+   uint32_t n = 0;
+   int i;
+
+   for(i = 1; i < argc; i++) {
+      if(!strcmp(argv[i], "-v")) {
+         verbose = 1;
+      } else if(n < sizeof(arg) / sizeof(arg[0])) {
+         *arg[n++] = strtoul(argv[i], NULL, 0);
+      }
+   }
+   setvbuf(stdout, NULL, _IOLBF, 0);
+
+   xTaskCreateStatic(probeTask, "probeHigh", configMINIMAL_STACK_SIZE,
+                     &highLatency, configMAX_PRIORITIES - 1, highStack, &highTcb);
+   xTaskCreateStatic(probeTask, "probeLow", configMINIMAL_STACK_SIZE,
+                     &lowLatency, tskIDLE_PRIORITY + 1, lowStack, &lowTcb);
+
+   return firmwareMain();
+}
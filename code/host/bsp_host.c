@@ -0,0 +1,98 @@
+/*
+ * Board support on Linux, see Src/bsp.h. There is no hardware behind it,
+ * only variables the program around the control code plays the plant
+ * with: it puts the arm capture and the pendulum encoder reading into
+ * hostArm and hostPendulum before each tick and takes the phase duties
+ * from hostDuty after it. Cycles follow the monotonic clock at
+ * HOST_CORE_HZ, and the store is a RAM copy of the ILC page that lasts
+ * as long as the process.
+ */
+#define _GNU_SOURCE
+#include <string.h>
+#include <time.h>
+#include "bsp.h"
+#include "host.h"
+
+volatile uint16_t hostArm;
+volatile uint16_t hostPendulum;
+volatile uint16_t hostDuty[3];
+
+static uint16_t store[BSP_STORE_BYTES / 2] = { [0 ... BSP_STORE_BYTES / 2 - 1] = 0xFFFF };
+
+
+//-------------------------------------------------------------------------------------
+/** @brief   Monotonic host time
+ *  @return  Nanoseconds
+ */
+uint64_t hostNs(void) {
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Motor off
+ */
+void bspInit(void) {
+   bspPwm(0, 0, 0);
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Arm capture count
+ *  @return  hostArm
+ */
+uint16_t bspArmCapture(void) {
+   return hostArm;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Pendulum encoder reading
+ *  @return  hostPendulum
+ */
+uint16_t bspPendEncoder(void) {
+   return hostPendulum;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Phase duties, into hostDuty
+ *  @param   a The 12 bit duty cycle of phase 1
+ *  @param   b The 12 bit duty cycle of phase 2
+ *  @param   c The 12 bit duty cycle of phase 3
+ */
+void bspPwm(uint16_t a, uint16_t b, uint16_t c) {
+   hostDuty[0] = a;
+   hostDuty[1] = b;
+   hostDuty[2] = c;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Core cycles, from the host clock
+ *  @return  Nanoseconds in HOST_CORE_HZ cycles, wrapping like DWT->CYCCNT
+ */
+uint32_t bspCycles(void) {
+   return (uint32_t)(hostNs() * (HOST_CORE_HZ / 1000000) / 1000);
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Storage kept for the life of the process
+ *  @return  BSP_STORE_BYTES, all 0xFF when never written
+ */
+const void * bspStore(void) {
+   return store;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Replace what bspStore() holds, the rest reads 0xFF after
+ *  @param   data Data
+ *  @param   len Bytes, even, at most BSP_STORE_BYTES
+ *  @return  1 if written, 0 if too long
+ */
+uint8_t bspStoreWrite(const void * data, uint16_t len) {
+   if(len > BSP_STORE_BYTES || len & 1) {
+      return 0;
+   }
+   memset(store, 0xFF, sizeof(store));
+   memcpy(store, data, len);
+   return 1;
+}
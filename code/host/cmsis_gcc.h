@@ -0,0 +1,8 @@
+#ifndef HOST_CMSIS_GCC_H
+#define HOST_CMSIS_GCC_H
+
+/* cmsis_os.c includes this for __get_IPSR(); the host versions of the
+   intrinsics live with the register stand-ins */
+#include "stm32f1xx.h"
+
+#endif
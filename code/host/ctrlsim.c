@@ -0,0 +1,537 @@
+/*
+ * The control code on a simulated Furuta pendulum, linked against the
+ * native library "make host" builds (libcontrol.a, bsp_host.c as board).
+ *
+ * The plant is the nonlinear rigid body model of the rig tools/empc_gen.c
+ * linearizes plus Coulomb friction on the arm, integrated with RK4
+ * between control ticks. Each tick runs what the control interrupt in
+ * main.c runs: the plant's encoder counts go into hostArm and
+ * hostPendulum, then ctrlSense(), ctrlStep(), setMotorTorque() and
+ * identLog(); run() calls identProcess() in between as the housekeeping
+ * task does. The torque the plant sees is read back from the three
+ * phase duties in hostDuty by projecting them onto the commutation pattern
+ * at the rotor angle, so commutation is checked on every tick as well.
+ *
+ * Scenarios: the friction identification, one swing-up learning trial,
+ * the arm P holding its setpoint against a step load, the arm PID
+ * following a setpoint step with the pendulum down, P with the pendulum
+ * swinging, after which the online identification (ident.h) must have
+ * found the pendulum's w0^2, and LQR and EMPC catching the pendulum
+ * from a few degrees off upright; before those, the ILC profile round
+ * trip through bspStore(), a switch to CTRL_OFF in the middle of a blend
+ * a burst capture armed, triggered and dumped, and fmt.h lines at the
+ * edges of rounding, range and buffer size. Each
+ * reports ns per control tick on this machine. The swing-up itself is
+ * only checked for running its trial, it gets the pendulum up only over
+ * several of them.
+ *
+ * Usage: ctrlsim
+ * Exits non-zero if a check fails.
+ */
+#include <math.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "host.h"
+#include "bsp.h"
+#include "motor.h"
+#include "trig.h"
+#include "control.h"
+#include "ilc.h"
+#include "friction.h"
+#include "ident.h"
+#include "capture.h"
+#include "fmt.h"
+
+/* the plant, as in tools/empc_gen.c */
+#define MR   0.095            /* arm mass */
+#define LR   0.085            /* arm length */
+#define MP   0.024            /* pendulum mass */
+#define LP   0.129            /* pendulum length */
+#define DR   0.0015           /* arm damping */
+#define DP   0.0005           /* pendulum damping */
+#define GRAV 9.81
+#define TAU_MAX 0.06          /* torque at a command of 1000 */
+/* arm Coulomb friction, the nominal level of frictionInit(), smoothed
+   below SIM_FRIC_VEL so RK4 stays stable */
+#define SIM_COULOMB 120
+#define SIM_FRIC_VEL 0.1
+
+/* w0^2 of the pendulum, a rod swinging about its end */
+#define SIM_W0SQ (3.0 * GRAV / (2.0 * LP))
+
+#define COUNTS_PER_RAD (65536.0 / (2.0 * M_PI))
+/** @brief RK4 steps per control tick **/
+#define SIM_SUBSTEPS 4
+/** @brief Largest difference between the commanded and the decoded torque **/
+#define SIM_TORQUE_TOL 2
+/** @brief Largest pendulum angle from upright after balancing, rad **/
+#define SIM_BALANCE_TOL 0.02
+/** @brief Largest arm angle from the setpoint under a step load, rad **/
+#define SIM_LOAD_TOL 0.03
+/** @brief Largest arm angle from its setpoint after balancing, rad; the
+    friction compensation leaves a slow limit cycle of the arm within it **/
+#define SIM_ARM_DRIFT 0.15
+
+/** @brief Arm angle, pendulum angle from upright, their rates; rad, rad/s **/
+typedef struct {
+   double x[4];
+} plant_t;
+
+/** @brief Capture count with the arm at 0, anything away from 0 **/
+static const uint16_t captureZero = 20000;
+
+static ctrlState_t state;
+static ilc_t learnIlc;
+/* load torque on the arm from the second second of a run on, Nm */
+static double simLoad;
+static uint32_t commutationErrors;
+
+/* the CAPTURE region of the linker script */
+int16_t _scapture[CAPTURE_CELLS];
+/* the dump as capturePoll() sends it, samples by channel */
+static protoCaptureInfo_t dumpInfo;
+static int16_t dumped[PROTO_CH_COUNT][CAPTURE_CELLS];
+static uint16_t dumpedLen[PROTO_CH_COUNT];
+static uint8_t dumpBad;
+
+
+//-------------------------------------------------------------------------------------
+/** @brief   Plant derivative
+ *  @param   x Arm, pendulum from upright, arm rate, pendulum rate
+ *  @param   tau Motor torque, Nm
+ *  @param   dx Filled with the derivative
+ */
+static void plantDerivative(const double x[4], double tau, double dx[4]) {
+   double jr = MR * LR * LR / 3.0;
+   double jp = MP * LP * LP / 3.0;
+   double h = LP / 2.0;
+   double s = sin(x[1]), c = cos(x[1]);
+   double m11 = jr + jp * s * s;
+   double m12 = -MP * h * LR * c;
+   double fric = TAU_MAX * SIM_COULOMB / 1000 * tanh(x[2] / SIM_FRIC_VEL);
+   double f1 = tau - fric - DR * x[2] - 2 * jp * s * c * x[2] * x[3] - MP * h * LR * s * x[3] * x[3];
+   double f2 = -DP * x[3] + jp * s * c * x[2] * x[2] + MP * GRAV * h * s;
+   double det = m11 * jp - m12 * m12;
+
+   dx[0] = x[2];
+   dx[1] = x[3];
+   dx[2] = (jp * f1 - m12 * f2) / det;
+   dx[3] = (m11 * f2 - m12 * f1) / det;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Advance the plant by one control tick at constant torque
+ *  @param   p Plant
+ *  @param   tau Motor torque, Nm
+ */
+static void plantStep(plant_t * p, double tau) {
+   double k[4][4], y[4];
+   double dt = 1.0 / CTRL_HZ / SIM_SUBSTEPS;
+   int n, i;
+
+   for(n = 0; n < SIM_SUBSTEPS; n++) {
+      plantDerivative(p->x, tau, k[0]);
+      for(i = 0; i < 4; i++) {
+         y[i] = p->x[i] + dt / 2 * k[0][i];
+      }
+      plantDerivative(y, tau, k[1]);
+      for(i = 0; i < 4; i++) {
+         y[i] = p->x[i] + dt / 2 * k[1][i];
+      }
+      plantDerivative(y, tau, k[2]);
+      for(i = 0; i < 4; i++) {
+         y[i] = p->x[i] + dt * k[2][i];
+      }
+      plantDerivative(y, tau, k[3]);
+      for(i = 0; i < 4; i++) {
+         p->x[i] += dt / 6 * (k[0][i] + 2 * k[1][i] + 2 * k[2][i] + k[3][i]);
+      }
+   }
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Encoder counts of the plant into the bsp_host.c inputs
+ *  @details Positive torque drives the capture count down, see ctrlSense().
+ *  @param   p Plant
+ */
+static void plantSense(const plant_t * p) {
+   hostArm = (uint16_t)(captureZero - (int32_t)lround(p->x[0] * COUNTS_PER_RAD));
+   hostPendulum = (uint16_t)(32768 + PEND_DOWN + (int32_t)lround(p->x[1] * COUNTS_PER_RAD));
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Torque command the phase duties stand for
+ *  @details The duties are torque / 1000 times the commutation pattern at
+ *           the rotor angle, plus a common offset for negative torque; the
+ *           least squares fit of their AC part onto the pattern's gives the
+ *           torque back.
+ *  @return  Torque, -1000 to 1000
+ */
+static double decodeTorque(void) {
+   uint16_t theta = motorTheta(hostArm);
+   double s[3] = { sinShift03(theta), sinShift13(theta), sinShift23(theta) };
+   double d[3] = { hostDuty[0], hostDuty[1], hostDuty[2] };
+   double sm = (s[0] + s[1] + s[2]) / 3, dm = (d[0] + d[1] + d[2]) / 3;
+   double num = 0, den = 0;
+   int i;
+
+   for(i = 0; i < 3; i++) {
+      num += (d[i] - dm) * (s[i] - sm);
+      den += (s[i] - sm) * (s[i] - sm);
+   }
+   return 1000 * num / den;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   One control tick and the plant over it, as the control
+ *           interrupt in main.c does it
+ *  @param   p Plant
+ *  @param   ns Time spent in the control code added to it
+ *  @return  Torque command of the tick
+ */
+static int16_t tick(plant_t * p, uint64_t * ns) {
+   uint64_t start;
+   int16_t out;
+   double torque;
+
+   plantSense(p);
+   start = hostNs();
+   ctrlSense(&state, bspArmCapture(), pendAngle());
+   out = ctrlStep(&state);
+   setMotorTorque(out);
+   identLog(state.arm, state.pend, state.lastOut);
+   *ns += hostNs() - start;
+
+   torque = decodeTorque();
+   if(fabs(torque - out) > SIM_TORQUE_TOL) {
+      commutationErrors++;
+   }
+   plantStep(p, TAU_MAX * torque / 1000 + (state.tick > CTRL_HZ ? simLoad : 0));
+   return out;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Run a law from a starting state
+ *  @param   name Printed
+ *  @param   id Law
+ *  @param   x Initial arm, pendulum from upright, rates
+ *  @param   armRef Arm setpoint, counts
+ *  @param   seconds Simulated time
+ *  @param   p Filled with the final state
+ */
+static void run(const char * name, ctrlId_t id, const double x[4], int32_t armRef,
+                double seconds, plant_t * p) {
+   uint32_t n, ticks = (uint32_t)(seconds * CTRL_HZ);
+   uint64_t ns = 0;
+
+   memcpy(p->x, x, sizeof(p->x));
+   plantSense(p);
+   bspInit();
+   frictionInit();
+   ctrlParams.armSetpoint = armRef;
+   ctrlInit(&state, id, bspArmCapture(), pendAngle());
+   for(n = 0; n < ticks; n++) {
+      tick(p, &ns);
+      /* as often as the housekeeping task */
+      if(n % (IDENT_LOG_LEN * IDENT_DECIM / 4) == 0) {
+         identProcess();
+      }
+   }
+   printf("%-9s %6.2f s  arm %7.3f rad  pendulum %7.3f rad from up  %6.1f ns/tick\n", name,
+          seconds, p->x[0], p->x[1], (double)ns / ticks);
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Telemetry of the capture dump, in place of telemetry.c
+ *  @param   id Message
+ *  @param   body Body
+ *  @param   len Bytes of body
+ */
+void telemSend(uint8_t id, const void * body, uint16_t len) {
+   protoCaptureData_t hdr;
+   uint16_t n = (len - sizeof(hdr)) / 2;
+
+   if(id == PROTO_CAPTURE_INFO) {
+      memcpy(&dumpInfo, body, sizeof(dumpInfo));
+      memset(dumpedLen, 0, sizeof(dumpedLen));
+      return;
+   }
+   memcpy(&hdr, body, sizeof(hdr));
+   /* chunks of a channel in order, each full but the last */
+   if(id != PROTO_CAPTURE_DATA || hdr.channel >= PROTO_CH_COUNT
+      || hdr.index != dumpedLen[hdr.channel] || hdr.index + n > CAPTURE_CELLS
+      || (n != PROTO_CAPTURE_CHUNK && hdr.index + n != dumpInfo.len)) {
+      dumpBad = 1;
+      return;
+   }
+   memcpy(&dumped[hdr.channel][hdr.index], (const uint8_t *)body + sizeof(hdr), 2 * n);
+   dumpedLen[hdr.channel] += n;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   One capture of the arm and torque channels, armed, triggered
+ *           and dumped
+ *  @details Tick n records arm n and torque -n, so the dump shows which
+ *           ticks made it in.
+ *  @param   history Samples before the trigger asked for
+ *  @param   trigTick Tick of the trigger, from arming on
+ *  @return  1 if the dump holds the ticks from up to history before the
+ *           trigger to the end of the columns
+ */
+static uint8_t captureOnce(uint16_t history, uint16_t trigTick) {
+   const uint8_t mask = (1 << PROTO_CH_ARM) | (1 << PROTO_CH_TORQUE);
+   const uint16_t depth = CAPTURE_CELLS / 2;
+   uint16_t k, polls, pre = trigTick < history ? trigTick : history;
+   uint16_t len = pre + depth - history, firstTick = trigTick - pre;
+   ctrlState_t s;
+   uint32_t n;
+
+   memset(&s, 0, sizeof(s));
+   if(!captureArm(mask, PROTO_TRIG_CMD, history)) {
+      return 0;
+   }
+   for(n = 0; n < trigTick + depth && captureState() != PROTO_CAP_DONE; n++) {
+      if(n == trigTick && !captureTrigger()) {
+         return 0;
+      }
+      s.arm = n;
+      s.lastOut = -(int16_t)n;
+      s.time = n * (1000000 / CTRL_HZ);
+      captureSample(&s);
+   }
+   dumpBad = 0;
+   if(captureState() != PROTO_CAP_DONE || !captureDump()) {
+      return 0;
+   }
+   for(polls = 0; polls < 2 * CAPTURE_CELLS / PROTO_CAPTURE_CHUNK; polls++) {
+      capturePoll();
+   }
+   if(dumpBad || dumpInfo.channels != mask || dumpInfo.len != len || dumpInfo.trigger != pre
+      || dumpInfo.time != firstTick * (1000000 / CTRL_HZ) || dumpedLen[PROTO_CH_ARM] != len
+      || dumpedLen[PROTO_CH_TORQUE] != len) {
+      return 0;
+   }
+   for(k = 0; k < len; k++) {
+      if(dumped[PROTO_CH_ARM][k] != (int16_t)(firstTick + k)
+         || dumped[PROTO_CH_TORQUE][k] != -(int16_t)(firstTick + k)) {
+         return 0;
+      }
+   }
+   return 1;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Burst capture through captureSample() and capturePoll()
+ *  @details With the circular history wrapped before the trigger, and
+ *           with a trigger that comes before the history asked for.
+ *  @return  1 if both dumps are right
+ */
+static uint8_t checkCapture(void) {
+   uint8_t ok;
+
+   captureInit();
+   ok = captureOnce(100, 2000) && captureOnce(100, 10);
+   captureStop();
+   return ok;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   One fmt.h line against what it should read
+ *  @param   f Line, in a buffer with room for a guard byte past size
+ *  @param   want Expected text
+ *  @return  1 if it matches and nothing went past size
+ */
+static uint8_t fmtIs(const fmt_t * f, const char * want) {
+   return f->len == strlen(want) && !memcmp(f->buf, want, f->len) && f->buf[f->size] == '#';
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Text formatting at its edges
+ *  @details Rounding and the carry into the whole part, INT32_MIN, a
+ *           negative number rounding to 0, and lines cut off at size.
+ *  @return  1 if every line is right
+ */
+static uint8_t checkFmt(void) {
+   char buf[32];
+   fmt_t f;
+   uint8_t ok = 1;
+
+#define FMT_CHECK(size, call, want) \
+   memset(buf, '#', sizeof(buf)); \
+   fmtStart(&f, buf, size); \
+   call; \
+   ok &= fmtIs(&f, want)
+
+   FMT_CHECK(24, fmtFixed(&f, 0x18000, 16, 2), "1.50");
+   FMT_CHECK(24, fmtFixed(&f, 0x1FFFF, 16, 2), "2.00");
+   FMT_CHECK(24, fmtFixed(&f, -0x1FFFF, 16, 4), "-2.0000");
+   FMT_CHECK(24, fmtFixed(&f, 0x1FFFF, 16, 0), "2");
+   FMT_CHECK(24, fmtFixed(&f, -0x4000, 16, 1), "-0.3");
+   FMT_CHECK(24, fmtFixed(&f, -1, 16, 2), "0.00");
+   FMT_CHECK(24, fmtFixed(&f, INT32_MIN, 16, 4), "-32768.0000");
+   FMT_CHECK(24, fmtFixed(&f, INT32_MIN, 0, 2), "-2147483648.00");
+   FMT_CHECK(24, fmtFixed(&f, INT32_MAX, 20, 9), "32768.0000");
+   FMT_CHECK(24, fmtInt(&f, INT32_MIN), "-2147483648");
+   FMT_CHECK(24, fmtInt(&f, INT32_MAX), "2147483647");
+   FMT_CHECK(24, fmtUint(&f, UINT32_MAX), "4294967295");
+   FMT_CHECK(24, fmtHex(&f, 0xBEEF, 12), "0000BEEF");
+   FMT_CHECK(5, fmtInt(&f, -123456), "-1234");
+   FMT_CHECK(4, fmtFixed(&f, 0x18000, 16, 2), "1.50");
+   FMT_CHECK(3, fmtFixed(&f, 0x18000, 16, 2), "1.5");
+   FMT_CHECK(6, (fmtStr(&f, "arm "), fmtHex(&f, 0xABC, 3)), "arm AB");
+   FMT_CHECK(0, fmtStr(&f, "x"), "");
+#undef FMT_CHECK
+   return ok;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   ILC profile through bspStore() and back
+ *  @return  1 if it matches
+ */
+static uint8_t checkStore(void) {
+   static ilc_t saved, loaded;
+   uint16_t k;
+
+   ilcInit(&saved);
+   for(k = 0; k < ILC_LEN; k++) {
+      saved.ff[k] = (int16_t)(k * 37 % (2 * ILC_FF_MAX + 1) - ILC_FF_MAX);
+   }
+   saved.trials = 7;
+   saved.converged = 1;
+   if(!ilcSave(&saved) || bspStoreWrite(&saved, BSP_STORE_BYTES + 2) || bspStoreWrite(&saved, 3)) {
+      return 0;
+   }
+   ilcInit(&loaded);
+   return !memcmp(saved.ff, loaded.ff, sizeof(saved.ff)) && loaded.trials == saved.trials
+          && loaded.converged;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Switch to CTRL_OFF right after a blended switch
+ *  @details Open loop at half torque to P at the setpoint leaves a large
+ *           offset to fade out; off must cut the torque at once all the
+ *           same.
+ *  @return  1 if the torque is 0 from the tick off takes over
+ */
+static uint8_t checkOff(void) {
+   static const double still[4] = { 0, M_PI, 0, 0 };
+   uint64_t ns = 0;
+   plant_t p;
+   uint8_t n, ok = 1;
+
+   memcpy(p.x, still, sizeof(p.x));
+   plantSense(&p);
+   bspInit();
+   ctrlParams.armSetpoint = 0;
+   ctrlParams.openLoop = CTRL_TORQUE_MAX / 2;
+   ctrlInit(&state, CTRL_OPEN_LOOP, bspArmCapture(), pendAngle());
+   tick(&p, &ns);
+   ctrlRequest(CTRL_P);
+   tick(&p, &ns);
+   tick(&p, &ns);
+   ctrlRequest(CTRL_OFF);
+   for(n = 0; n < 10; n++) {
+      if(tick(&p, &ns) != 0) {
+         ok = 0;
+      }
+   }
+   ctrlParams.openLoop = 0;
+   return ok;
+}
+
+int main(void) {
+   static const double down[4] = { 0, M_PI, 0, 0 };
+   static const double tilted[4] = { 0, 0.05, 0, 0 };
+   static const double swinging[4] = { 0, M_PI - 1.0, 0, 0 };
+   const int32_t step = (int32_t)(0.5 * COUNTS_PER_RAD);
+   uint8_t ok = 1;
+   identParams_t id;
+   plant_t p;
+
+   identInit();
+   ilcInit(&learnIlc);
+   ctrlParams.ilc = &learnIlc;
+   if(!checkStore()) {
+      printf("FAIL: ILC profile did not come back from bspStore()\n");
+      ok = 0;
+   }
+   if(!checkOff()) {
+      printf("FAIL: CTRL_OFF did not cut the torque during a blend\n");
+      ok = 0;
+   }
+   if(!checkFmt()) {
+      printf("FAIL: fmt.h lines not as expected\n");
+      ok = 0;
+   }
+   if(!checkCapture()) {
+      printf("FAIL: capture dump did not hold the ticks around the trigger\n");
+      ok = 0;
+   }
+
+   /* Coulomb friction is all the plant has beyond the arm damping */
+   run("friction", CTRL_FRICTION, down, 0, 8, &p);
+   if(ctrlActive() != CTRL_OFF || abs(frictionModel()->coulomb - SIM_COULOMB) > SIM_COULOMB / 10) {
+      printf("FAIL: friction identification did not find the arm's Coulomb friction\n");
+      ok = 0;
+   }
+
+   /* the first trial starts after a second hanging still and takes ILC_LEN
+      samples, the next waits for the pendulum to settle again */
+   run("learning", CTRL_LEARN, down, 0, 5, &p);
+   if(ctrlActive() != CTRL_LEARN || ctrlLearnedTrials() != 1 || learnIlc.trials != 1) {
+      printf("FAIL: swing-up learning did not run one trial\n");
+      ok = 0;
+   }
+
+   /* a load of 300 on P alone leaves the arm about 0.18 rad off, the
+      observer takes it back; the pendulum swings it by 0.01 rad */
+   simLoad = TAU_MAX * 0.3;
+   run("P load", CTRL_P, down, 0, 3, &p);
+   simLoad = 0;
+   if(fabs(p.x[0]) > SIM_LOAD_TOL) {
+      printf("FAIL: P did not reject a step load\n");
+      ok = 0;
+   }
+
+   /* the move sets the pendulum swinging, which rocks the arm by up to
+      6 % of the step around the setpoint */
+   run("PID", CTRL_PID, down, step, 3, &p);
+   if(fabs(p.x[0] * COUNTS_PER_RAD - step) > 0.1 * step) {
+      printf("FAIL: PID did not reach the arm setpoint\n");
+      ok = 0;
+   }
+
+   /* P holding the arm while the pendulum swings from 1 rad, right after
+      the arm origin moved by the PID step */
+   run("swinging", CTRL_P, swinging, 0, 3, &p);
+   identGetParams(&id);
+   if(!id.valid || fabs(id.pendW0Sq / 256.0 - SIM_W0SQ) > 0.05 * SIM_W0SQ) {
+      printf("FAIL: identification found w0^2 %.1f instead of %.1f\n", id.pendW0Sq / 256.0,
+             SIM_W0SQ);
+      ok = 0;
+   }
+
+   run("LQR", CTRL_LQR, tilted, 0, 3, &p);
+   if(fabs(p.x[1]) > SIM_BALANCE_TOL || fabs(p.x[0]) > SIM_ARM_DRIFT) {
+      printf("FAIL: LQR did not balance\n");
+      ok = 0;
+   }
+
+   run("EMPC", CTRL_EMPC, tilted, 0, 3, &p);
+   if(fabs(p.x[1]) > SIM_BALANCE_TOL || fabs(p.x[0]) > SIM_ARM_DRIFT) {
+      printf("FAIL: EMPC did not balance\n");
+      ok = 0;
+   }
+
+   if(commutationErrors) {
+      printf("FAIL: %lu ticks with the phase duties off the torque command\n",
+             (unsigned long)commutationErrors);
+      ok = 0;
+   }
+   if(!ok) {
+      return 1;
+   }
+   printf("PASS\n");
+   return 0;
+}
@@ -0,0 +1,375 @@
+/*
+ * Host stand-in for the parts of the STM32F1 HAL the firmware uses.
+ *
+ * Configuration calls succeed and only call the MSP hooks, as the real
+ * HAL does. What behaves like hardware:
+ *
+ *  - DWT->CYCCNT is the monotonic clock in 72 MHz cycles.
+ *  - HAL_TIM_Base_Start_IT() on TIM4 starts a thread that plays the update
+ *    interrupt: it sleeps to each period boundary, puts the time since the
+ *    boundary into TIM4->CNT and calls HAL_TIM_PeriodElapsedCallback().
+ *    All signals are blocked on it, so the Posix port never runs kernel
+ *    code there, just like a zero-latency interrupt on the target. Unlike
+ *    the target it runs in parallel with the task threads rather than in
+ *    place of them, which the lock-free hand-offs have to (and do)
+ *    tolerate.
+ *  - HAL_UART_Transmit_DMA() hands the transfer to a thread playing the
+ *    DMA channel: it sleeps for the time the bytes take at the configured
+ *    baud rate, passes them to hostUartWrite() and calls
+ *    HAL_UART_TxCpltCallback(), like the interrupt at the end of the
+ *    transfer. Signals are blocked on it too.
+ *  - HAL_UART_Receive_DMA() starts a receive that stays empty; the bench
+ *    feeds what the host would send to linkRxByte() instead.
+ *  - _scapture for the capture buffer is a plain array.
+ *
+ * The motor, the encoders and the flash page are reached through bsp.h
+ * only, bsp_host.c stands in for them.
+ */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <time.h>
+#include "stm32f1xx_hal.h"
+#include "host.h"
+#include "capture.h"
+#include "bsp.h"
+
+TIM_TypeDef hostTim[5];
+GPIO_TypeDef hostGpio[4];
+SPI_TypeDef hostSpi1;
+USART_TypeDef hostUsart1;
+CoreDebug_Type hostCoreDebug;
+DMA_Channel_TypeDef hostDma1[7];
+uint32_t SystemCoreClock = HOST_CORE_HZ;
+
+/* the burst capture buffer, the CAPTURE region */
+int16_t _scapture[CAPTURE_BYTES / 2];
+
+static DWT_Type dwt;
+static uint64_t startNs;
+static volatile uint64_t nextUpdateNs;
+static pthread_t irqThread;
+
+/* the transfer the USART1 TX DMA thread works on */
+static pthread_t dmaThread;
+static sem_t dmaStart;
+static UART_HandleTypeDef * dmaUart;
+static uint8_t * dmaData;
+static uint16_t dmaSize;
+static volatile uint8_t dmaBusy;
+
+
+//-------------------------------------------------------------------------------------
+/** @brief   DWT registers, CYCCNT refreshed from the host clock
+ *  @return  The emulated DWT
+ */
+DWT_Type * hostDwt(void) {
+   dwt.CYCCNT = bspCycles();
+   return &dwt;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Timer status flag, the TIM4 update flag follows the host clock
+ *  @param   htim Timer
+ *  @param   flag Flag mask
+ *  @return  1 if set
+ */
+uint8_t hostTimGetFlag(TIM_HandleTypeDef * htim, uint32_t flag) {
+   if(htim->Instance == TIM4 && flag == TIM_FLAG_UPDATE && nextUpdateNs) {
+      return hostNs() >= nextUpdateNs;
+   }
+   return (htim->Instance->SR & flag) == flag;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Start a thread standing in for hardware
+ *  @details Signals are blocked while the thread is created so that it
+ *           starts, and stays, with all of them blocked: the Posix port
+ *           must never switch tasks on it.
+ *  @param   thread Filled with the thread
+ *  @param   body Thread function
+ *  @param   arg Passed to body
+ *  @return  0 on success, an errno value otherwise
+ */
+static int hardwareThread(pthread_t * thread, void * (*body)(void *), void * arg) {
+   sigset_t all, old;
+   int err;
+
+   sigfillset(&all);
+   pthread_sigmask(SIG_SETMASK, &all, &old);
+   err = pthread_create(thread, NULL, body, arg);
+   pthread_sigmask(SIG_SETMASK, &old, NULL);
+   return err;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Thread playing the TIM4 update interrupt
+ *  @details Like the hardware, updates missed while the handler was still
+ *           running collapse into a single pending one.
+ *  @param   arg TIM4 handle
+ *  @return  Never returns
+ */
+static void * timerIrq(void * arg) {
+   TIM_HandleTypeDef * htim = arg;
+   uint64_t div = htim->Init.Prescaler + 1;
+   uint64_t counts = htim->Init.Period + 1;
+   uint64_t period = counts * div * 1000000000ULL / SystemCoreClock;
+   uint64_t next = hostNs() + period;
+   struct timespec ts;
+
+   for(;;) {
+      ts.tv_sec = next / 1000000000ULL;
+      ts.tv_nsec = next % 1000000000ULL;
+      while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+      }
+
+      uint64_t late = hostNs() - next;
+      htim->Instance->CNT = (late * SystemCoreClock / div / 1000000000ULL) % counts;
+      nextUpdateNs = next + period;
+      hostIrqLatency(late);
+      HAL_TIM_PeriodElapsedCallback(htim);
+
+      next += period;
+      while(next + period <= hostNs()) {
+         next += period;
+      }
+   }
+   return NULL;
+}
+
+HAL_StatusTypeDef HAL_Init(void) {
+   startNs = hostNs();
+   HAL_MspInit();
+   return HAL_OK;
+}
+
+uint32_t HAL_GetTick(void) {
+   return (uint32_t)((hostNs() - startNs) / 1000000);
+}
+
+HAL_StatusTypeDef HAL_RCC_OscConfig(RCC_OscInitTypeDef * osc) {
+   (void)osc;
+   return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RCC_ClockConfig(RCC_ClkInitTypeDef * clk, uint32_t latency) {
+   (void)clk;
+   (void)latency;
+   return HAL_OK;
+}
+
+uint32_t HAL_RCC_GetHCLKFreq(void) {
+   return SystemCoreClock;
+}
+
+uint32_t HAL_SYSTICK_Config(uint32_t ticks) {
+   (void)ticks;
+   return 0;
+}
+
+void HAL_SYSTICK_CLKSourceConfig(uint32_t source) {
+   (void)source;
+}
+
+void HAL_NVIC_SetPriorityGrouping(uint32_t group) {
+   (void)group;
+}
+
+void HAL_NVIC_SetPriority(IRQn_Type irq, uint32_t pre, uint32_t sub) {
+   (void)irq;
+   (void)pre;
+   (void)sub;
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type irq) {
+   (void)irq;
+}
+
+void HAL_NVIC_DisableIRQ(IRQn_Type irq) {
+   (void)irq;
+}
+
+void HAL_GPIO_Init(GPIO_TypeDef * port, GPIO_InitTypeDef * init) {
+   (void)port;
+   (void)init;
+}
+
+void HAL_GPIO_DeInit(GPIO_TypeDef * port, uint32_t pin) {
+   (void)port;
+   (void)pin;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef * port, uint16_t pin, GPIO_PinState state) {
+   if(state == GPIO_PIN_SET) {
+      port->ODR |= pin;
+   } else {
+      port->ODR &= ~(uint32_t)pin;
+   }
+}
+
+void HAL_GPIO_TogglePin(GPIO_TypeDef * port, uint16_t pin) {
+   port->ODR ^= pin;
+}
+
+HAL_StatusTypeDef HAL_SPI_Init(SPI_HandleTypeDef * hspi) {
+   HAL_SPI_MspInit(hspi);
+   return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Init(TIM_HandleTypeDef * htim) {
+   HAL_TIM_Base_MspInit(htim);
+   htim->Instance->PSC = htim->Init.Prescaler;
+   htim->Instance->ARR = htim->Init.Period;
+   return HAL_OK;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Start the timer; for TIM4 this starts the interrupt thread
+ *  @param   htim Timer
+ *  @return  HAL_OK, HAL_ERROR if the thread could not be created
+ */
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef * htim) {
+   if(htim->Instance != TIM4) {
+      return HAL_OK;
+   }
+   return hardwareThread(&irqThread, timerIrq, htim) ? HAL_ERROR : HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_ConfigClockSource(TIM_HandleTypeDef * htim, TIM_ClockConfigTypeDef * cfg) {
+   (void)htim;
+   (void)cfg;
+   return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Init(TIM_HandleTypeDef * htim) {
+   HAL_TIM_PWM_MspInit(htim);
+   htim->Instance->ARR = htim->Init.Period;
+   return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_ConfigChannel(TIM_HandleTypeDef * htim, TIM_OC_InitTypeDef * cfg,
+                                            uint32_t channel) {
+   __HAL_TIM_SET_COMPARE(htim, channel, cfg->Pulse);
+   return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_IC_Init(TIM_HandleTypeDef * htim) {
+   HAL_TIM_IC_MspInit(htim);
+   return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_IC_ConfigChannel(TIM_HandleTypeDef * htim, TIM_IC_InitTypeDef * cfg,
+                                           uint32_t channel) {
+   (void)htim;
+   (void)cfg;
+   (void)channel;
+   return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_SlaveConfigSynchronization(TIM_HandleTypeDef * htim,
+                                                     TIM_SlaveConfigTypeDef * cfg) {
+   (void)htim;
+   (void)cfg;
+   return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIMEx_MasterConfigSynchronization(TIM_HandleTypeDef * htim,
+                                                        TIM_MasterConfigTypeDef * cfg) {
+   (void)htim;
+   (void)cfg;
+   return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef * huart) {
+   HAL_UART_MspInit(huart);
+   return HAL_OK;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Thread playing the USART1 TX DMA channel and the transfer
+ *           complete interrupt
+ *  @param   arg Not used
+ *  @return  Never returns
+ */
+static void * uartDma(void * arg) {
+   struct timespec ts;
+   uint64_t end;
+
+   (void)arg;
+   for(;;) {
+      while(sem_wait(&dmaStart) != 0) {
+      }
+      /* 10 bits per byte with 8N1 */
+      end = hostNs() + (uint64_t)dmaSize * 10 * 1000000000ULL / dmaUart->Init.BaudRate;
+      ts.tv_sec = end / 1000000000ULL;
+      ts.tv_nsec = end % 1000000000ULL;
+      while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+      }
+      hostUartWrite(dmaData, dmaSize);
+      dmaBusy = 0;
+      HAL_UART_TxCpltCallback(dmaUart);
+   }
+   return NULL;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef * huart, uint8_t * data,
+                                        uint16_t size) {
+   if(dmaBusy) {
+      return HAL_BUSY;
+   }
+   if(!dmaThread) {
+      sem_init(&dmaStart, 0, 0);
+      if(hardwareThread(&dmaThread, uartDma, NULL)) {
+         return HAL_ERROR;
+      }
+   }
+   dmaUart = huart;
+   dmaData = data;
+   dmaSize = size;
+   dmaBusy = 1;
+   sem_post(&dmaStart);
+   return HAL_OK;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Blocking send, written out at once
+ */
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef * huart, uint8_t * data,
+                                    uint16_t size, uint32_t timeout) {
+   (void)huart;
+   (void)timeout;
+   hostUartWrite(data, size);
+   return HAL_OK;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Stop a DMA send: a transfer already handed to the thread still
+ *           completes, as if the abort came just after its last byte
+ */
+HAL_StatusTypeDef HAL_UART_AbortTransmit(UART_HandleTypeDef * huart) {
+   (void)huart;
+   return HAL_OK;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Circular receive that never receives: nothing drives the RX
+ *           line, the bench feeds its replies to linkRxByte() directly
+ */
+HAL_StatusTypeDef HAL_UART_Receive_DMA(UART_HandleTypeDef * huart, uint8_t * data,
+                                       uint16_t size) {
+   (void)data;
+   huart->hdmarx->Instance->CNDTR = size;
+   return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef * hdma) {
+   (void)hdma;
+   return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_DMA_DeInit(DMA_HandleTypeDef * hdma) {
+   (void)hdma;
+   return HAL_OK;
+}
@@ -0,0 +1,23 @@
+#ifndef HOST_H
+#define HOST_H
+#include <stdint.h>
+
+/** @brief Core clock the emulated DWT and timers count at **/
+#define HOST_CORE_HZ 72000000UL
+
+/* the plant as bsp_host.c shows it to the control code */
+/** @brief Arm capture count bspArmCapture() returns **/
+extern volatile uint16_t hostArm;
+/** @brief Pendulum encoder reading bspPendEncoder() returns **/
+extern volatile uint16_t hostPendulum;
+/** @brief Phase duties of the last bspPwm() **/
+extern volatile uint16_t hostDuty[3];
+
+uint64_t hostNs(void);
+int firmwareMain(void);
+
+/* provided by the benchmark */
+void hostUartWrite(const uint8_t * data, uint16_t len);
+void hostIrqLatency(uint64_t ns);
+
+#endif
@@ -0,0 +1,485 @@
+#ifndef RECFILE_HPP
+#define RECFILE_HPP
+/*
+ * Recording file: decoded telemetry stored column by column, written by
+ * telemrec and read by analysis tools through rec::Reader.
+ *
+ * A recording holds tables. A table is a set of int32 columns sampled
+ * together plus an int64 time column, e.g. the state records, or one
+ * subscribed channel at its own rate. Times are microseconds, for
+ * telemrec the board's clock unwrapped. The file is
+ *
+ *    Header      4 kB: magic, firmware build, control rate, the tables
+ *                and their columns, free text parameters
+ *    chunk       ChunkHead, then time[rows] and each column's rows, every
+ *                column contiguous, padded to 8 bytes
+ *    chunk ...   of any table, in the order they filled up
+ *    index       IndexEntry per chunk
+ *    Trailer     where the index is
+ *
+ * The writer only appends, apart from rewriting the header when a table
+ * is added or the board reports its build. Everything is aligned to its
+ * size and little endian, so the reader maps the file and hands out columns
+ * as plain arrays without parsing or copying: a scan runs at the speed
+ * the page cache delivers. Times rise within a table, so Reader::seek()
+ * finds a time with a binary search over the chunks and one within a
+ * chunk. A file without its index, the recorder killed, is read by
+ * walking the chunk heads, one page touched per chunk; a chunk cut off
+ * at the end is left out.
+ *
+ *    rec::Reader r;
+ *    if(r.open("run.rec")) {
+ *       int t = r.find("state");
+ *       for(const rec::Chunk & c : r.chunks(t)) {
+ *          sum(c.time, c.col(2), c.rows);
+ *       }
+ *    }
+ */
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <initializer_list>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace rec {
+
+/** @brief Format version in the header **/
+constexpr uint32_t version = 2;
+/** @brief Bytes of the header, data starts after it **/
+constexpr size_t headerSize = 4096;
+/** @brief Most tables in a file **/
+constexpr int maxTables = 32;
+/** @brief Most columns in a table, besides time **/
+constexpr int maxCols = 8;
+/** @brief First word of every chunk, "CHNK" **/
+constexpr uint32_t chunkMagic = 0x4B4E4843;
+/** @brief Magic of the trailer, "INDX" **/
+constexpr uint32_t indexMagic = 0x58444E49;
+
+/** @brief A table in the header, names 0 terminated **/
+struct TableInfo {
+   char name[16];
+   uint32_t cols;
+   char colName[maxCols][12];
+};
+
+/** @brief Start of the file **/
+struct Header {
+   char magic[8];           /**< "FPREC\0\0\0" */
+   uint32_t version;
+   uint32_t tables;         /**< entries used in table */
+   int64_t created;         /**< Unix time the recording started */
+   char build[32];          /**< firmware build from INFO, empty until it came */
+   uint32_t ctrlHz;         /**< control ticks per second, 0 until INFO came */
+   uint32_t reserved;
+   TableInfo table[maxTables];
+   char params[headerSize - 64 - maxTables * sizeof(TableInfo)];  /**< text, 0 terminated */
+};
+static_assert(sizeof(Header) == headerSize, "rec::Header is not 4 kB");
+
+/** @brief Start of a chunk, followed by the columns **/
+struct ChunkHead {
+   uint32_t magic;          /**< chunkMagic */
+   uint32_t table;
+   uint32_t rows;
+   uint32_t cols;           /**< besides time, as in the header */
+   int64_t tmin;            /**< time of the first row */
+   int64_t tmax;            /**< time of the last row */
+   uint64_t bytes;          /**< whole chunk, head and padding included */
+};
+
+/** @brief Index entry of a chunk **/
+struct IndexEntry {
+   uint64_t offset;         /**< of the ChunkHead */
+   uint32_t table;
+   uint32_t rows;
+   int64_t tmin;
+   int64_t tmax;
+};
+
+/** @brief End of a closed file **/
+struct Trailer {
+   uint64_t index;          /**< offset of the first IndexEntry */
+   uint64_t entries;
+   uint32_t magic;          /**< indexMagic */
+   uint32_t reserved;
+};
+
+//-------------------------------------------------------------------------------------
+/** @brief   Bytes of a chunk
+ *  @param   rows Rows
+ *  @param   cols Columns besides time
+ *  @return  Head, columns and padding
+ */
+inline uint64_t chunkBytes(uint32_t rows, uint32_t cols) {
+   return (sizeof(ChunkHead) + 8ull * rows + 4ull * rows * cols + 7) & ~7ull;
+}
+
+/** @brief Appends rows to a recording, buffering a chunk per table **/
+class Writer {
+public:
+   /** @brief Rows per chunk; the last chunk of a table may be shorter **/
+   static constexpr uint32_t chunkRows = 8192;
+
+   ~Writer() { close(); }
+
+   //-------------------------------------------------------------------------------------
+   /** @brief   Start a recording
+    *  @param   path File, replaced if it exists
+    *  @param   params Text stored in the header, cut to fit
+    *  @return  false if the file cannot be created
+    */
+   bool open(const char * path, const char * params) {
+      close();
+      fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+      if(fd < 0) {
+         return false;
+      }
+      std::memset(&head, 0, sizeof(head));
+      std::memcpy(head.magic, "FPREC", 5);
+      head.version = version;
+      head.created = std::time(nullptr);
+      std::strncpy(head.params, params ? params : "", sizeof(head.params) - 1);
+      end = headerSize;
+      index.clear();
+      pending.clear();
+      return writeHeader();
+   }
+
+   //-------------------------------------------------------------------------------------
+   /** @brief   Add a table
+    *  @param   name Up to 15 characters
+    *  @param   cols Column names, up to maxCols of up to 11 characters
+    *  @return  Table number for add(), -1 if there is no room
+    */
+   int table(const char * name, std::initializer_list<const char *> cols) {
+      if(fd < 0 || head.tables == maxTables || cols.size() > maxCols) {
+         return -1;
+      }
+      TableInfo & t = head.table[head.tables];
+      std::strncpy(t.name, name, sizeof(t.name) - 1);
+      t.cols = cols.size();
+      int c = 0;
+      for(const char * col : cols) {
+         std::strncpy(t.colName[c++], col, sizeof(t.colName[0]) - 1);
+      }
+      pending.emplace_back();
+      pending.back().cols = t.cols;
+      pending.back().data.resize(chunkRows * t.cols);
+      head.tables++;
+      return writeHeader() ? head.tables - 1 : -1;
+   }
+
+   //-------------------------------------------------------------------------------------
+   /** @brief   Record what the board reported in INFO
+    *  @details Rewrites the header only if something changed.
+    *  @param   build Firmware build, not necessarily 0 terminated
+    *  @param   size Bytes of build
+    *  @param   ctrlHz Control ticks per second
+    *  @return  false on a write error
+    */
+   bool info(const char * build, size_t size, uint32_t ctrlHz) {
+      char b[sizeof(head.build)] = {};
+      std::memcpy(b, build, std::min(size, sizeof(b) - 1));
+      if(fd < 0 || (!std::memcmp(b, head.build, sizeof(b)) && ctrlHz == head.ctrlHz)) {
+         return fd >= 0;
+      }
+      std::memcpy(head.build, b, sizeof(b));
+      head.ctrlHz = ctrlHz;
+      return writeHeader();
+   }
+
+   //-------------------------------------------------------------------------------------
+   /** @brief   Append a row
+    *  @param   table From table()
+    *  @param   time Time, not below the table's last row
+    *  @param   values One per column
+    *  @return  false on a write error
+    */
+   bool add(int table, int64_t time, const int32_t * values) {
+      Pending & p = pending[table];
+      if(!p.rows) {
+         p.tmin = time;
+      }
+      p.tmax = time;
+      p.time[p.rows] = time;
+      for(uint32_t c = 0; c < p.cols; c++) {
+         p.data[c * chunkRows + p.rows] = values[c];
+      }
+      return ++p.rows < chunkRows || flush(table);
+   }
+
+   //-------------------------------------------------------------------------------------
+   /** @brief   Write what is buffered, the index and the trailer, and close
+    *  @return  false on a write error
+    */
+   bool close() {
+      bool ok = true;
+      if(fd < 0) {
+         return true;
+      }
+      for(size_t t = 0; t < pending.size(); t++) {
+         ok = ok && flush(t);
+      }
+      Trailer tr = { end, index.size(), indexMagic, 0 };
+      ok = ok && put(index.data(), index.size() * sizeof(IndexEntry));
+      ok = ok && put(&tr, sizeof(tr));
+      ok = ::close(fd) == 0 && ok;
+      fd = -1;
+      return ok;
+   }
+
+   /** @brief Bytes written so far **/
+   uint64_t bytes() const { return end; }
+
+private:
+   /* rows of one table not written yet, columns chunkRows apart */
+   struct Pending {
+      uint32_t cols = 0;
+      uint32_t rows = 0;
+      int64_t tmin = 0;
+      int64_t tmax = 0;
+      int64_t time[chunkRows];
+      std::vector<int32_t> data;
+   };
+
+   bool writeHeader() {
+      return pwrite(fd, &head, sizeof(head), 0) == sizeof(head);
+   }
+
+   bool put(const void * p, size_t n) {
+      if(pwrite(fd, p, n, end) != static_cast<ssize_t>(n)) {
+         return false;
+      }
+      end += n;
+      return true;
+   }
+
+   bool flush(size_t table) {
+      Pending & p = pending[table];
+      if(!p.rows) {
+         return true;
+      }
+      ChunkHead h = { chunkMagic, static_cast<uint32_t>(table), p.rows, p.cols,
+                      p.tmin, p.tmax, chunkBytes(p.rows, p.cols) };
+      index.push_back({ end, h.table, h.rows, h.tmin, h.tmax });
+      static const uint8_t pad[8] = {};
+      bool ok = put(&h, sizeof(h)) && put(p.time, 8 * p.rows);
+      for(uint32_t c = 0; c < p.cols && ok; c++) {
+         ok = put(&p.data[c * chunkRows], 4 * p.rows);
+      }
+      ok = ok && put(pad, 4 * (p.rows * p.cols % 2));
+      p.rows = 0;
+      return ok;
+   }
+
+   int fd = -1;
+   Header head;
+   uint64_t end = 0;
+   std::vector<IndexEntry> index;
+   std::vector<Pending> pending;
+};
+
+/** @brief A chunk of a table, pointing into the mapped file **/
+struct Chunk {
+   const int64_t * time;
+   uint32_t rows;
+   int64_t tmin;
+   int64_t tmax;
+   /** @brief Column c, rows values **/
+   const int32_t * col(uint32_t c) const {
+      return reinterpret_cast<const int32_t *>(time + rows) + rows * c;
+   }
+};
+
+/** @brief Maps a recording read only **/
+class Reader {
+public:
+   Reader() = default;
+   Reader(const Reader &) = delete;
+   Reader & operator=(const Reader &) = delete;
+   ~Reader() { close(); }
+
+   //-------------------------------------------------------------------------------------
+   /** @brief   Map a recording and find its chunks
+    *  @param   path File
+    *  @return  false if it cannot be mapped or is no recording
+    */
+   bool open(const char * path) {
+      struct stat st;
+      close();
+      int fd = ::open(path, O_RDONLY);
+      if(fd < 0) {
+         return false;
+      }
+      if(fstat(fd, &st) || st.st_size < static_cast<off_t>(headerSize)) {
+         ::close(fd);
+         return false;
+      }
+      size = st.st_size;
+      void * m = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+      ::close(fd);
+      if(m == MAP_FAILED) {
+         size = 0;
+         return false;
+      }
+      base = static_cast<const uint8_t *>(m);
+      head = reinterpret_cast<const Header *>(base);
+      if(std::memcmp(head->magic, "FPREC", 6) || head->version != version ||
+         head->tables > maxTables) {
+         close();
+         return false;
+      }
+      tables.assign(head->tables, std::vector<Chunk>());
+      recovered = !readIndex();
+      if(recovered) {
+         scan();
+      }
+      return true;
+   }
+
+   /** @brief Unmap **/
+   void close() {
+      if(base) {
+         munmap(const_cast<uint8_t *>(base), size);
+      }
+      base = nullptr;
+      head = nullptr;
+      size = 0;
+      tables.clear();
+   }
+
+   /** @brief Header, valid while open **/
+   const Header & header() const { return *head; }
+
+   /** @brief true if the file had no index and the chunks were found by walking them **/
+   bool wasRecovered() const { return recovered; }
+
+   /** @brief Bytes of the file **/
+   size_t bytes() const { return size; }
+
+   //-------------------------------------------------------------------------------------
+   /** @brief   Table by name
+    *  @param   name Table name
+    *  @return  Table number, -1 if there is none
+    */
+   int find(const char * name) const {
+      for(uint32_t t = 0; t < head->tables; t++) {
+         if(!std::strncmp(head->table[t].name, name, sizeof(head->table[t].name))) {
+            return t;
+         }
+      }
+      return -1;
+   }
+
+   //-------------------------------------------------------------------------------------
+   /** @brief   Column by name
+    *  @param   table Table number
+    *  @param   name Column name
+    *  @return  Column number for Chunk::col(), -1 if there is none
+    */
+   int column(int table, const char * name) const {
+      const TableInfo & t = head->table[table];
+      for(uint32_t c = 0; c < t.cols; c++) {
+         if(!std::strncmp(t.colName[c], name, sizeof(t.colName[c]))) {
+            return c;
+         }
+      }
+      return -1;
+   }
+
+   /** @brief Chunks of a table, in time order **/
+   const std::vector<Chunk> & chunks(int table) const { return tables[table]; }
+
+   //-------------------------------------------------------------------------------------
+   /** @brief   First row of a table at or after a time
+    *  @param   table Table number
+    *  @param   time Time
+    *  @param   chunk Filled with the chunk number
+    *  @param   row Filled with the row in it
+    *  @return  false if all rows are earlier
+    */
+   bool seek(int table, int64_t time, size_t & chunk, uint32_t & row) const {
+      const std::vector<Chunk> & cs = tables[table];
+      auto c = std::partition_point(cs.begin(), cs.end(),
+                                    [&](const Chunk & x) { return x.tmax < time; });
+      if(c == cs.end()) {
+         return false;
+      }
+      chunk = c - cs.begin();
+      row = std::lower_bound(c->time, c->time + c->rows, time) - c->time;
+      return true;
+   }
+
+private:
+   /* a chunk at offset that lies wholly in the file and fits the header */
+   bool chunkAt(uint64_t offset, Chunk & c, uint32_t & table) const {
+      ChunkHead h;
+      if(offset % 8 || offset < headerSize || offset + sizeof(h) > size) {
+         return false;
+      }
+      std::memcpy(&h, base + offset, sizeof(h));
+      if(h.magic != chunkMagic || h.table >= head->tables || h.cols != head->table[h.table].cols ||
+         h.bytes != chunkBytes(h.rows, h.cols) || h.bytes > size - offset) {
+         return false;
+      }
+      c.time = reinterpret_cast<const int64_t *>(base + offset + sizeof(h));
+      c.rows = h.rows;
+      c.tmin = h.tmin;
+      c.tmax = h.tmax;
+      table = h.table;
+      return true;
+   }
+
+   bool readIndex() {
+      Trailer tr;
+      if(size < headerSize + sizeof(tr)) {
+         return false;
+      }
+      std::memcpy(&tr, base + size - sizeof(tr), sizeof(tr));
+      if(tr.magic != indexMagic || tr.index < headerSize || tr.index > size - sizeof(tr) ||
+         tr.entries != (size - sizeof(tr) - tr.index) / sizeof(IndexEntry)) {
+         return false;
+      }
+      for(uint64_t i = 0; i < tr.entries; i++) {
+         IndexEntry e;
+         Chunk c;
+         uint32_t t;
+         std::memcpy(&e, base + tr.index + i * sizeof(e), sizeof(e));
+         if(!chunkAt(e.offset, c, t)) {
+            for(auto & cs : tables) {
+               cs.clear();
+            }
+            return false;
+         }
+         tables[t].push_back(c);
+      }
+      return true;
+   }
+
+   void scan() {
+      uint64_t offset = headerSize;
+      Chunk c;
+      uint32_t t;
+      while(chunkAt(offset, c, t)) {
+         tables[t].push_back(c);
+         offset += chunkBytes(c.rows, head->table[t].cols);
+      }
+   }
+
+   const uint8_t * base = nullptr;
+   const Header * head = nullptr;
+   size_t size = 0;
+   bool recovered = false;
+   std::vector<std::vector<Chunk>> tables;
+};
+
+}
+
+#endif
@@ -0,0 +1,178 @@
+/*
+ * Throughput of the ring in Src/ring.h between two host threads.
+ *
+ * A producer thread writes numbered records of varying length with a
+ * pattern derived from the number, a consumer thread reads them back and
+ * checks number, length and contents, so the benchmark doubles as a
+ * stress run of the wrap and full/empty handling. Two passes: variable
+ * length records through reserve/commit and peek/release, and fixed
+ * 8 byte records through ringWrite()/ringRead() as identLog() uses it.
+ * A ring of a few hundred bytes keeps both sides on the wrap path.
+ *
+ * Usage: ringbench [records per pass]
+ * Exits non-zero on the first record that does not match.
+ */
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "ring.h"
+
+/** @brief Ring size in bytes, deliberately not a power of 2 **/
+#define BENCH_RING 396
+/** @brief Largest variable record payload **/
+#define BENCH_MAX_LEN 60
+
+typedef struct {
+   ring_t ring;
+   uint32_t count;
+   uint8_t fixed;
+   uint32_t errors;
+} pass_t;
+
+static uint32_t mem[BENCH_RING / 4];
+
+
+//-------------------------------------------------------------------------------------
+/** @brief   Payload length of a record
+ *  @param   seq Record number
+ *  @return  Bytes, 4 to BENCH_MAX_LEN
+ */
+static uint32_t recordLen(uint32_t seq) {
+   return 4 + (seq * 7919) % (BENCH_MAX_LEN - 3);
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Fill a payload: the number, then bytes derived from it
+ *  @param   p Payload
+ *  @param   seq Record number
+ *  @param   len Payload bytes
+ */
+static void recordFill(uint8_t * p, uint32_t seq, uint32_t len) {
+   uint32_t i;
+
+   memcpy(p, &seq, 4);
+   for(i = 4; i < len; i++) {
+      p[i] = (uint8_t)(seq + i);
+   }
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Check a payload against recordFill()
+ *  @param   p Payload
+ *  @param   seq Expected record number
+ *  @param   len Payload bytes
+ *  @return  1 if it matches
+ */
+static uint8_t recordCheck(const uint8_t * p, uint32_t seq, uint32_t len) {
+   uint32_t got;
+   uint32_t i;
+
+   memcpy(&got, p, 4);
+   if(got != seq) {
+      return 0;
+   }
+   for(i = 4; i < len; i++) {
+      if(p[i] != (uint8_t)(seq + i)) {
+         return 0;
+      }
+   }
+   return 1;
+}
+
+static void * producer(void * arg) {
+   pass_t * b = arg;
+   uint8_t rec[8];
+   uint32_t seq;
+
+   for(seq = 0; seq < b->count; seq++) {
+      if(b->fixed) {
+         recordFill(rec, seq, sizeof(rec));
+         while(!ringWrite(&b->ring, rec, sizeof(rec))) {
+            sched_yield();
+         }
+      } else {
+         uint32_t len = recordLen(seq);
+         uint8_t * p;
+         while(!(p = ringReserve(&b->ring, BENCH_MAX_LEN))) {
+            sched_yield();
+         }
+         recordFill(p, seq, len);
+         ringCommit(&b->ring, len);
+      }
+   }
+   return NULL;
+}
+
+static void * consumer(void * arg) {
+   pass_t * b = arg;
+   uint8_t rec[8];
+   uint32_t seq;
+
+   for(seq = 0; seq < b->count && !b->errors; seq++) {
+      if(b->fixed) {
+         while(!ringRead(&b->ring, rec, sizeof(rec))) {
+            sched_yield();
+         }
+         if(!recordCheck(rec, seq, sizeof(rec))) {
+            b->errors++;
+         }
+      } else {
+         const uint8_t * p;
+         uint32_t len;
+         while(!(p = ringPeek(&b->ring, &len))) {
+            sched_yield();
+         }
+         if(len != recordLen(seq) || !recordCheck(p, seq, len)) {
+            b->errors++;
+         }
+         ringRelease(&b->ring);
+      }
+   }
+   if(b->errors) {
+      printf("FAIL: record %lu corrupt\n", (unsigned long)(seq - 1));
+      exit(1);
+   }
+   return NULL;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Run one pass and print its throughput
+ *  @param   b Pass, count and fixed set
+ *  @param   name Label
+ */
+static void run(pass_t * b, const char * name) {
+   pthread_t prod, cons;
+   struct timespec t0, t1;
+   double s;
+   uint64_t bytes = 0;
+   uint32_t seq;
+
+   for(seq = 0; seq < b->count; seq++) {
+      bytes += b->fixed ? 8 : recordLen(seq);
+   }
+   ringInit(&b->ring, mem, sizeof(mem));
+   clock_gettime(CLOCK_MONOTONIC, &t0);
+   pthread_create(&cons, NULL, consumer, b);
+   pthread_create(&prod, NULL, producer, b);
+   pthread_join(prod, NULL);
+   pthread_join(cons, NULL);
+   clock_gettime(CLOCK_MONOTONIC, &t1);
+
+   s = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+   printf("%-9s %10lu records  %7.2f Mrec/s  %8.1f MB/s  %6.1f ns/rec\n", name,
+          (unsigned long)b->count, b->count / s / 1e6, bytes / s / 1e6, s * 1e9 / b->count);
+}
+
+int main(int argc, char ** argv) {
+   static pass_t var, fix;
+
+   var.count = argc > 1 ? strtoul(argv[1], NULL, 0) : 10000000;
+   fix.count = var.count;
+   fix.fixed = 1;
+   run(&var, "variable");
+   run(&fix, "fixed");
+   printf("PASS\n");
+   return 0;
+}
@@ -0,0 +1,104 @@
+#ifndef STM32F1XX_H
+#define STM32F1XX_H
+#include <stdint.h>
+
+/*
+ * Host stand-in for the CMSIS device and core headers: just the registers
+ * and intrinsics the application touches, backed by plain memory. See
+ * hal_shim.c for the parts that behave like hardware.
+ */
+
+typedef enum {
+   MemoryManagement_IRQn = -12,
+   BusFault_IRQn = -11,
+   UsageFault_IRQn = -10,
+   SVCall_IRQn = -5,
+   DebugMonitor_IRQn = -4,
+   PendSV_IRQn = -2,
+   SysTick_IRQn = -1,
+   DMA1_Channel4_IRQn = 14,
+   DMA1_Channel5_IRQn = 15,
+   TIM4_IRQn = 30,
+   USART1_IRQn = 37
+} IRQn_Type;
+
+typedef struct {
+   volatile uint32_t CR1, CR2, SMCR, DIER, SR, EGR, CCMR1, CCMR2, CCER;
+   volatile uint32_t CNT, PSC, ARR, RCR, CCR1, CCR2, CCR3, CCR4;
+} TIM_TypeDef;
+
+typedef struct {
+   volatile uint32_t ODR;
+} GPIO_TypeDef;
+
+typedef struct {
+   volatile uint32_t DR;
+} SPI_TypeDef;
+
+typedef struct {
+   volatile uint32_t SR, DR, BRR, CR1, CR2, CR3;
+} USART_TypeDef;
+
+typedef struct {
+   volatile uint32_t CCR, CNDTR, CPAR, CMAR;
+} DMA_Channel_TypeDef;
+
+typedef struct {
+   volatile uint32_t CTRL;
+   volatile uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct {
+   volatile uint32_t DEMCR;
+} CoreDebug_Type;
+
+extern TIM_TypeDef hostTim[5];
+extern GPIO_TypeDef hostGpio[4];
+extern SPI_TypeDef hostSpi1;
+extern USART_TypeDef hostUsart1;
+extern CoreDebug_Type hostCoreDebug;
+extern DMA_Channel_TypeDef hostDma1[7];
+DWT_Type * hostDwt(void);
+
+#define TIM2 (&hostTim[2])
+#define TIM3 (&hostTim[3])
+#define TIM4 (&hostTim[4])
+#define GPIOA (&hostGpio[0])
+#define GPIOB (&hostGpio[1])
+#define GPIOD (&hostGpio[3])
+#define SPI1 (&hostSpi1)
+#define USART1 (&hostUsart1)
+#define DMA1_Channel4 (&hostDma1[3])
+#define DMA1_Channel5 (&hostDma1[4])
+
+/* reading DWT->CYCCNT gives the host time in 72 MHz cycles */
+#define DWT (hostDwt())
+#define CoreDebug (&hostCoreDebug)
+#define DWT_CTRL_CYCCNTENA_Msk (1UL << 0)
+#define USART_SR_FE (1UL << 1)
+#define USART_SR_NE (1UL << 2)
+#define USART_SR_ORE (1UL << 3)
+#define USART_SR_RXNE (1UL << 5)
+#define USART_SR_IDLE (1UL << 4)
+#define USART_CR1_IDLEIE (1UL << 4)
+#define USART_CR1_RXNEIE (1UL << 5)
+#define USART_CR3_EIE (1UL << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk (1UL << 24)
+
+#define TIM_SR_UIF (1UL << 0)
+
+extern uint32_t SystemCoreClock;
+
+/* the emulated interrupt runs on its own thread, see hal_shim.c */
+#define __DMB() __sync_synchronize()
+#define __DSB() __sync_synchronize()
+#define __ISB() __sync_synchronize()
+#define __NOP() do { } while(0)
+static inline uint32_t __get_IPSR(void) {
+   return 0;
+}
+/* only telemPanic() masks interrupts, and it never returns to them */
+static inline void __disable_irq(void) {
+}
+
+#endif
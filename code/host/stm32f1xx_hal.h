@@ -0,0 +1,329 @@
+#ifndef STM32F1XX_HAL_H
+#define STM32F1XX_HAL_H
+#include <stdint.h>
+#include "stm32f1xx.h"
+
+/*
+ * Host stand-in for the STM32F1 HAL. Only what main.c, the MSP file and
+ * the application modules use is declared; configuration calls succeed
+ * and do nothing, the calls that move data are emulated in hal_shim.c.
+ */
+
+typedef enum {
+   HAL_OK = 0,
+   HAL_ERROR,
+   HAL_BUSY,
+   HAL_TIMEOUT
+} HAL_StatusTypeDef;
+
+#define HAL_MAX_DELAY 0xFFFFFFFFU
+
+/* GPIO */
+typedef enum {
+   GPIO_PIN_RESET = 0,
+   GPIO_PIN_SET
+} GPIO_PinState;
+
+typedef struct {
+   uint32_t Pin;
+   uint32_t Mode;
+   uint32_t Pull;
+   uint32_t Speed;
+} GPIO_InitTypeDef;
+
+#define GPIO_PIN_0 0x0001U
+#define GPIO_PIN_1 0x0002U
+#define GPIO_PIN_2 0x0004U
+#define GPIO_PIN_3 0x0008U
+#define GPIO_PIN_4 0x0010U
+#define GPIO_PIN_5 0x0020U
+#define GPIO_PIN_6 0x0040U
+#define GPIO_PIN_9 0x0200U
+#define GPIO_PIN_10 0x0400U
+#define GPIO_PIN_12 0x1000U
+#define GPIO_PIN_15 0x8000U
+#define GPIO_MODE_INPUT 0
+#define GPIO_MODE_OUTPUT_PP 1
+#define GPIO_MODE_AF_PP 2
+#define GPIO_NOPULL 0
+#define GPIO_SPEED_FREQ_LOW 2
+#define GPIO_SPEED_FREQ_HIGH 3
+
+/* RCC, NVIC, SysTick, AFIO */
+typedef struct {
+   uint32_t PLLState;
+   uint32_t PLLSource;
+   uint32_t PLLMUL;
+} RCC_PLLInitTypeDef;
+
+typedef struct {
+   uint32_t OscillatorType;
+   uint32_t HSEState;
+   uint32_t HSEPredivValue;
+   uint32_t HSIState;
+   RCC_PLLInitTypeDef PLL;
+} RCC_OscInitTypeDef;
+
+typedef struct {
+   uint32_t ClockType;
+   uint32_t SYSCLKSource;
+   uint32_t AHBCLKDivider;
+   uint32_t APB1CLKDivider;
+   uint32_t APB2CLKDivider;
+} RCC_ClkInitTypeDef;
+
+#define RCC_OSCILLATORTYPE_HSE 1
+#define RCC_HSE_ON 1
+#define RCC_HSE_PREDIV_DIV1 0
+#define RCC_HSI_ON 1
+#define RCC_PLL_ON 2
+#define RCC_PLLSOURCE_HSE 1
+#define RCC_PLL_MUL9 7
+#define RCC_CLOCKTYPE_SYSCLK 1
+#define RCC_CLOCKTYPE_HCLK 2
+#define RCC_CLOCKTYPE_PCLK1 4
+#define RCC_CLOCKTYPE_PCLK2 8
+#define RCC_SYSCLKSOURCE_PLLCLK 2
+#define RCC_SYSCLK_DIV1 0
+#define RCC_HCLK_DIV1 0
+#define RCC_HCLK_DIV2 4
+#define FLASH_LATENCY_2 2
+#define SYSTICK_CLKSOURCE_HCLK 4
+#define NVIC_PRIORITYGROUP_4 3
+
+#define __HAL_RCC_AFIO_CLK_ENABLE() do { } while(0)
+#define __HAL_RCC_GPIOA_CLK_ENABLE() do { } while(0)
+#define __HAL_RCC_GPIOB_CLK_ENABLE() do { } while(0)
+#define __HAL_RCC_GPIOD_CLK_ENABLE() do { } while(0)
+#define __HAL_RCC_SPI1_CLK_ENABLE() do { } while(0)
+#define __HAL_RCC_SPI1_CLK_DISABLE() do { } while(0)
+#define __HAL_RCC_TIM2_CLK_ENABLE() do { } while(0)
+#define __HAL_RCC_TIM2_CLK_DISABLE() do { } while(0)
+#define __HAL_RCC_TIM3_CLK_ENABLE() do { } while(0)
+#define __HAL_RCC_TIM3_CLK_DISABLE() do { } while(0)
+#define __HAL_RCC_TIM4_CLK_ENABLE() do { } while(0)
+#define __HAL_RCC_TIM4_CLK_DISABLE() do { } while(0)
+#define __HAL_RCC_USART1_CLK_ENABLE() do { } while(0)
+#define __HAL_RCC_USART1_CLK_DISABLE() do { } while(0)
+#define __HAL_RCC_DMA1_CLK_ENABLE() do { } while(0)
+#define __HAL_AFIO_REMAP_SWJ_DISABLE() do { } while(0)
+#define __HAL_AFIO_REMAP_SPI1_ENABLE() do { } while(0)
+
+/* SPI */
+typedef struct {
+   uint32_t Mode;
+   uint32_t Direction;
+   uint32_t DataSize;
+   uint32_t CLKPolarity;
+   uint32_t CLKPhase;
+   uint32_t NSS;
+   uint32_t BaudRatePrescaler;
+   uint32_t FirstBit;
+   uint32_t TIMode;
+   uint32_t CRCCalculation;
+   uint32_t CRCPolynomial;
+} SPI_InitTypeDef;
+
+typedef struct {
+   SPI_TypeDef * Instance;
+   SPI_InitTypeDef Init;
+} SPI_HandleTypeDef;
+
+#define SPI_MODE_MASTER 1
+#define SPI_DIRECTION_2LINES 0
+#define SPI_DATASIZE_16BIT 1
+#define SPI_POLARITY_HIGH 1
+#define SPI_PHASE_2EDGE 1
+#define SPI_NSS_SOFT 1
+#define SPI_BAUDRATEPRESCALER_32 4
+#define SPI_FIRSTBIT_MSB 0
+#define SPI_TIMODE_DISABLE 0
+#define SPI_CRCCALCULATION_DISABLE 0
+
+/* TIM */
+typedef struct {
+   uint32_t Prescaler;
+   uint32_t CounterMode;
+   uint32_t Period;
+   uint32_t ClockDivision;
+   uint32_t RepetitionCounter;
+   uint32_t AutoReloadPreload;
+} TIM_Base_InitTypeDef;
+
+typedef struct {
+   TIM_TypeDef * Instance;
+   TIM_Base_InitTypeDef Init;
+} TIM_HandleTypeDef;
+
+typedef struct {
+   uint32_t OCMode;
+   uint32_t Pulse;
+   uint32_t OCPolarity;
+   uint32_t OCFastMode;
+} TIM_OC_InitTypeDef;
+
+typedef struct {
+   uint32_t ICPolarity;
+   uint32_t ICSelection;
+   uint32_t ICPrescaler;
+   uint32_t ICFilter;
+} TIM_IC_InitTypeDef;
+
+typedef struct {
+   uint32_t SlaveMode;
+   uint32_t InputTrigger;
+   uint32_t TriggerPolarity;
+   uint32_t TriggerPrescaler;
+   uint32_t TriggerFilter;
+} TIM_SlaveConfigTypeDef;
+
+typedef struct {
+   uint32_t MasterOutputTrigger;
+   uint32_t MasterSlaveMode;
+} TIM_MasterConfigTypeDef;
+
+typedef struct {
+   uint32_t ClockSource;
+} TIM_ClockConfigTypeDef;
+
+#define TIM_CHANNEL_1 0x00U
+#define TIM_CHANNEL_2 0x04U
+#define TIM_CHANNEL_3 0x08U
+#define TIM_COUNTERMODE_UP 0
+#define TIM_CLOCKDIVISION_DIV1 0
+#define TIM_AUTORELOAD_PRELOAD_DISABLE 0
+#define TIM_TRGO_RESET 0
+#define TIM_MASTERSLAVEMODE_DISABLE 0
+#define TIM_OCMODE_PWM2 0x70
+#define TIM_OCPOLARITY_LOW 2
+#define TIM_OCFAST_DISABLE 0
+#define TIM_SLAVEMODE_RESET 4
+#define TIM_TS_TI1FP1 0x50
+#define TIM_INPUTCHANNELPOLARITY_RISING 0
+#define TIM_INPUTCHANNELPOLARITY_FALLING 2
+#define TIM_ICSELECTION_DIRECTTI 1
+#define TIM_ICSELECTION_INDIRECTTI 2
+#define TIM_ICPSC_DIV1 0
+#define TIM_CLOCKSOURCE_INTERNAL 0
+#define TIM_FLAG_UPDATE TIM_SR_UIF
+
+#define __HAL_TIM_SET_COMPARE(h, ch, v) (*(&(h)->Instance->CCR1 + (ch) / 4) = (v))
+#define __HAL_TIM_GET_FLAG(h, f) hostTimGetFlag((h), (f))
+uint8_t hostTimGetFlag(TIM_HandleTypeDef * htim, uint32_t flag);
+
+/* DMA */
+typedef struct {
+   uint32_t Direction;
+   uint32_t PeriphInc;
+   uint32_t MemInc;
+   uint32_t PeriphDataAlignment;
+   uint32_t MemDataAlignment;
+   uint32_t Mode;
+   uint32_t Priority;
+} DMA_InitTypeDef;
+
+typedef struct {
+   DMA_Channel_TypeDef * Instance;
+   DMA_InitTypeDef Init;
+   void * Parent;
+} DMA_HandleTypeDef;
+
+#define DMA_PERIPH_TO_MEMORY 0
+#define DMA_MEMORY_TO_PERIPH 0x10
+#define DMA_PINC_DISABLE 0
+#define DMA_MINC_ENABLE 0x80
+#define DMA_PDATAALIGN_BYTE 0
+#define DMA_MDATAALIGN_BYTE 0
+#define DMA_NORMAL 0
+#define DMA_CIRCULAR 0x20
+#define DMA_PRIORITY_LOW 0
+
+#define __HAL_LINKDMA(h, field, dma) \
+   do { (h)->field = &(dma); (dma).Parent = (h); } while(0)
+
+/* UART */
+typedef struct {
+   uint32_t BaudRate;
+   uint32_t WordLength;
+   uint32_t StopBits;
+   uint32_t Parity;
+   uint32_t Mode;
+   uint32_t HwFlowCtl;
+   uint32_t OverSampling;
+} UART_InitTypeDef;
+
+typedef struct {
+   USART_TypeDef * Instance;
+   UART_InitTypeDef Init;
+   DMA_HandleTypeDef * hdmatx;
+   DMA_HandleTypeDef * hdmarx;
+} UART_HandleTypeDef;
+
+#define UART_WORDLENGTH_8B 0
+#define UART_STOPBITS_1 0
+#define UART_PARITY_NONE 0
+#define UART_MODE_TX_RX 0x0C
+#define UART_HWCONTROL_NONE 0
+#define UART_OVERSAMPLING_16 0
+#define UART_IT_RXNE USART_CR1_RXNEIE
+#define UART_IT_IDLE USART_CR1_IDLEIE
+#define __HAL_UART_ENABLE_IT(h, it) ((h)->Instance->CR1 |= (it))
+
+HAL_StatusTypeDef HAL_Init(void);
+void HAL_MspInit(void);
+uint32_t HAL_GetTick(void);
+HAL_StatusTypeDef HAL_RCC_OscConfig(RCC_OscInitTypeDef * osc);
+HAL_StatusTypeDef HAL_RCC_ClockConfig(RCC_ClkInitTypeDef * clk, uint32_t latency);
+uint32_t HAL_RCC_GetHCLKFreq(void);
+uint32_t HAL_SYSTICK_Config(uint32_t ticks);
+void HAL_SYSTICK_CLKSourceConfig(uint32_t source);
+void HAL_NVIC_SetPriorityGrouping(uint32_t group);
+void HAL_NVIC_SetPriority(IRQn_Type irq, uint32_t pre, uint32_t sub);
+void HAL_NVIC_EnableIRQ(IRQn_Type irq);
+void HAL_NVIC_DisableIRQ(IRQn_Type irq);
+
+void HAL_GPIO_Init(GPIO_TypeDef * port, GPIO_InitTypeDef * init);
+void HAL_GPIO_DeInit(GPIO_TypeDef * port, uint32_t pin);
+void HAL_GPIO_WritePin(GPIO_TypeDef * port, uint16_t pin, GPIO_PinState state);
+void HAL_GPIO_TogglePin(GPIO_TypeDef * port, uint16_t pin);
+
+HAL_StatusTypeDef HAL_SPI_Init(SPI_HandleTypeDef * hspi);
+void HAL_SPI_MspInit(SPI_HandleTypeDef * hspi);
+
+HAL_StatusTypeDef HAL_TIM_Base_Init(TIM_HandleTypeDef * htim);
+void HAL_TIM_Base_MspInit(TIM_HandleTypeDef * htim);
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef * htim);
+HAL_StatusTypeDef HAL_TIM_ConfigClockSource(TIM_HandleTypeDef * htim, TIM_ClockConfigTypeDef * cfg);
+HAL_StatusTypeDef HAL_TIM_PWM_Init(TIM_HandleTypeDef * htim);
+void HAL_TIM_PWM_MspInit(TIM_HandleTypeDef * htim);
+HAL_StatusTypeDef HAL_TIM_PWM_ConfigChannel(TIM_HandleTypeDef * htim, TIM_OC_InitTypeDef * cfg,
+                                            uint32_t channel);
+HAL_StatusTypeDef HAL_TIM_IC_Init(TIM_HandleTypeDef * htim);
+void HAL_TIM_IC_MspInit(TIM_HandleTypeDef * htim);
+HAL_StatusTypeDef HAL_TIM_IC_ConfigChannel(TIM_HandleTypeDef * htim, TIM_IC_InitTypeDef * cfg,
+                                           uint32_t channel);
+HAL_StatusTypeDef HAL_TIM_SlaveConfigSynchronization(TIM_HandleTypeDef * htim,
+                                                     TIM_SlaveConfigTypeDef * cfg);
+HAL_StatusTypeDef HAL_TIMEx_MasterConfigSynchronization(TIM_HandleTypeDef * htim,
+                                                        TIM_MasterConfigTypeDef * cfg);
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef * htim);
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef * huart);
+void HAL_UART_MspInit(UART_HandleTypeDef * huart);
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef * huart, uint8_t * data,
+                                        uint16_t size);
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef * huart, uint8_t * data,
+                                    uint16_t size, uint32_t timeout);
+HAL_StatusTypeDef HAL_UART_AbortTransmit(UART_HandleTypeDef * huart);
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef * huart);
+HAL_StatusTypeDef HAL_UART_Receive_DMA(UART_HandleTypeDef * huart, uint8_t * data,
+                                       uint16_t size);
+
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef * hdma);
+HAL_StatusTypeDef HAL_DMA_DeInit(DMA_HandleTypeDef * hdma);
+
+
+/* as stm32f1xx_hal_conf.h does on the target */
+#include "main.h"
+
+#endif
@@ -0,0 +1,823 @@
+/*
+ * Telemetry decoder using host/telemdec.hpp.
+ *
+ * Usage: telemcat [-q] [capture]
+ *    Decodes a capture of the USART1 stream (a file, a configured serial
+ *    device, or stdin) and prints one line per record: type, seq, time
+ *    (board us), law, torque, v[0..3]. Delta coded state records are expanded, each
+ *    printed with the seq of its frame. Subscribed channels are printed
+ *    as "chan seq time name=value ...". -q prints only the counters at
+ *    the end.
+ *
+ * Usage: telemcat -l [-q] [-t] [-m max baud] device
+ *    Same from a serial device, playing the host side of the link setup
+ *    in Src/proto.h: sends LINK_DOWN to have the board offer again
+ *    soon, accepts its offers up to the max baud (default any), checks
+ *    the test burst, and falls back to the safe rate when the stream
+ *    goes bad. Linux only, any baud via termios2.
+ *    Pings the board every PING_MS to relate its clock to the host's;
+ *    -t puts the host time of each record, Unix seconds, in front of its
+ *    line once the first pong is in.
+ *
+ * Usage: telemcat -b [MB]
+ *    Decode throughput run. Frames made by protoFrame(), as the firmware
+ *    makes them, with every 1000th sequence number skipped and every
+ *    997th frame sent with a bad CRC, are fed in 4 kB chunks so many
+ *    frames straddle two chunks. Then a swing-up like state stream is
+ *    delta coded the way the firmware does it, with a frame dropped now
+ *    and then, and the bytes per record of both codings are compared.
+ *    Last, ClockSync is fed round trips of a board clock 40 ppm fast with
+ *    random queueing delays, and its host times are checked against the
+ *    true ones. Then Src/chan.c samples a set of channels at different
+ *    decimations, changed halfway, and each value must come out of
+ *    telemdec::channels() at its tick. Exits non-zero unless every
+ *    record, value and counter comes out as sent and the clock is right
+ *    within SYNC_TOLERANCE_US.
+ */
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+/* the register names in here before termbits.h defines CR1 and the like */
+extern "C" {
+#include "stm32f1xx.h"
+#include "chan.h"
+}
+#include <sys/ioctl.h>
+#include <asm/termbits.h>
+#include "telemdec.hpp"
+
+static const char * const typeNames[] = { "?", "state", "health", "task", "timing" };
+
+/** @brief Time between clock sync pings, ms **/
+#define PING_MS 250
+/** @brief Largest host time error the clock sync run accepts, us **/
+#define SYNC_TOLERANCE_US 20
+
+/* set by -t: print host times from this */
+static const telemdec::ClockSync * stamps;
+
+/* the firmware around chan.c in the channel run: the tick being sampled,
+   the CHANNELS frames it sends, and the PWM timer it reads */
+static uint32_t chanTick;
+static std::vector<uint8_t> chanStream;
+static uint8_t chanBody[CHAN_BODY_MAX];
+static uint16_t chanSeq;
+TIM_TypeDef hostTim[5];
+
+/** @brief Host side of the link setup, see proto.h **/
+struct Link {
+   int fd;
+   uint32_t maxBaud;
+   uint32_t baud = PROTO_SAFE_BAUD;
+   uint32_t testBaud = 0;   /* switched for a test, result not sent yet */
+   uint32_t good = 0;
+   uint16_t seq = 0;
+   std::chrono::steady_clock::time_point lastGood = std::chrono::steady_clock::now();
+   telemdec::ClockSync sync;
+   int64_t lastPing = 0;    /* host time the last ping went out */
+   int64_t pingAt = 0;      /* the same, 0 once answered */
+   uint16_t pingSeq = 0;
+};
+
+
+//-------------------------------------------------------------------------------------
+/** @brief   Host clock for the sync, Unix time
+ *  @return  Microseconds since 1970
+ */
+static int64_t hostUs() {
+   return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Start a line with the host time of a board time, if -t and known
+ *  @param   t Board time
+ */
+static void printStamp(uint32_t t) {
+   if(stamps && stamps->synced()) {
+      int64_t h = stamps->toHost(t);
+      std::printf("%lld.%06lld ", (long long)(h / 1000000), (long long)(h % 1000000));
+   }
+}
+
+
+//-------------------------------------------------------------------------------------
+static void printStats(const telemdec::Stats & s) {
+   std::fprintf(stderr, "%llu bytes  %llu frames  %llu bad  %llu oversize  %llu lost\n",
+                (unsigned long long)s.bytes, (unsigned long long)s.frames,
+                (unsigned long long)s.bad, (unsigned long long)s.oversize,
+                (unsigned long long)s.lost);
+}
+
+//-------------------------------------------------------------------------------------
+static void printStateStats(const telemdec::StateStats & s) {
+   std::fprintf(stderr, "%llu state records  %llu keyframes  %llu skipped  %llu bad\n",
+                (unsigned long long)s.records, (unsigned long long)s.keys,
+                (unsigned long long)s.skipped, (unsigned long long)s.bad);
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Set a serial port to raw 8N1 at any rate
+ *  @param   fd Port
+ *  @param   baud Rate
+ *  @return  true if the driver took the rate within 2 %
+ */
+static bool setBaud(int fd, uint32_t baud) {
+   struct termios2 t;
+
+   ioctl(fd, TCSBRK, 1);
+   if(ioctl(fd, TCGETS2, &t)) {
+      return false;
+   }
+   t.c_cflag &= ~(CBAUD | CSIZE | PARENB | CSTOPB | CRTSCTS);
+   t.c_cflag |= BOTHER | CS8 | CLOCAL | CREAD;
+   t.c_iflag = 0;
+   t.c_oflag = 0;
+   t.c_lflag = 0;
+   t.c_cc[VMIN] = 0;
+   t.c_cc[VTIME] = 0;
+   t.c_ispeed = t.c_ospeed = baud;
+   if(ioctl(fd, TCSETS2, &t) || ioctl(fd, TCGETS2, &t)) {
+      return false;
+   }
+   return t.c_ospeed > baud * 0.98 && t.c_ospeed < baud * 1.02;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Send a link setup message and wait until it is out
+ *  @param   l Link
+ *  @param   id Message id
+ *  @param   baud Body baud
+ *  @param   n Body count
+ */
+static void linkSend(Link & l, uint8_t id, uint32_t baud, uint32_t n) {
+   uint8_t frame[PROTO_FRAME_MAX(sizeof(protoLink_t))];
+   protoLink_t msg = { baud, n };
+   uint16_t len = protoFrame(id, l.seq++, &msg, sizeof(msg), frame);
+
+   if(write(l.fd, frame, len) != len) {
+      std::perror("write");
+   }
+   ioctl(l.fd, TCSBRK, 1);
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Go to a rate, or back to the safe one if the adapter cannot
+ *  @param   l Link
+ *  @param   baud Rate
+ *  @return  true if the port runs at baud now
+ */
+static bool linkSwitch(Link & l, uint32_t baud) {
+   bool ok = setBaud(l.fd, baud);
+
+   if(!ok) {
+      baud = PROTO_SAFE_BAUD;
+      setBaud(l.fd, baud);
+   }
+   l.baud = baud;
+   l.lastGood = std::chrono::steady_clock::now();
+   std::fprintf(stderr, "link at %lu baud\n", (unsigned long)baud);
+   return ok;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Handle a link setup message from the board
+ *  @param   l Link
+ *  @param   f Frame
+ */
+static void linkFrame(Link & l, const telemdec::Frame & f) {
+   protoLink_t msg;
+
+   if(f.size < sizeof(msg)) {
+      return;
+   }
+   std::memcpy(&msg, f.body, sizeof(msg));
+   if(f.id == PROTO_LINK_OFFER) {
+      if(l.maxBaud && msg.baud > l.maxBaud) {
+         linkSend(l, PROTO_LINK_ACCEPT, 0, 0);
+         return;
+      }
+      linkSend(l, PROTO_LINK_ACCEPT, msg.baud, 0);
+      l.good = 0;
+      l.testBaud = linkSwitch(l, msg.baud) ? msg.baud : 0;
+   } else if(f.id == PROTO_LINK_TEST && msg.baud == l.testBaud &&
+             f.size == sizeof(msg) + PROTO_LINK_PATTERN) {
+      for(int k = 0; k < PROTO_LINK_PATTERN; k++) {
+         if(f.body[sizeof(msg) + k] != PROTO_LINK_BYTE(msg.n, k)) {
+            return;
+         }
+      }
+      if(++l.good == PROTO_LINK_FRAMES) {
+         linkSend(l, PROTO_LINK_RESULT, l.testBaud, l.good);
+         l.testBaud = 0;
+      }
+   }
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Time outs of the link setup, after every read
+ *  @details No good frame for half of PROTO_LINK_TIMEOUT_MS at a faster
+ *           rate means the board is back at the safe rate, or will be
+ *           before it sends its next offer.
+ *  @param   l Link
+ */
+static void linkCheck(Link & l) {
+   auto quiet = std::chrono::steady_clock::now() - l.lastGood;
+
+   if(l.baud != PROTO_SAFE_BAUD && quiet > std::chrono::milliseconds(PROTO_LINK_TIMEOUT_MS / 2)) {
+      if(l.testBaud) {
+         linkSend(l, PROTO_LINK_RESULT, l.testBaud, l.good);
+         l.testBaud = 0;
+      }
+      linkSwitch(l, PROTO_SAFE_BAUD);
+   }
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Send a clock sync ping every PING_MS, after every read
+ *  @details Not while a rate is being tested. A ping without a pong by the
+ *           next one is forgotten.
+ *  @param   l Link
+ */
+static void linkPing(Link & l) {
+   uint8_t frame[PROTO_FRAME_MAX(0)];
+   int64_t now = hostUs();
+   uint16_t len;
+
+   if(l.testBaud || now - l.lastPing < PING_MS * 1000) {
+      return;
+   }
+   l.pingSeq = l.seq;
+   len = protoFrame(PROTO_CMD_PING, l.seq++, nullptr, 0, frame);
+   l.pingAt = l.lastPing = hostUs();
+   if(write(l.fd, frame, len) != len) {
+      std::perror("write");
+   }
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Take a pong, if it answers the last ping
+ *  @param   l Link
+ *  @param   f Frame
+ *  @param   at Host time it was read
+ */
+static void linkPong(Link & l, const telemdec::Frame & f, int64_t at) {
+   protoPong_t p;
+
+   if(f.size != sizeof(p) || !l.pingAt) {
+      return;
+   }
+   std::memcpy(&p, f.body, sizeof(p));
+   if(p.seq == l.pingSeq) {
+      l.sync.pong(l.pingAt, p, at);
+      l.pingAt = 0;
+   }
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Print a record
+ *  @param   id Record type
+ *  @param   seq Frame counter
+ *  @param   r Record
+ */
+static void printRecord(uint8_t id, uint16_t seq, const protoRecord_t & r) {
+   printStamp(r.time);
+   std::printf("%s %u %lu %u %d %ld %ld %ld %ld\n", typeNames[id], seq,
+               (unsigned long)r.time, r.law, r.torque, (long)r.v[0],
+               (long)r.v[1], (long)r.v[2], (long)r.v[3]);
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Print a frame other than a state record
+ *  @param   f Frame
+ */
+static void printFrame(const telemdec::Frame & f) {
+   protoRecord_t r;
+
+   if(f.id == PROTO_CHANNELS) {
+      bool first = true;
+      bool ok = telemdec::channels(f, [&](uint32_t time, int c, int64_t v) {
+         if(first) {
+            printStamp(time);
+            std::printf("chan %u %lu", f.seq, (unsigned long)time);
+            first = false;
+         }
+         std::printf(" %s=%lld", protoChans[c].name, (long long)v);
+      });
+      std::printf(ok ? "\n" : " malformed\n");
+      return;
+   }
+
+   if(f.id == PROTO_TEXT) {
+      std::printf("text %u %.*s\n", f.seq, (int)f.size, reinterpret_cast<const char *>(f.body));
+      return;
+   }
+   if(f.id < PROTO_STATE || f.id > PROTO_TIMING || f.size != PROTO_RECORD_LEN) {
+      std::printf("id %u seq %u, %zu bytes\n", f.id, f.seq, f.size);
+      return;
+   }
+   std::memcpy(&r, f.body, PROTO_RECORD_LEN);
+   printRecord(f.id, f.seq, r);
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Decode a capture and print its records
+ *  @param   path File or device, NULL for stdin
+ *  @param   quiet Only print the counters
+ *  @param   link Play the host side of the link setup, path is a serial device
+ *  @param   maxBaud Highest rate to accept, 0 for any
+ *  @param   stamp Print host times, needs link
+ *  @return  Exit status
+ */
+static int cat(const char * path, bool quiet, bool link, uint32_t maxBaud, bool stamp) {
+   static uint8_t buf[1 << 16];
+   telemdec::Decoder dec;
+   telemdec::StateDecoder states;
+   int fd = path ? open(path, link ? O_RDWR | O_NOCTTY : O_RDONLY) : STDIN_FILENO;
+   struct pollfd p = { fd, POLLIN, 0 };
+   Link l;
+   int64_t at;
+   ssize_t n;
+
+   if(fd < 0) {
+      std::perror(path);
+      return 1;
+   }
+   l.fd = fd;
+   l.maxBaud = maxBaud;
+   stamps = stamp ? &l.sync : nullptr;
+   if(link && !setBaud(fd, PROTO_SAFE_BAUD)) {
+      std::fprintf(stderr, "%s: cannot set %d baud\n", path, PROTO_SAFE_BAUD);
+      return 1;
+   }
+   if(link) {
+      /* the board offers less often while nobody answers, this resets it */
+      linkSend(l, PROTO_LINK_DOWN, 0, 0);
+   }
+   for(;;) {
+      if(link) {
+         poll(&p, 1, 10);
+      }
+      n = read(fd, buf, sizeof(buf));
+      at = hostUs();
+      if(n < 0 || (n == 0 && !link)) {
+         break;
+      }
+      dec.feed(buf, n, [&](const telemdec::Frame & f) {
+         l.lastGood = std::chrono::steady_clock::now();
+         states.frame(f, [&](const protoRecord_t & r) {
+            if(!quiet) {
+               printRecord(PROTO_STATE, f.seq, r);
+            }
+         });
+         if(link && f.id == PROTO_CMD_PONG) {
+            linkPong(l, f, at);
+         } else if(link && f.id >= PROTO_LINK_OFFER && f.id <= PROTO_LINK_DOWN) {
+            linkFrame(l, f);
+         } else if(!quiet && f.id != PROTO_STATE && f.id != PROTO_STATE_DELTA) {
+            printFrame(f);
+         }
+      });
+      if(link) {
+         linkCheck(l);
+         linkPing(l);
+      }
+   }
+   printStats(dec.stats());
+   printStateStats(states.stats());
+   if(l.sync.synced()) {
+      std::fprintf(stderr, "clock drift %.2f ppm, fastest round trip %lld us, %d pongs used\n",
+                   l.sync.driftPpm(), (long long)l.sync.minDelay(), l.sync.used());
+   }
+   return 0;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Body of test frame k, time = k and v derived from it
+ *  @param   k Frame number
+ *  @param   r Filled with the body
+ */
+static void testRecord(uint32_t k, protoRecord_t * r) {
+   r->law = k % 7;
+   r->torque = (int16_t)(k * 31);
+   r->time = k;
+   for(int i = 0; i < 4; i++) {
+      r->v[i] = (int32_t)(k * 2654435761u) >> (i * 8);
+   }
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   State record k of a swing-up: the pendulum swinging up over
+ *           20 s at 500 records/s, arm and torque following, a little noise,
+ *           and a few us of jitter on the time
+ *  @param   k Record number
+ *  @param   r Filled with the record
+ */
+static void swingRecord(uint32_t k, protoRecord_t * r) {
+   double t = k / 500.0;
+   double amp = t < 20 ? t / 20 * M_PI : M_PI;
+   double a = amp * std::sin(2 * M_PI * 0.8 * t);
+   int noise = (int)((k * 2654435761u) >> 30) - 2;
+
+   r->law = t < 20 ? 6 : 4;
+   r->torque = (int16_t)(400 * std::cos(2 * M_PI * 0.8 * t) + noise);
+   r->time = 2000 * k + (k * 40503u >> 7) % 5;
+   r->v[0] = (int32_t)(3000 * std::sin(2 * M_PI * 0.8 * t + 1)) + noise;
+   r->v[1] = (uint16_t)(a / (2 * M_PI) * 65536 + noise);
+   r->v[2] = (int32_t)(amp * 0.8 * std::cos(2 * M_PI * 0.8 * t) * 65536) + 4 * noise;
+   r->v[3] = 0;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Delta coding run, the firmware's telemState() on the host
+ *  @param   records State records to send
+ *  @return  Number of failures
+ */
+static int benchDelta(uint32_t records) {
+   std::vector<uint8_t> stream;
+   uint8_t frame[PROTO_FRAME_MAX(PROTO_BODY_MAX)];
+   uint8_t batch[PROTO_BODY_MAX];
+   uint16_t batchFill = 0;
+   uint8_t left = 0;
+   uint16_t seq = 0;
+   uint32_t frames = 0;
+   size_t fullBytes = 0;
+   protoDelta_t delta;
+
+   auto send = [&](uint8_t id, const void * body, uint16_t len) {
+      uint16_t n = protoFrame(id, seq++, body, len, frame);
+      /* lose every 300th frame on the link */
+      if(++frames % 300) {
+         stream.insert(stream.end(), frame, frame + n);
+      }
+   };
+   for(uint32_t k = 0; k < records; k++) {
+      protoRecord_t r;
+      uint8_t code[PROTO_DELTA_MAX];
+      uint16_t n;
+      swingRecord(k, &r);
+      fullBytes += protoFrame(PROTO_STATE, 0, &r, PROTO_RECORD_LEN, frame);
+      if(!left) {
+         if(batchFill) {
+            send(PROTO_STATE_DELTA, batch, batchFill);
+            batchFill = 0;
+         }
+         send(PROTO_STATE, &r, PROTO_RECORD_LEN);
+         protoDeltaKey(&delta, &r);
+         left = PROTO_KEY_EVERY;
+         continue;
+      }
+      n = protoDeltaEncode(&delta, &r, code);
+      if(batchFill + n > PROTO_BODY_MAX) {
+         send(PROTO_STATE_DELTA, batch, batchFill);
+         batchFill = 0;
+      }
+      std::memcpy(batch + batchFill, code, n);
+      batchFill += n;
+      left--;
+   }
+   if(batchFill) {
+      send(PROTO_STATE_DELTA, batch, batchFill);
+   }
+
+   telemdec::Decoder dec;
+   telemdec::StateDecoder states;
+   uint32_t wrong = 0;
+   dec.feed(stream.data(), stream.size(), [&](const telemdec::Frame & f) {
+      states.frame(f, [&](const protoRecord_t & r) {
+         protoRecord_t want;
+         swingRecord(r.time / 2000, &want);
+         if(std::memcmp(&r, &want, PROTO_RECORD_LEN)) {
+            wrong++;
+         }
+      });
+   });
+   const telemdec::StateStats & st = states.stats();
+   printStateStats(st);
+   std::printf("state records  full %.1f  delta %.1f bytes each, %.2fx\n",
+               (double)fullBytes / records, (double)stream.size() / st.records,
+               (double)fullBytes / records * st.records / stream.size());
+   /* a lost frame costs the records up to the next keyframe, never more */
+   if(wrong || st.bad || st.records < records - (frames / 300 + 1) * PROTO_KEY_EVERY) {
+      std::printf("FAIL: %lu of %lu records decoded, %lu wrong\n",
+                  (unsigned long)st.records, (unsigned long)records, (unsigned long)wrong);
+      return 1;
+   }
+   return 0;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Clock sync run: pings every PING_MS for 10 minutes against a
+ *           board clock 40 ppm fast that wraps a second in
+ *  @details Each way takes 100 us at best; three times in four it is
+ *           queued for up to a further millisecond, and the board takes
+ *           up to 400 us to answer. Once the estimate settled, after 30 s,
+ *           every ping is followed by a record whose host time must come
+ *           out right.
+ *  @return  Number of failures
+ */
+static int benchSync() {
+   const double rate = 1 + 40e-6;
+   const int64_t start = 1700000000000000;
+   const uint32_t boardStart = 0xFFF00000u;
+   telemdec::ClockSync sync;
+   uint32_t rnd = 1;
+   int64_t worst = 0;
+
+   auto board = [&](int64_t host) {
+      return boardStart + (uint32_t)std::llround((host - start) * rate);
+   };
+   auto random = [&](uint32_t max) {
+      rnd = rnd * 1664525u + 1013904223u;
+      return (int64_t)((rnd >> 8) % (max + 1));
+   };
+   auto way = [&]() {
+      return 100 + (random(3) ? random(1000) : random(5));
+   };
+   for(uint32_t k = 0; k < 600000 / PING_MS; k++) {
+      int64_t t1 = start + k * PING_MS * 1000LL;
+      int64_t rx = t1 + way();
+      int64_t tx = rx + 20 + random(400);
+      protoPong_t p = { (uint16_t)k, board(rx), board(tx) };
+      sync.pong(t1, p, tx + way());
+
+      if(k >= 30000 / PING_MS) {
+         int64_t at = t1 + random(PING_MS * 1000);
+         int64_t err = std::llabs(sync.toHost(board(at)) - at);
+         worst = err > worst ? err : worst;
+      }
+   }
+   std::printf("clock sync  drift %.2f ppm (40), worst host time error %lld us\n",
+               sync.driftPpm(), (long long)worst);
+   if(worst > SYNC_TOLERANCE_US || std::fabs(sync.driftPpm() - 40) > 1) {
+      std::printf("FAIL: clock sync off\n");
+      return 1;
+   }
+   return 0;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Telemetry ring of the channel run: one body at a time
+ *  @param   id Message, PROTO_CHANNELS
+ *  @param   len Largest body
+ *  @return  Body to fill
+ */
+extern "C" uint8_t * telemReserveBody(uint8_t id, uint16_t len) {
+   return id == PROTO_CHANNELS && len <= sizeof(chanBody) ? chanBody : nullptr;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Send the reserved body as a CHANNELS frame
+ *  @param   len Bytes of body
+ */
+extern "C" void telemCommitBody(uint16_t len) {
+   uint8_t frame[PROTO_FRAME_MAX(PROTO_BODY_MAX)];
+   uint16_t n = protoFrame(PROTO_CHANNELS, chanSeq++, chanBody, len, frame);
+   chanStream.insert(chanStream.end(), frame, frame + n);
+}
+
+extern "C" uint32_t telemDrops(void) {
+   return chanTick / 50;
+}
+
+extern "C" ctrlId_t ctrlActive(void) {
+   return (ctrlId_t)(chanTick / 100 % CTRL_COUNT);
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Decimation of a channel in the channel run
+ *  @details Channels at rates that share ticks and some that do not; at
+ *           tick 600 the pendulum is dropped and the arm rate added.
+ *  @param   ch protoChanId_t
+ *  @param   tick Control tick
+ *  @return  Ticks per value, 0 if not subscribed at that tick
+ */
+static uint16_t chanDecim(int ch, uint32_t tick) {
+   switch(ch) {
+   case PROTO_CHAN_PEND:
+      return tick < 600 ? 1 : 0;
+   case PROTO_CHAN_ARM:
+      return 4;
+   case PROTO_CHAN_ARM_RATE:
+      return tick < 600 ? 0 : 2;
+   case PROTO_CHAN_TORQUE:
+      return 10;
+   case PROTO_CHAN_LAW:
+      return 7;
+   case PROTO_CHAN_PWM_A:
+      return 3;
+   case PROTO_CHAN_LATENCY:
+      return 5;
+   case PROTO_CHAN_DROPS:
+      return 25;
+   default:
+      return 0;
+   }
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Value of a channel at a tick in the channel run
+ *  @param   ch protoChanId_t
+ *  @param   tick Control tick
+ *  @return  Value as telemdec::channels() gives it
+ */
+static int64_t chanExpect(int ch, uint32_t tick) {
+   switch(ch) {
+   case PROTO_CHAN_PEND:
+      return (uint16_t)(tick * 977);
+   case PROTO_CHAN_ARM:
+      return -1021 * (int32_t)tick;
+   case PROTO_CHAN_ARM_RATE:
+      return (int32_t)(tick * 2654435761u);
+   case PROTO_CHAN_TORQUE:
+      return (int32_t)(tick % 2001) - 1000;
+   case PROTO_CHAN_LAW:
+      return tick / 100 % CTRL_COUNT;
+   case PROTO_CHAN_PWM_A:
+      return tick % 1440;
+   case PROTO_CHAN_LATENCY:
+      return tick + 5;
+   default:
+      return tick / 50;
+   }
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Channel run: the firmware's chanSample() against
+ *           telemdec::channels()
+ *  @details 1200 ticks with the subscriptions of chanDecim(); every value
+ *           must come out of the decoder at its tick and no other, with
+ *           the value chanExpect() gives, so both the decimation and the
+ *           packed layout of each CHANNELS body are checked.
+ *  @return  Number of failures
+ */
+static int benchChannels() {
+   const uint32_t ticks = 1200;
+   uint32_t want = 0, got = 0, wrong = 0, frames = 0;
+   ctrlState_t s;
+
+   std::memset(&s, 0, sizeof(s));
+   chanInit();
+   for(chanTick = 0; chanTick < ticks; chanTick++) {
+      for(int c = 0; c < PROTO_CHAN_COUNT; c++) {
+         uint16_t d = chanDecim(c, chanTick);
+         if(!chanTick || d != chanDecim(c, chanTick - 1)) {
+            chanSubscribe(c, d);
+         }
+         want += d && chanTick % d == 0;
+      }
+      s.tick = chanTick;
+      s.time = chanTick * (1000000 / CTRL_HZ);
+      s.pend = chanExpect(PROTO_CHAN_PEND, chanTick);
+      s.arm = chanExpect(PROTO_CHAN_ARM, chanTick);
+      s.armRate = chanExpect(PROTO_CHAN_ARM_RATE, chanTick);
+      s.lastOut = chanExpect(PROTO_CHAN_TORQUE, chanTick);
+      TIM2->CCR1 = chanExpect(PROTO_CHAN_PWM_A, chanTick);
+      chanSample(&s, chanExpect(PROTO_CHAN_LATENCY, chanTick), 0, 0);
+   }
+
+   telemdec::Decoder dec;
+   dec.feed(chanStream.data(), chanStream.size(), [&](const telemdec::Frame & f) {
+      frames++;
+      if(!telemdec::channels(f, [&](uint32_t time, int c, int64_t v) {
+         uint32_t tick = time / (1000000 / CTRL_HZ);
+         uint16_t d = chanDecim(c, tick);
+         if(!d || tick % d || v != chanExpect(c, tick)) {
+            wrong++;
+         }
+         got++;
+      })) {
+         wrong++;
+      }
+   });
+   std::printf("channels  %lu values in %lu frames, %.1f bytes each\n", (unsigned long)got,
+               (unsigned long)frames, (double)chanStream.size() / frames);
+   if(wrong || got != want || frames != chanSeq) {
+      std::printf("FAIL: %lu of %lu channel values decoded, %lu wrong\n", (unsigned long)got,
+                  (unsigned long)want, (unsigned long)wrong);
+      return 1;
+   }
+   return 0;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Decode throughput run
+ *  @param   mb Approximate size of the stream, MB
+ *  @return  Exit status
+ */
+static int bench(double mb) {
+   const uint32_t frames = mb * 1e6 / 30;
+   std::vector<uint8_t> stream;
+   uint32_t skipped = 0;
+   uint32_t corrupt = 0;
+   uint32_t wrong = 0;
+   uint32_t good = 0;
+   uint16_t seq = 0;
+   uint8_t frame[PROTO_FRAME_MAX(PROTO_BODY_MAX)];
+
+   stream.reserve(frames * (size_t)PROTO_FRAME_MAX(PROTO_RECORD_LEN));
+   for(uint32_t k = 0; k < frames; k++) {
+      protoRecord_t r;
+      uint16_t len;
+      testRecord(k, &r);
+      if(k % 1000 == 999) {
+         seq++;
+         skipped++;
+      }
+      if(k % 997 == 996) {
+         /* a packet with a wrong CRC; every 1 bit error is caught */
+         uint8_t packet[PROTO_RECORD_LEN + PROTO_OVERHEAD];
+         uint16_t crc;
+         packet[0] = PROTO_STATE;
+         packet[1] = seq & 0xFF;
+         packet[2] = seq >> 8;
+         std::memcpy(packet + 3, &r, PROTO_RECORD_LEN);
+         crc = protoCrc16(0xFFFF, packet, PROTO_RECORD_LEN + 3) ^ 1;
+         packet[PROTO_RECORD_LEN + 3] = crc & 0xFF;
+         packet[PROTO_RECORD_LEN + 4] = crc >> 8;
+         len = protoCobsEncode(packet, sizeof(packet), frame);
+         corrupt++;
+      } else {
+         len = protoFrame(PROTO_STATE, seq, &r, PROTO_RECORD_LEN, frame);
+      }
+      stream.insert(stream.end(), frame, frame + len);
+      seq++;
+   }
+
+   telemdec::Decoder dec;
+   const size_t chunk = 4096;
+   auto t0 = std::chrono::steady_clock::now();
+   for(size_t at = 0; at < stream.size(); at += chunk) {
+      size_t n = stream.size() - at < chunk ? stream.size() - at : chunk;
+      dec.feed(stream.data() + at, n, [&](const telemdec::Frame & f) {
+         telemdec::RecordView v(f);
+         protoRecord_t r;
+         testRecord(v.time(), &r);
+         if(f.size != PROTO_RECORD_LEN || v.law() != r.law || v.torque() != r.torque ||
+            v.v(0) != r.v[0] || v.v(3) != r.v[3]) {
+            wrong++;
+         }
+         good++;
+      });
+   }
+   auto t1 = std::chrono::steady_clock::now();
+   double s = std::chrono::duration<double>(t1 - t0).count();
+   const telemdec::Stats & st = dec.stats();
+
+   printStats(st);
+   std::printf("decode %8.1f MB/s  %6.2f Mframes/s  %5.1f ns/frame\n",
+               st.bytes / s / 1e6, st.frames / s / 1e6, s * 1e9 / frames);
+   /* bad frames are missing from the sequence too, unless the last one is */
+   if(wrong || good != frames - corrupt || st.bad != corrupt || st.oversize ||
+      st.lost < skipped + corrupt - 1 || st.lost > skipped + corrupt) {
+      std::printf("FAIL: expected %lu frames, %lu bad, %lu lost; %lu records wrong\n",
+                  (unsigned long)(frames - corrupt), (unsigned long)corrupt,
+                  (unsigned long)(skipped + corrupt), (unsigned long)wrong);
+      return 1;
+   }
+   if(benchDelta(20000) || benchSync() || benchChannels()) {
+      return 1;
+   }
+   std::printf("PASS\n");
+   return 0;
+}
+
+int main(int argc, char ** argv) {
+   const char * path = NULL;
+   uint32_t maxBaud = 0;
+   bool quiet = false;
+   bool link = false;
+   bool stamp = false;
+   int c;
+
+   while((c = getopt(argc, argv, "bqltm:")) != -1) {
+      if(c == 'b') {
+         return bench(optind < argc ? std::atof(argv[optind]) : 100);
+      } else if(c == 'q') {
+         quiet = true;
+      } else if(c == 'l') {
+         link = true;
+      } else if(c == 't') {
+         stamp = true;
+      } else if(c == 'm') {
+         maxBaud = std::strtoul(optarg, NULL, 0);
+      } else {
+         std::fprintf(stderr, "usage: telemcat [-q] [-l [-t] [-m max baud]] [capture] | -b [MB]\n");
+         return 1;
+      }
+   }
+   if(optind < argc) {
+      path = argv[optind];
+   }
+   if(link && !path) {
+      std::fprintf(stderr, "telemcat: -l needs a serial device\n");
+      return 1;
+   }
+   return cat(path, quiet, link, maxBaud, stamp);
+}
@@ -0,0 +1,508 @@
+#ifndef TELEMDEC_HPP
+#define TELEMDEC_HPP
+/*
+ * Host decoder for the telemetry wire format in Src/proto.h.
+ *
+ * Header only, no allocation. Decoder::feed() takes raw bytes as they
+ * come from the serial port or a capture file, in chunks of any size, and
+ * calls back once per good frame. Frames are COBS decoded in place in the
+ * caller's buffer and handed out as views into it, so a frame is only
+ * copied when it straddles two chunks. Corrupt, oversized and missing
+ * frames are counted, never thrown.
+ *
+ *    telemdec::Decoder dec;
+ *    dec.feed(buf, n, [](const telemdec::Frame & f) {
+ *       if(f.id == PROTO_STATE) {
+ *          telemdec::RecordView r(f);
+ *          use(r.time(), r.v(0));
+ *       }
+ *    });
+ *
+ * StateDecoder turns STATE and STATE_DELTA frames back into records; it
+ * must see every good frame to notice gaps in the sequence. channels()
+ * reads a CHANNELS frame with the sizes in protoChans, so it needs
+ * Src/proto.c linked in.
+ *
+ * ClockSync turns the board's microsecond time stamps into host time,
+ * from the CMD_PING round trips the host makes now and then:
+ *
+ *    sync.pong(sentAt, pong, receivedAt);
+ *    if(sync.synced()) {
+ *       int64_t at = sync.toHost(r.time());
+ *    }
+ */
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "proto.h"
+
+namespace telemdec {
+
+static_assert(sizeof(protoRecord_t) == PROTO_RECORD_LEN, "protoRecord_t is padded");
+
+/** @brief Counters of a Decoder **/
+struct Stats {
+   uint64_t bytes = 0;      /**< bytes fed */
+   uint64_t frames = 0;     /**< good frames */
+   uint64_t bad = 0;        /**< frames failing COBS or CRC, or too short */
+   uint64_t oversize = 0;   /**< frames longer than any message, discarded */
+   uint64_t lost = 0;       /**< frames missing from the sequence, bad ones included */
+};
+
+/** @brief A good frame. body points into the buffer given to
+ *  Decoder::feed() or into the decoder, valid during the callback.
+ */
+struct Frame {
+   uint8_t id;              /**< protoId_t */
+   uint16_t seq;            /**< frame counter */
+   const uint8_t * body;
+   size_t size;             /**< body bytes */
+};
+
+/** @brief Fields of a protoRecord_t body, read in place **/
+class RecordView {
+public:
+   explicit RecordView(const Frame & f) : p(f.body) {}
+   uint8_t law() const { return p[offsetof(protoRecord_t, law)]; }
+   int16_t torque() const { return get<int16_t>(offsetof(protoRecord_t, torque)); }
+   uint32_t time() const { return get<uint32_t>(offsetof(protoRecord_t, time)); }
+   int32_t v(int i) const { return get<int32_t>(offsetof(protoRecord_t, v) + 4 * i); }
+
+private:
+   /* unaligned load; the host is little endian like the wire */
+   template<class T> T get(size_t at) const {
+      T x;
+      std::memcpy(&x, p + at, sizeof(x));
+      return x;
+   }
+   const uint8_t * p;
+};
+
+/** @brief CRC-16/CCITT-FALSE, table driven; same result as protoCrc16() **/
+class Crc16 {
+public:
+   constexpr Crc16() : table() {
+      for(int i = 0; i < 256; i++) {
+         uint16_t c = i << 8;
+         for(int b = 0; b < 8; b++) {
+            c = c & 0x8000 ? (c << 1) ^ 0x1021 : c << 1;
+         }
+         table[i] = c;
+      }
+   }
+   uint16_t operator()(const uint8_t * data, size_t len) const {
+      uint16_t crc = 0xFFFF;
+      while(len--) {
+         crc = (crc << 8) ^ table[(crc >> 8) ^ *data++];
+      }
+      return crc;
+   }
+
+private:
+   uint16_t table[256];
+};
+
+//-------------------------------------------------------------------------------------
+/** @brief   Read the values of a CHANNELS frame
+ *  @param   f Frame
+ *  @param   onValue Called as onValue(uint32_t time, int channel, int64_t value)
+ *           per channel, in channel order
+ *  @return  false if f is no CHANNELS frame or its size does not match its mask
+ */
+template<class F> bool channels(const Frame & f, F && onValue) {
+   protoChannels_t h;
+   size_t at = sizeof(h);
+
+   if(f.id != PROTO_CHANNELS || f.size < sizeof(h)) {
+      return false;
+   }
+   std::memcpy(&h, f.body, sizeof(h));
+   if(h.mask >> PROTO_CHAN_COUNT) {
+      return false;
+   }
+   for(int c = 0; c < PROTO_CHAN_COUNT; c++) {
+      if(!(h.mask & (1 << c))) {
+         continue;
+      }
+      size_t size = protoChans[c].size;
+      uint32_t v = 0;
+      if(at + size > f.size) {
+         return false;
+      }
+      std::memcpy(&v, f.body + at, size);
+      at += size;
+      int64_t x = v;
+      if(protoChans[c].isSigned) {
+         x = static_cast<int32_t>(v << (32 - 8 * size)) >> (32 - 8 * size);
+      }
+      onValue(h.time, c, x);
+   }
+   return at == f.size;
+}
+
+/** @brief Counters of a StateDecoder **/
+struct StateStats {
+   uint64_t records = 0;    /**< records handed out */
+   uint64_t keys = 0;       /**< keyframes among them */
+   uint64_t skipped = 0;    /**< STATE_DELTA frames dropped waiting for a keyframe */
+   uint64_t bad = 0;        /**< STATE_DELTA frames that did not parse */
+};
+
+/** @brief Expands state frames, full and delta coded, into protoRecord_t **/
+class StateDecoder {
+public:
+   //-------------------------------------------------------------------------------------
+   /** @brief   Take the next good frame
+    *  @details Other messages only advance the sequence. After a gap,
+    *           STATE_DELTA frames are dropped until the next STATE.
+    *  @param   f Frame from Decoder::feed()
+    *  @param   onRecord Called as onRecord(const protoRecord_t &) per record
+    */
+   template<class F> void frame(const Frame & f, F && onRecord) {
+      if(seen && f.seq != static_cast<uint16_t>(lastSeq + 1)) {
+         keyed = false;
+      }
+      seen = true;
+      lastSeq = f.seq;
+
+      if(f.id == PROTO_STATE && f.size == PROTO_RECORD_LEN) {
+         std::memcpy(&d.last, f.body, PROTO_RECORD_LEN);
+         d.step = 0;
+         keyed = true;
+         st.keys++;
+         st.records++;
+         onRecord(d.last);
+      } else if(f.id == PROTO_STATE_DELTA) {
+         if(!keyed) {
+            st.skipped++;
+            return;
+         }
+         const uint8_t * p = f.body;
+         const uint8_t * end = f.body + f.size;
+         while(p < end) {
+            p = expand(p, end);
+            if(!p) {
+               keyed = false;
+               st.bad++;
+               return;
+            }
+            st.records++;
+            onRecord(d.last);
+         }
+      }
+   }
+
+   /** @brief Counters since construction **/
+   const StateStats & stats() const { return st; }
+
+private:
+   /* next zigzag varint, NULL if cut off or longer than 32 bits */
+   static const uint8_t * varint(const uint8_t * p, const uint8_t * end, int32_t & x) {
+      uint32_t v = 0;
+      for(int shift = 0; shift < 35; shift += 7) {
+         if(p == end) {
+            return nullptr;
+         }
+         v |= static_cast<uint32_t>(*p & 0x7F) << shift;
+         if(!(*p++ & 0x80)) {
+            x = static_cast<int32_t>((v >> 1) ^ (0u - (v & 1)));
+            return p;
+         }
+      }
+      return nullptr;
+   }
+
+   /* one record, the inverse of protoDeltaEncode() */
+   const uint8_t * expand(const uint8_t * p, const uint8_t * end) {
+      int32_t diff[PROTO_DELTA_FIELDS] = {};
+      uint8_t mask = *p++;
+
+      if(mask >> PROTO_DELTA_FIELDS) {
+         return nullptr;
+      }
+      for(int i = 0; i < PROTO_DELTA_FIELDS; i++) {
+         if(mask & (1 << i) && !(p = varint(p, end, diff[i]))) {
+            return nullptr;
+         }
+      }
+      uint32_t time = d.last.time + d.step + diff[2];
+      d.step = time - d.last.time;
+      d.last.time = time;
+      d.last.law += diff[0];
+      d.last.torque = static_cast<int16_t>(d.last.torque + diff[1]);
+      for(int i = 0; i < 4; i++) {
+         d.last.v[i] = static_cast<int32_t>(static_cast<uint32_t>(d.last.v[i]) + diff[3 + i]);
+      }
+      return p;
+   }
+
+   StateStats st;
+   protoDelta_t d = {};
+   bool keyed = false;
+   bool seen = false;
+   uint16_t lastSeq = 0;
+};
+
+/** @brief Extends the board's 32 bit microseconds to 64 bits **/
+class Unwrap {
+public:
+   //-------------------------------------------------------------------------------------
+   /** @brief   Next time
+    *  @param   t Board time, within 35 minutes either way of the last one
+    *  @return  t counted on from the first time given
+    */
+   int64_t operator()(uint32_t t) {
+      if(!seen) {
+         last = t;
+         seen = true;
+      } else {
+         last += static_cast<int32_t>(t - static_cast<uint32_t>(last));
+      }
+      return last;
+   }
+
+private:
+   int64_t last = 0;
+   bool seen = false;
+};
+
+/** @brief Board time to host time, from CMD_PING round trips
+ *
+ *  Each pong gives a pair of times taken at the same moment, the middle
+ *  of the board's receive and send times against the middle of the
+ *  host's send and receive times, off by half the difference of the
+ *  two ways' delays. Queueing only ever adds delay, so of the last
+ *  window pongs only those within slackUs of the fastest round trip are
+ *  used, and a least squares line through them gives the offset and the
+ *  drift of the board's crystal; while they lie too close together for
+ *  the drift, the last one is kept. The times are whatever clock the caller
+ *  measures t1 and t4 with, in microseconds.
+ */
+class ClockSync {
+public:
+   /** @brief Pongs kept **/
+   static constexpr int window = 128;
+   /** @brief Extra round trip beyond the fastest a pong may take and still be used, us **/
+   static constexpr int64_t slackUs = 20;
+   /** @brief Shortest span of used pongs to fit the drift over, us; below, the last drift stays **/
+   static constexpr int64_t driftSpanUs = 2000000;
+
+   //-------------------------------------------------------------------------------------
+   /** @brief   Take a round trip and update the estimate
+    *  @param   t1 Host time the CMD_PING frame was sent
+    *  @param   p Body of the CMD_PONG
+    *  @param   t4 Host time the CMD_PONG frame arrived
+    */
+   void pong(int64_t t1, const protoPong_t & p, int64_t t4) {
+      Sample & s = samples[count++ % window];
+      int64_t rx = board(p.rx);
+      int64_t tx = rx + static_cast<int32_t>(p.tx - p.rx);
+
+      s.board = rx + (tx - rx) / 2;
+      s.host = t1 + (t4 - t1) / 2;
+      s.delay = (t4 - t1) - (tx - rx);
+      fit();
+   }
+
+   //-------------------------------------------------------------------------------------
+   /** @brief   Host time of a board time stamp
+    *  @param   t Board time, within 35 minutes of the last pong
+    *  @return  Host time, only meaningful once synced()
+    */
+   int64_t toHost(uint32_t t) const {
+      int64_t b = lastBoard + static_cast<int32_t>(t - static_cast<uint32_t>(lastBoard));
+      return refHost + static_cast<int64_t>(std::llround(offset + (1 + drift) * (b - refBoard)));
+   }
+
+   /** @brief true once there was a pong **/
+   bool synced() const { return count > 0; }
+
+   /** @brief How much faster the board's clock runs than the host's, parts per million **/
+   double driftPpm() const { return (1 / (1 + drift) - 1) * 1e6; }
+
+   /** @brief Fastest round trip of the window, less the board's turnaround, us **/
+   int64_t minDelay() const { return best; }
+
+   /** @brief Pongs the fit used **/
+   int used() const { return fitted; }
+
+private:
+   struct Sample {
+      int64_t board;    /* middle of rx and tx, unwrapped */
+      int64_t host;     /* middle of t1 and t4 */
+      int64_t delay;    /* round trip less the turnaround */
+   };
+
+   /* unwrap against the last pong */
+   int64_t board(uint32_t t) {
+      if(count == 1) {
+         lastBoard = t;
+      } else {
+         lastBoard += static_cast<int32_t>(t - static_cast<uint32_t>(lastBoard));
+      }
+      return lastBoard;
+   }
+
+   /* host = refHost + offset + (1 + drift) (board - refBoard) through the fastest pongs */
+   void fit() {
+      int n = count < window ? count : window;
+      double sb = 0, sh = 0, sbb = 0, sbh = 0;
+      int64_t lo = INT64_MAX, hi = INT64_MIN;
+
+      best = INT64_MAX;
+      for(int i = 0; i < n; i++) {
+         best = samples[i].delay < best ? samples[i].delay : best;
+      }
+      const Sample & last = samples[(count - 1) % window];
+      refBoard = last.board;
+      refHost = last.host;
+      fitted = 0;
+      for(int i = 0; i < n; i++) {
+         if(samples[i].delay > best + slackUs) {
+            continue;
+         }
+         double b = samples[i].board - refBoard;
+         double h = samples[i].host - refHost - b;
+         sb += b;
+         sh += h;
+         sbb += b * b;
+         sbh += b * h;
+         lo = samples[i].board < lo ? samples[i].board : lo;
+         hi = samples[i].board > hi ? samples[i].board : hi;
+         fitted++;
+      }
+      /* fit host - board against board, the slope is the drift */
+      double var = sbb - sb * sb / fitted;
+      if(hi - lo >= driftSpanUs && var > 0) {
+         drift = (sbh - sb * sh / fitted) / var;
+      }
+      offset = (sh - drift * sb) / fitted;
+   }
+
+   Sample samples[window];
+   int count = 0;
+   int fitted = 0;
+   int64_t lastBoard = 0;
+   int64_t refBoard = 0;
+   int64_t refHost = 0;
+   int64_t best = 0;
+   double offset = 0;
+   double drift = 0;
+};
+
+/** @brief Splits a byte stream into checked frames **/
+class Decoder {
+public:
+   /** @brief Largest frame without its 0, anything longer is not ours **/
+   static constexpr size_t maxFrame = PROTO_FRAME_MAX(PROTO_BODY_MAX) - 1;
+
+   //-------------------------------------------------------------------------------------
+   /** @brief   Decode the next chunk of the stream
+    *  @details Frames wholly inside data are decoded in place, so data is
+    *           modified. A frame cut off at the end is kept until the
+    *           next call completes it.
+    *  @param   data Bytes received
+    *  @param   len Number of bytes
+    *  @param   onFrame Called as onFrame(const Frame &) per good frame
+    */
+   template<class F> void feed(uint8_t * data, size_t len, F && onFrame) {
+      uint8_t * p = data;
+      uint8_t * end = data + len;
+
+      st.bytes += len;
+      while(p < end) {
+         uint8_t * z = static_cast<uint8_t *>(std::memchr(p, 0, end - p));
+         if(!z) {
+            keep(p, end - p);
+            return;
+         }
+         if(carryLen) {
+            keep(p, z - p);
+            frame(carry, carryLen, onFrame);
+            carryLen = 0;
+         } else {
+            frame(p, z - p, onFrame);
+         }
+         p = z + 1;
+      }
+   }
+
+   /** @brief Counters since construction or reset() **/
+   const Stats & stats() const { return st; }
+
+   /** @brief Forget any partial frame, the sequence and the counters **/
+   void reset() {
+      st = Stats();
+      carryLen = 0;
+      synced = false;
+   }
+
+private:
+   /* partial frame, up to one byte more than maxFrame to flag oversize */
+   void keep(const uint8_t * p, size_t n) {
+      size_t room = maxFrame + 1 - carryLen;
+      std::memcpy(carry + carryLen, p, n < room ? n : room);
+      carryLen += n < room ? n : room;
+   }
+
+   /* COBS decode in place, 0 if malformed */
+   static size_t unstuff(uint8_t * buf, size_t len) {
+      size_t i = 0;
+      size_t o = 0;
+
+      while(i < len) {
+         size_t code = buf[i++];
+         if(i + code - 1 > len) {
+            return 0;
+         }
+         std::memmove(buf + o, buf + i, code - 1);
+         i += code - 1;
+         o += code - 1;
+         if(code != 0xFF && i < len) {
+            buf[o++] = 0;
+         }
+      }
+      return o;
+   }
+
+   template<class F> void frame(uint8_t * buf, size_t len, F && onFrame) {
+      size_t n;
+      Frame f;
+
+      if(!len) {
+         return;
+      }
+      if(len > maxFrame) {
+         st.oversize++;
+         return;
+      }
+      n = unstuff(buf, len);
+      if(n < PROTO_OVERHEAD || crc(buf, n - 2) != (buf[n - 2] | buf[n - 1] << 8)) {
+         st.bad++;
+         return;
+      }
+      f.id = buf[0];
+      f.seq = buf[1] | buf[2] << 8;
+      f.body = buf + 3;
+      f.size = n - PROTO_OVERHEAD;
+      if(synced) {
+         st.lost += static_cast<uint16_t>(f.seq - nextSeq);
+      }
+      synced = true;
+      nextSeq = f.seq + 1;
+      st.frames++;
+      onFrame(f);
+   }
+
+   static constexpr Crc16 crc{};
+   Stats st;
+   uint8_t carry[maxFrame + 1];
+   size_t carryLen = 0;
+   bool synced = false;
+   uint16_t nextSeq = 0;
+};
+
+}
+
+#endif
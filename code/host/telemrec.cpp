@@ -0,0 +1,525 @@
+/*
+ * Telemetry recorder, writes the file format of host/recfile.hpp.
+ *
+ * Usage: telemrec [-p params] -o out.rec [capture]
+ *    Decodes a capture of the USART1 stream (a file, a serial device
+ *    already set to the board's rate, or stdin) and records it: state,
+ *    health, task and timing records, INFO and command replies, every
+ *    subscribed channel and the samples of burst capture dumps, each in a
+ *    table of its own. Times are the board's microsecond time stamps,
+ *    unwrapped. The firmware build from INFO goes into the header, and so
+ *    does params, e.g. "kp=1200 mass=0.12 run 7".
+ *
+ * Usage: telemrec -i file.rec
+ *    Prints the header and the tables, then reads every column and
+ *    reports the scan rate.
+ *
+ * Usage: telemrec -s table time [rows] file.rec
+ *    Prints rows of a table from the first one at or after time, us.
+ *
+ * Usage: telemrec -b [MB]
+ *    Self check. Records a made-up stream of state records, two channels
+ *    and INFO messages, with the board clock wrapping a second in, reads
+ *    it back, seeks to every thousandth tick, then does the same with the
+ *    index cut off. Exits non-zero unless
+ *    every value and every seek comes out right.
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "telemdec.hpp"
+#include "recfile.hpp"
+
+/* names of the capture columns, protoCapChannel_t order */
+static const char * const capNames[PROTO_CH_COUNT] = {
+   "cap.arm", "cap.armRate", "cap.pend", "cap.pendRate", "cap.torque", "cap.armRef"
+};
+
+/** @brief Decoded frames into a recording **/
+class Recorder {
+public:
+   //-------------------------------------------------------------------------------------
+   /** @brief   Start the recording and add the tables
+    *  @param   path File
+    *  @param   params Text for the header
+    *  @return  false if it cannot be written
+    */
+   bool open(const char * path, const char * params) {
+      if(!w.open(path, params)) {
+         return false;
+      }
+      records[PROTO_STATE] = w.table("state", { "law", "torque", "arm", "pend", "pendRate", "overruns" });
+      records[PROTO_HEALTH] = w.table("health", { "law", "torque", "load", "idle", "isr", "drops" });
+      records[PROTO_TASK] = w.table("task", { "task", "share", "stack", "cycles", "idle", "unused" });
+      records[PROTO_TIMING] = w.table("timing", { "law", "torque", "latMax", "latMean", "busyMax", "overruns" });
+      info = w.table("info", { "baud", "decim", "logging" });
+      reply = w.table("reply", { "seq", "cmd", "status", "value" });
+      for(int c = 0; c < PROTO_CHAN_COUNT; c++) {
+         chans[c] = w.table((std::string("chan.") + protoChans[c].name).c_str(), { "value" });
+      }
+      for(int c = 0; c < PROTO_CH_COUNT; c++) {
+         caps[c] = w.table(capNames[c], { "value" });
+      }
+      return caps[PROTO_CH_COUNT - 1] >= 0;
+   }
+
+   //-------------------------------------------------------------------------------------
+   /** @brief   Record a frame
+    *  @details INFO and replies carry no time of their own and get that of
+    *           the last state record.
+    *  @param   f Good frame from Decoder::feed()
+    *  @return  false on a write error
+    */
+   bool frame(const telemdec::Frame & f) {
+      bool ok = true;
+
+      states.frame(f, [&](const protoRecord_t & r) {
+         ok = ok && record(PROTO_STATE, r);
+      });
+      if(f.id >= PROTO_HEALTH && f.id <= PROTO_TIMING && f.size == PROTO_RECORD_LEN) {
+         protoRecord_t r;
+         std::memcpy(&r, f.body, sizeof(r));
+         ok = record(f.id, r);
+      } else if(f.id == PROTO_CHANNELS) {
+         telemdec::channels(f, [&](uint32_t time, int c, int64_t v) {
+            int32_t x = static_cast<int32_t>(v);
+            ok = ok && w.add(chans[c], clock(time), &x);
+         });
+      } else if(f.id == PROTO_INFO && f.size == sizeof(protoInfo_t)) {
+         protoInfo_t i;
+         std::memcpy(&i, f.body, sizeof(i));
+         int32_t row[3] = { static_cast<int32_t>(i.baud), i.decim, i.logging };
+         ok = w.info(i.build, sizeof(i.build), i.ctrlHz) && w.add(info, last, row);
+      } else if(f.id == PROTO_CMD_REPLY && f.size == sizeof(protoReply_t)) {
+         protoReply_t r;
+         std::memcpy(&r, f.body, sizeof(r));
+         int32_t row[4] = { r.seq, r.cmd, r.status, r.value };
+         ok = w.add(reply, last, row);
+      } else if(f.id == PROTO_CAPTURE_INFO && f.size == sizeof(protoCaptureInfo_t)) {
+         std::memcpy(&capture, f.body, sizeof(capture));
+      } else if(f.id == PROTO_CAPTURE_DATA && f.size >= sizeof(protoCaptureData_t)) {
+         protoCaptureData_t h;
+         std::memcpy(&h, f.body, sizeof(h));
+         int64_t start = clock(capture.time);
+         for(size_t i = 0; h.channel < PROTO_CH_COUNT && sizeof(h) + 2 * i + 2 <= f.size; i++) {
+            int16_t v;
+            std::memcpy(&v, f.body + sizeof(h) + 2 * i, 2);
+            int32_t x = v;
+            int64_t at = start + (h.index + i) * 1000000LL / (capture.rate ? capture.rate : 1);
+            ok = ok && w.add(caps[h.channel], at, &x);
+         }
+      }
+      return ok;
+   }
+
+   /** @brief Finish the file, false on a write error **/
+   bool close() { return w.close(); }
+
+   /** @brief Bytes written so far **/
+   uint64_t bytes() const { return w.bytes(); }
+
+   /** @brief State decoder counters **/
+   const telemdec::StateStats & stateStats() const { return states.stats(); }
+
+private:
+   bool record(uint8_t id, const protoRecord_t & r) {
+      int32_t row[6] = { r.law, r.torque, r.v[0], r.v[1], r.v[2], r.v[3] };
+      int64_t t = clock(r.time);
+      if(id == PROTO_STATE) {
+         last = t;
+      }
+      return w.add(records[id], t, row);
+   }
+
+   rec::Writer w;
+   telemdec::StateDecoder states;
+   telemdec::Unwrap clock;
+   protoCaptureInfo_t capture = {};
+   int64_t last = 0;
+   int records[PROTO_TIMING + 1];
+   int info;
+   int reply;
+   int chans[PROTO_CHAN_COUNT];
+   int caps[PROTO_CH_COUNT];
+};
+
+
+//-------------------------------------------------------------------------------------
+/** @brief   Record a capture
+ *  @param   path File or device, NULL for stdin
+ *  @param   out Recording
+ *  @param   params Text for the header
+ *  @return  Exit status
+ */
+static int record(const char * path, const char * out, const char * params) {
+   static uint8_t buf[1 << 16];
+   telemdec::Decoder dec;
+   Recorder r;
+   FILE * in = path ? std::fopen(path, "rb") : stdin;
+   size_t n;
+
+   if(!in) {
+      std::perror(path);
+      return 1;
+   }
+   if(!r.open(out, params)) {
+      std::perror(out);
+      return 1;
+   }
+   bool ok = true;
+   while(ok && (n = std::fread(buf, 1, sizeof(buf), in)) > 0) {
+      dec.feed(buf, n, [&](const telemdec::Frame & f) {
+         ok = ok && r.frame(f);
+      });
+   }
+   if(!r.close() || !ok) {
+      std::perror(out);
+      return 1;
+   }
+   const telemdec::Stats & st = dec.stats();
+   std::fprintf(stderr, "%llu bytes  %llu frames  %llu bad  %llu lost  %llu state records  -> %llu bytes\n",
+                (unsigned long long)st.bytes, (unsigned long long)st.frames,
+                (unsigned long long)st.bad, (unsigned long long)st.lost,
+                (unsigned long long)r.stateStats().records, (unsigned long long)r.bytes());
+   return 0;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Read every value of a recording
+ *  @param   r Open recording
+ *  @param   bytes Filled with the column bytes read
+ *  @return  Sum of all values, so the reads cannot be left out
+ */
+static int64_t scan(const rec::Reader & r, uint64_t & bytes) {
+   int64_t sum = 0;
+
+   bytes = 0;
+   for(uint32_t t = 0; t < r.header().tables; t++) {
+      for(const rec::Chunk & c : r.chunks(t)) {
+         for(uint32_t i = 0; i < c.rows; i++) {
+            sum += c.time[i];
+         }
+         for(uint32_t k = 0; k < r.header().table[t].cols; k++) {
+            const int32_t * v = c.col(k);
+            for(uint32_t i = 0; i < c.rows; i++) {
+               sum += v[i];
+            }
+         }
+         bytes += 4ull * c.rows * (r.header().table[t].cols + 1);
+      }
+   }
+   return sum;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Print what a recording holds and how fast it reads
+ *  @param   path Recording
+ *  @return  Exit status
+ */
+static int info(const char * path) {
+   rec::Reader r;
+   uint64_t bytes;
+
+   if(!r.open(path)) {
+      std::fprintf(stderr, "%s: no recording\n", path);
+      return 1;
+   }
+   const rec::Header & h = r.header();
+   time_t created = h.created;
+   std::printf("%s: %zu bytes%s\ncreated %sbuild %.32s, %u Hz\nparams %s\n", path, r.bytes(),
+               r.wasRecovered() ? ", no index, recovered" : "", std::ctime(&created),
+               h.build[0] ? h.build : "unknown", h.ctrlHz, h.params);
+   for(uint32_t t = 0; t < h.tables; t++) {
+      const std::vector<rec::Chunk> & cs = r.chunks(t);
+      uint64_t rows = 0;
+      for(const rec::Chunk & c : cs) {
+         rows += c.rows;
+      }
+      if(!rows) {
+         continue;
+      }
+      std::printf("%-14s %10llu rows %5zu chunks  time %lld..%lld ", h.table[t].name,
+                  (unsigned long long)rows, cs.size(), (long long)cs.front().tmin,
+                  (long long)cs.back().tmax);
+      for(uint32_t c = 0; c < h.table[t].cols; c++) {
+         std::printf(" %s", h.table[t].colName[c]);
+      }
+      std::printf("\n");
+   }
+
+   auto t0 = std::chrono::steady_clock::now();
+   int64_t sum = scan(r, bytes);
+   double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+   std::printf("scan %.1f MB in %.3f s, %.1f MB/s (sum %lld)\n", bytes / 1e6, s,
+               bytes / s / 1e6, (long long)sum);
+   return 0;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Print rows of a table from a time on
+ *  @param   path Recording
+ *  @param   table Table name
+ *  @param   time Time, us
+ *  @param   rows Rows to print
+ *  @return  Exit status
+ */
+static int seekRows(const char * path, const char * table, int64_t time, uint32_t rows) {
+   rec::Reader r;
+   size_t chunk;
+   uint32_t row;
+
+   if(!r.open(path)) {
+      std::fprintf(stderr, "%s: no recording\n", path);
+      return 1;
+   }
+   int t = r.find(table);
+   if(t < 0) {
+      std::fprintf(stderr, "%s: no table %s\n", path, table);
+      return 1;
+   }
+   const rec::TableInfo & ti = r.header().table[t];
+   std::printf("time");
+   for(uint32_t c = 0; c < ti.cols; c++) {
+      std::printf(" %s", ti.colName[c]);
+   }
+   std::printf("\n");
+   if(!r.seek(t, time, chunk, row)) {
+      return 0;
+   }
+   const std::vector<rec::Chunk> & cs = r.chunks(t);
+   for(; rows && chunk < cs.size(); chunk++, row = 0) {
+      for(; rows && row < cs[chunk].rows; row++, rows--) {
+         std::printf("%lld", (long long)cs[chunk].time[row]);
+         for(uint32_t c = 0; c < ti.cols; c++) {
+            std::printf(" %ld", (long)cs[chunk].col(c)[row]);
+         }
+         std::printf("\n");
+      }
+   }
+   return 0;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Time of tick k in the self check, the board clock wraps a second in
+ *  @param   k Tick
+ *  @return  Unwrapped time, us
+ */
+static int64_t testTime(uint32_t k) {
+   return 0xFFF00000LL + 1000LL * k;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   State record of the self check at tick k
+ *  @param   k Tick
+ *  @param   r Filled with the record
+ */
+static void testRecord(uint32_t k, protoRecord_t * r) {
+   r->law = k / 5000 % 3;
+   r->torque = (int16_t)(k * 7);
+   r->time = (uint32_t)testTime(k);
+   for(int i = 0; i < 4; i++) {
+      r->v[i] = (int32_t)(k * 2654435761u) >> (i * 8);
+   }
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Check a recording of the self check stream
+ *  @param   r Open recording
+ *  @param   ticks Control ticks in the stream
+ *  @return  Number of wrong values and seeks
+ */
+static uint64_t check(const rec::Reader & r, uint32_t ticks) {
+   int state = r.find("state");
+   int arm = r.find("chan.arm");
+   uint64_t wrong = 0;
+   uint64_t rows = 0;
+
+   if(state < 0 || arm < 0 || std::strcmp(r.header().build, "selftest-1") ||
+      r.header().ctrlHz != 1000) {
+      return 1;
+   }
+   for(const rec::Chunk & c : r.chunks(state)) {
+      for(uint32_t i = 0; i < c.rows; i++, rows++) {
+         protoRecord_t x;
+         testRecord(rows * 2, &x);
+         wrong += c.time[i] != testTime(rows * 2) || c.col(0)[i] != x.law || c.col(1)[i] != x.torque ||
+                  c.col(2)[i] != x.v[0] || c.col(5)[i] != x.v[3];
+      }
+   }
+   wrong += rows != (ticks + 1) / 2;
+   rows = 0;
+   for(const rec::Chunk & c : r.chunks(arm)) {
+      for(uint32_t i = 0; i < c.rows; i++, rows++) {
+         wrong += c.time[i] != testTime(rows) || c.col(0)[i] != -3 * (int32_t)rows;
+      }
+   }
+   wrong += rows != ticks;
+   for(uint32_t t = 0; t < ticks; t += 997) {
+      size_t chunk;
+      uint32_t row;
+      wrong += !r.seek(arm, testTime(t), chunk, row) ||
+               r.chunks(arm)[chunk].time[row] != testTime(t);
+      if((t + 1) / 2 * 2 < ticks) {
+         wrong += !r.seek(state, testTime(t) - 1, chunk, row) ||
+                  r.chunks(state)[chunk].time[row] != testTime((t + 1) / 2 * 2);
+      }
+   }
+   return wrong;
+}
+
+//-------------------------------------------------------------------------------------
+/** @brief   Record a made-up stream, read it back and check it
+ *  @param   mb Stream size, MB
+ *  @return  Exit status
+ */
+static int bench(double mb) {
+   const char * dir = std::getenv("TMPDIR") ? std::getenv("TMPDIR") : "/tmp";
+   std::string path = std::string(dir) + "/telemrec-" + std::to_string(getpid()) + ".rec";
+   std::string cut = path + ".cut";
+   std::vector<uint8_t> stream;
+   uint8_t frame[PROTO_FRAME_MAX(PROTO_BODY_MAX)];
+   uint16_t seq = 0;
+   uint32_t ticks = 0;
+
+   /* a state record every other tick, pend and arm every tick, INFO every 5000 */
+   while(stream.size() < mb * 1e6) {
+      uint8_t body[sizeof(protoChannels_t) + 6];
+      protoChannels_t h = { (uint32_t)testTime(ticks), (1 << PROTO_CHAN_PEND) | (1 << PROTO_CHAN_ARM) };
+      uint16_t pend = ticks & 0xFFFF;
+      int32_t armValue = -3 * (int32_t)ticks;
+      uint16_t len;
+
+      if(ticks % 2 == 0) {
+         protoRecord_t r;
+         testRecord(ticks, &r);
+         len = protoFrame(PROTO_STATE, seq++, &r, PROTO_RECORD_LEN, frame);
+         stream.insert(stream.end(), frame, frame + len);
+      }
+      std::memcpy(body, &h, sizeof(h));
+      std::memcpy(body + sizeof(h), &pend, 2);
+      std::memcpy(body + sizeof(h) + 2, &armValue, 4);
+      len = protoFrame(PROTO_CHANNELS, seq++, body, sizeof(body), frame);
+      stream.insert(stream.end(), frame, frame + len);
+      if(ticks % 5000 == 0) {
+         protoInfo_t i = { 2000000, 1000, 2, 1, "selftest-1" };
+         len = protoFrame(PROTO_INFO, seq++, &i, sizeof(i), frame);
+         stream.insert(stream.end(), frame, frame + len);
+      }
+      ticks++;
+   }
+
+   telemdec::Decoder dec;
+   Recorder rec;
+   bool ok = rec.open(path.c_str(), "selftest");
+   auto t0 = std::chrono::steady_clock::now();
+   for(size_t at = 0; ok && at < stream.size(); at += 4096) {
+      size_t n = stream.size() - at < 4096 ? stream.size() - at : 4096;
+      dec.feed(stream.data() + at, n, [&](const telemdec::Frame & f) {
+         ok = ok && rec.frame(f);
+      });
+   }
+   ok = rec.close() && ok;
+   double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+   if(!ok) {
+      std::perror(path.c_str());
+      return 1;
+   }
+   std::printf("record %8.1f MB/s of stream, %.1f MB stream -> %.1f MB file\n",
+               stream.size() / s / 1e6, stream.size() / 1e6, rec.bytes() / 1e6);
+
+   rec::Reader r;
+   uint64_t wrong = 0;
+   uint64_t bytes;
+   size_t chunks = 0;
+   if(!r.open(path.c_str()) || r.wasRecovered()) {
+      wrong++;
+   } else {
+      wrong += check(r, ticks);
+      for(uint32_t t = 0; t < r.header().tables; t++) {
+         chunks += r.chunks(t).size();
+      }
+      scan(r, bytes);
+      t0 = std::chrono::steady_clock::now();
+      scan(r, bytes);
+      s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+      std::printf("scan   %8.1f MB/s of columns, %zu chunks\n", bytes / s / 1e6, chunks);
+   }
+
+   /* the same file as left by a recorder that was killed: no index */
+   rec::Trailer tr;
+   FILE * in = std::fopen(path.c_str(), "rb");
+   FILE * out = std::fopen(cut.c_str(), "wb");
+   std::vector<uint8_t> data(r.bytes());
+   if(!in || !out || data.size() < sizeof(tr) || std::fread(data.data(), 1, data.size(), in) != data.size()) {
+      wrong++;
+   } else {
+      std::memcpy(&tr, data.data() + data.size() - sizeof(tr), sizeof(tr));
+      std::fwrite(data.data(), 1, tr.index, out);
+   }
+   if(in) {
+      std::fclose(in);
+   }
+   if(out) {
+      std::fclose(out);
+   }
+   rec::Reader cr;
+   size_t cutChunks = 0;
+   if(!cr.open(cut.c_str()) || !cr.wasRecovered()) {
+      wrong++;
+   } else {
+      wrong += check(cr, ticks);
+      for(uint32_t t = 0; t < cr.header().tables; t++) {
+         cutChunks += cr.chunks(t).size();
+      }
+      wrong += cutChunks != chunks;
+   }
+   r.close();
+   cr.close();
+   std::remove(path.c_str());
+   std::remove(cut.c_str());
+
+   if(wrong) {
+      std::printf("FAIL: %llu wrong values or seeks\n", (unsigned long long)wrong);
+      return 1;
+   }
+   std::printf("PASS\n");
+   return 0;
+}
+
+//-------------------------------------------------------------------------------------
+int main(int argc, char ** argv) {
+   const char * params = "";
+   const char * out = nullptr;
+   int i = 1;
+
+   if(argc > 1 && !std::strcmp(argv[1], "-b")) {
+      return bench(argc > 2 ? std::atof(argv[2]) : 20);
+   }
+   if(argc == 3 && !std::strcmp(argv[1], "-i")) {
+      return info(argv[2]);
+   }
+   if((argc == 5 || argc == 6) && !std::strcmp(argv[1], "-s")) {
+      return seekRows(argv[argc - 1], argv[2], std::strtoll(argv[3], nullptr, 0),
+                      argc == 6 ? std::strtoul(argv[4], nullptr, 0) : 10);
+   }
+   for(; i + 1 < argc && argv[i][0] == '-'; i += 2) {
+      if(!std::strcmp(argv[i], "-p")) {
+         params = argv[i + 1];
+      } else if(!std::strcmp(argv[i], "-o")) {
+         out = argv[i + 1];
+      } else {
+         break;
+      }
+   }
+   if(!out || argc - i > 1) {
+      std::fprintf(stderr, "usage: telemrec [-p params] -o out.rec [capture]\n"
+                           "       telemrec -i file.rec\n"
+                           "       telemrec -s table time [rows] file.rec\n"
+                           "       telemrec -b [MB]\n");
+      return 2;
+   }
+   return record(i < argc ? argv[i] : nullptr, out, params);
+}
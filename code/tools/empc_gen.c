@@ -0,0 +1,625 @@
+/*
+ * Host tool: builds the explicit MPC region table for the Furuta pendulum.
+ *
+ * The finite horizon MPC problem (linearized upright model, torque and arm
+ * angle constraints) is solved offline at the corners and center of boxes
+ * in state space. Each box gets the least squares affine fit of those
+ * solutions; boxes whose fit is off by more than FIT_TOL are split in half
+ * along their widest (normalized) dimension. The result is a kd-tree that
+ * empc.c walks on the target.
+ *
+ * Rebuild the table with "make empc" after changing the model or weights.
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define NX 4
+#define N  10                 /* horizon steps */
+#define NC (2 * N)            /* u box rows + arm angle rows */
+
+/* plant (nominal rig, SI units) */
+#define MR   0.095            /* arm mass */
+#define LR   0.085            /* arm length */
+#define MP   0.024            /* pendulum mass */
+#define LP   0.129            /* pendulum length */
+#define DR   0.0015           /* arm damping */
+#define DP   0.0005           /* pendulum damping */
+#define GRAV 9.81
+#define TAU_MAX 0.06          /* torque at a command of 1000 */
+
+/* problem */
+#define DT   0.01             /* MPC step */
+#define ARM_MAX 1.5           /* arm angle constraint, rad */
+static const double Qw[NX] = { 5.0, 50.0, 0.1, 0.5 };
+#define RW   100.0
+
+/* domain the table covers, rad and rad/s; the arm range stops short of
+   ARM_MAX so the constrained problem stays feasible everywhere in it */
+static const double lower[NX] = { -1.35, -0.15, -2.0, -2.0 };
+static const double upper[NX] = {  1.35,  0.15,  2.0,  2.0 };
+
+/* tree */
+#define MAX_DEPTH  16         /* must match EMPC_MAX_DEPTH */
+#define MAX_LEAVES 256        /* about 8 KB of flash */
+#define FIT_TOL    (0.05 * TAU_MAX) /* target, see empc.h for what is met */
+#define GAIN_SHIFT 16
+
+#define COUNTS_PER_RAD (65536.0 / (2.0 * M_PI))
+
+static double A[NX][NX], B[NX];
+static double Phi[N][NX][NX], Gam[N][NX][N];
+static double H[N][N], Fx[N][NX];
+static double Lchol[N][N];        /* cholesky of H + rho C'C */
+static double C[NC][N];
+#define RHO 1.0
+
+typedef struct {
+   int leaf;                  /* 1 for a region, 0 for a split */
+   int dim;
+   double split;
+   int left, right;
+   int depth;
+   double lo[NX], hi[NX];
+   double gain[NX], offset, err;
+} node_t;
+
+static node_t *tree;
+static int nodeCount, leafCount, maxDepthSeen;
+
+
+static void buildModel(void) {
+   double jr = MR * LR * LR / 3.0;
+   double jp = MP * LP * LP / 3.0;
+   double h = LP / 2.0;
+   double jt = jr * jp - MP * MP * LR * LR * h * h;
+   double Ac[NX][NX] = {
+      { 0, 0, 1, 0 },
+      { 0, 0, 0, 1 },
+      { 0, MP * MP * h * h * LR * GRAV / jt, -DR * jp / jt, -MP * h * LR * DP / jt },
+      { 0, MP * GRAV * h * jr / jt, -MP * h * LR * DR / jt, -jr * DP / jt }
+   };
+   double Bc[NX] = { 0, 0, jp / jt, MP * h * LR / jt };
+   double term[NX][NX], next[NX][NX], sum[NX][NX], bsum[NX][NX];
+   int i, j, k, n;
+
+   /* A = expm(Ac dt), B = int expm(Ac s) ds Bc, by truncated series */
+   memset(sum, 0, sizeof(sum));
+   memset(term, 0, sizeof(term));
+   for(i = 0; i < NX; i++) {
+      term[i][i] = 1.0;
+      sum[i][i] = 1.0;
+   }
+   memset(bsum, 0, sizeof(bsum));
+   for(i = 0; i < NX; i++) {
+      bsum[i][i] = DT;
+   }
+   for(n = 1; n < 30; n++) {
+      for(i = 0; i < NX; i++) {
+         for(j = 0; j < NX; j++) {
+            next[i][j] = 0;
+            for(k = 0; k < NX; k++) {
+               next[i][j] += term[i][k] * Ac[k][j];
+            }
+            next[i][j] *= DT / n;
+         }
+      }
+      memcpy(term, next, sizeof(term));
+      for(i = 0; i < NX; i++) {
+         for(j = 0; j < NX; j++) {
+            sum[i][j] += term[i][j];
+            bsum[i][j] += term[i][j] * DT / (n + 1);
+         }
+      }
+   }
+   memcpy(A, sum, sizeof(A));
+   for(i = 0; i < NX; i++) {
+      B[i] = 0;
+      for(k = 0; k < NX; k++) {
+         B[i] += bsum[i][k] * Bc[k];
+      }
+   }
+}
+
+/* terminal cost from the discrete riccati recursion */
+static void terminalCost(double P[NX][NX]) {
+   int it, i, j, k;
+   double delta;
+   memset(P, 0, sizeof(double) * NX * NX);
+   for(i = 0; i < NX; i++) {
+      P[i][i] = Qw[i];
+   }
+   for(it = 0; it < 100000; it++) {
+      double pb[NX], bpb = RW, ap[NX][NX], apb[NX], np[NX][NX];
+      for(i = 0; i < NX; i++) {
+         pb[i] = 0;
+         for(k = 0; k < NX; k++) {
+            pb[i] += P[i][k] * B[k];
+         }
+      }
+      for(i = 0; i < NX; i++) {
+         bpb += B[i] * pb[i];
+      }
+      for(i = 0; i < NX; i++) {
+         for(j = 0; j < NX; j++) {
+            ap[i][j] = 0;
+            for(k = 0; k < NX; k++) {
+               ap[i][j] += A[k][i] * P[k][j];
+            }
+         }
+         apb[i] = 0;
+         for(k = 0; k < NX; k++) {
+            apb[i] += A[k][i] * pb[k];
+         }
+      }
+      for(i = 0; i < NX; i++) {
+         for(j = 0; j < NX; j++) {
+            np[i][j] = (i == j ? Qw[i] : 0) - apb[i] * apb[j] / bpb;
+            for(k = 0; k < NX; k++) {
+               np[i][j] += ap[i][k] * A[k][j];
+            }
+         }
+      }
+      /* keep P symmetric or rounding slowly drives the recursion unstable */
+      delta = 0;
+      for(i = 0; i < NX; i++) {
+         for(j = 0; j < NX; j++) {
+            double v = 0.5 * (np[i][j] + np[j][i]);
+            delta = fmax(delta, fabs(v - P[i][j]) / (fabs(v) + 1e-9));
+            P[i][j] = v;
+         }
+      }
+      if(delta < 1e-12) {
+         break;
+      }
+   }
+}
+
+/* condensed QP: x_k = Phi_k x0 + Gam_k U, cost 1/2 U'HU + x0'Fx'U */
+static void buildQP(void) {
+   double P[NX][NX], Ak[NX][NX], tmp[NX][NX];
+   double W[N][NX][NX];
+   int i, j, k, m, s;
+
+   terminalCost(P);
+
+   memset(Ak, 0, sizeof(Ak));
+   for(i = 0; i < NX; i++) {
+      Ak[i][i] = 1.0;
+   }
+   memset(Gam, 0, sizeof(Gam));
+   for(k = 0; k < N; k++) {
+      for(i = 0; i < NX; i++) {
+         for(j = 0; j < NX; j++) {
+            tmp[i][j] = 0;
+            for(m = 0; m < NX; m++) {
+               tmp[i][j] += A[i][m] * Ak[m][j];
+            }
+         }
+      }
+      memcpy(Ak, tmp, sizeof(Ak));
+      memcpy(Phi[k], Ak, sizeof(Ak));
+      /* Gam_k column s = A^(k-s) B */
+      for(s = 0; s <= k; s++) {
+         double v[NX];
+         for(i = 0; i < NX; i++) {
+            v[i] = B[i];
+         }
+         for(m = 0; m < k - s; m++) {
+            double w[NX];
+            for(i = 0; i < NX; i++) {
+               w[i] = 0;
+               for(j = 0; j < NX; j++) {
+                  w[i] += A[i][j] * v[j];
+               }
+            }
+            memcpy(v, w, sizeof(v));
+         }
+         for(i = 0; i < NX; i++) {
+            Gam[k][i][s] = v[i];
+         }
+      }
+      for(i = 0; i < NX; i++) {
+         for(j = 0; j < NX; j++) {
+            W[k][i][j] = (k == N - 1) ? P[i][j] : (i == j ? Qw[i] : 0);
+         }
+      }
+   }
+
+   memset(H, 0, sizeof(H));
+   memset(Fx, 0, sizeof(Fx));
+   for(k = 0; k < N; k++) {
+      double wg[NX][N], wp[NX][NX];
+      for(i = 0; i < NX; i++) {
+         for(j = 0; j < N; j++) {
+            wg[i][j] = 0;
+            for(m = 0; m < NX; m++) {
+               wg[i][j] += W[k][i][m] * Gam[k][m][j];
+            }
+         }
+         for(j = 0; j < NX; j++) {
+            wp[i][j] = 0;
+            for(m = 0; m < NX; m++) {
+               wp[i][j] += W[k][i][m] * Phi[k][m][j];
+            }
+         }
+      }
+      for(i = 0; i < N; i++) {
+         for(j = 0; j < N; j++) {
+            for(m = 0; m < NX; m++) {
+               H[i][j] += Gam[k][m][i] * wg[m][j];
+            }
+         }
+         for(j = 0; j < NX; j++) {
+            for(m = 0; m < NX; m++) {
+               Fx[i][j] += Gam[k][m][i] * wp[m][j];
+            }
+         }
+      }
+   }
+   for(i = 0; i < N; i++) {
+      H[i][i] += RW;
+   }
+
+   /* constraint rows: u_k, then arm angle after step k */
+   memset(C, 0, sizeof(C));
+   for(k = 0; k < N; k++) {
+      C[k][k] = 1.0;
+      for(j = 0; j < N; j++) {
+         C[N + k][j] = Gam[k][0][j];
+      }
+   }
+
+   /* factor H + rho C'C once for the ADMM iterations */
+   {
+      double M[N][N];
+      for(i = 0; i < N; i++) {
+         for(j = 0; j < N; j++) {
+            M[i][j] = H[i][j];
+            for(m = 0; m < NC; m++) {
+               M[i][j] += RHO * C[m][i] * C[m][j];
+            }
+         }
+      }
+      memset(Lchol, 0, sizeof(Lchol));
+      for(j = 0; j < N; j++) {
+         double d = M[j][j];
+         for(m = 0; m < j; m++) {
+            d -= Lchol[j][m] * Lchol[j][m];
+         }
+         Lchol[j][j] = sqrt(d);
+         for(i = j + 1; i < N; i++) {
+            double v = M[i][j];
+            for(m = 0; m < j; m++) {
+               v -= Lchol[i][m] * Lchol[j][m];
+            }
+            Lchol[i][j] = v / Lchol[j][j];
+         }
+      }
+   }
+}
+
+static void cholSolve(double x[N], const double b[N]) {
+   double y[N];
+   int i, m;
+   for(i = 0; i < N; i++) {
+      y[i] = b[i];
+      for(m = 0; m < i; m++) {
+         y[i] -= Lchol[i][m] * y[m];
+      }
+      y[i] /= Lchol[i][i];
+   }
+   for(i = N - 1; i >= 0; i--) {
+      x[i] = y[i];
+      for(m = i + 1; m < N; m++) {
+         x[i] -= Lchol[m][i] * x[m];
+      }
+      x[i] /= Lchol[i][i];
+   }
+}
+
+/* first move of the MPC solution at x0, by ADMM */
+static double solveMPC(const double x0[NX]) {
+   double f[N], lo[NC], hi[NC], z[NC], y[NC], U[N], rhs[N], cu[NC];
+   int i, j, it, m;
+
+   for(i = 0; i < N; i++) {
+      f[i] = 0;
+      for(j = 0; j < NX; j++) {
+         f[i] += Fx[i][j] * x0[j];
+      }
+   }
+   for(i = 0; i < N; i++) {
+      lo[i] = -TAU_MAX;
+      hi[i] = TAU_MAX;
+   }
+   for(i = 0; i < N; i++) {
+      double free = 0;
+      for(j = 0; j < NX; j++) {
+         free += Phi[i][0][j] * x0[j];
+      }
+      lo[N + i] = -ARM_MAX - free;
+      hi[N + i] = ARM_MAX - free;
+   }
+   memset(z, 0, sizeof(z));
+   memset(y, 0, sizeof(y));
+   for(it = 0; it < 3000; it++) {
+      for(i = 0; i < N; i++) {
+         rhs[i] = -f[i];
+         for(m = 0; m < NC; m++) {
+            rhs[i] += C[m][i] * (RHO * z[m] - y[m]);
+         }
+      }
+      cholSolve(U, rhs);
+      for(m = 0; m < NC; m++) {
+         cu[m] = 0;
+         for(i = 0; i < N; i++) {
+            cu[m] += C[m][i] * U[i];
+         }
+         z[m] = cu[m] + y[m] / RHO;
+         if(z[m] < lo[m]) {
+            z[m] = lo[m];
+         }
+         if(z[m] > hi[m]) {
+            z[m] = hi[m];
+         }
+         y[m] += RHO * (cu[m] - z[m]);
+      }
+   }
+   /* the applied move always respects the torque box */
+   return z[0];
+}
+
+static uint32_t lcg = 12345;
+static double frand(void) {
+   lcg = lcg * 1664525u + 1013904223u;
+   return (lcg >> 8) / 16777216.0;
+}
+
+/* weighted least squares affine fit over the box corners, center and a few
+   random interior points; returns the worst error of the saturated fit */
+static double fitBox(const double lo[NX], const double hi[NX],
+                     double gain[NX], double *offset) {
+   enum { NPTS = (1 << NX) + 1 + 24 };
+   double pts[NPTS][NX], u[NPTS];
+   double ata[NX + 1][NX + 1], atb[NX + 1], sol[NX + 1];
+   double worst = 0;
+   int p, i, j, k;
+
+   for(p = 0; p < (1 << NX); p++) {
+      for(i = 0; i < NX; i++) {
+         pts[p][i] = (p >> i) & 1 ? hi[i] : lo[i];
+      }
+   }
+   for(i = 0; i < NX; i++) {
+      pts[1 << NX][i] = 0.5 * (lo[i] + hi[i]);
+   }
+   for(p = (1 << NX) + 1; p < NPTS; p++) {
+      for(i = 0; i < NX; i++) {
+         pts[p][i] = lo[i] + frand() * (hi[i] - lo[i]);
+      }
+   }
+   for(p = 0; p < NPTS; p++) {
+      u[p] = solveMPC(pts[p]);
+   }
+
+   memset(ata, 0, sizeof(ata));
+   memset(atb, 0, sizeof(atb));
+   for(p = 0; p < NPTS; p++) {
+      double row[NX + 1];
+      /* the target saturates the law, so saturated samples only need the
+         fit to land beyond the limit; weight them down */
+      double w = fabs(u[p]) < 0.999 * TAU_MAX ? 1.0 : 1e-3;
+      for(i = 0; i < NX; i++) {
+         row[i] = pts[p][i];
+      }
+      row[NX] = 1.0;
+      for(i = 0; i <= NX; i++) {
+         for(j = 0; j <= NX; j++) {
+            ata[i][j] += w * row[i] * row[j];
+         }
+         atb[i] += w * row[i] * u[p];
+      }
+   }
+   /* gaussian elimination with partial pivoting */
+   for(k = 0; k <= NX; k++) {
+      int piv = k;
+      for(i = k + 1; i <= NX; i++) {
+         if(fabs(ata[i][k]) > fabs(ata[piv][k])) {
+            piv = i;
+         }
+      }
+      for(j = 0; j <= NX; j++) {
+         double t = ata[k][j];
+         ata[k][j] = ata[piv][j];
+         ata[piv][j] = t;
+      }
+      {
+         double t = atb[k];
+         atb[k] = atb[piv];
+         atb[piv] = t;
+      }
+      for(i = k + 1; i <= NX; i++) {
+         double r = ata[i][k] / ata[k][k];
+         for(j = k; j <= NX; j++) {
+            ata[i][j] -= r * ata[k][j];
+         }
+         atb[i] -= r * atb[k];
+      }
+   }
+   for(k = NX; k >= 0; k--) {
+      sol[k] = atb[k];
+      for(j = k + 1; j <= NX; j++) {
+         sol[k] -= ata[k][j] * sol[j];
+      }
+      sol[k] /= ata[k][k];
+   }
+
+   for(p = 0; p < NPTS; p++) {
+      double e = sol[NX];
+      for(i = 0; i < NX; i++) {
+         e += sol[i] * pts[p][i];
+      }
+      /* the target saturates, so error beyond the limit does not count */
+      if(e > TAU_MAX) {
+         e = TAU_MAX;
+      }
+      if(e < -TAU_MAX) {
+         e = -TAU_MAX;
+      }
+      e = fabs(e - u[p]);
+      if(e > worst) {
+         worst = e;
+      }
+   }
+   memcpy(gain, sol, sizeof(double) * NX);
+   *offset = sol[NX];
+   return worst;
+}
+
+static int newLeaf(const double lo[NX], const double hi[NX], int depth) {
+   node_t *n = &tree[nodeCount];
+   n->leaf = 1;
+   n->depth = depth;
+   memcpy(n->lo, lo, sizeof(n->lo));
+   memcpy(n->hi, hi, sizeof(n->hi));
+   n->err = fitBox(lo, hi, n->gain, &n->offset);
+   if(depth > maxDepthSeen) {
+      maxDepthSeen = depth;
+   }
+   leafCount++;
+   return nodeCount++;
+}
+
+/* greedy refinement: always split the region with the worst fit, so the
+   leaf budget goes where the MPC law is most nonlinear */
+static int build(void) {
+   int root = newLeaf(lower, upper, 0);
+
+   while(leafCount < MAX_LEAVES) {
+      int i, d = 0, worst = -1;
+      double w = 0, mid, l2[NX], h2[NX];
+      node_t *n;
+
+      for(i = 0; i < nodeCount; i++) {
+         if(tree[i].leaf && tree[i].err > FIT_TOL && tree[i].depth < MAX_DEPTH
+            && (worst < 0 || tree[i].err > tree[worst].err)) {
+            worst = i;
+         }
+      }
+      if(worst < 0) {
+         break;
+      }
+
+      n = &tree[worst];
+      for(i = 0; i < NX; i++) {
+         double r = (n->hi[i] - n->lo[i]) / (upper[i] - lower[i]);
+         if(r > w) {
+            w = r;
+            d = i;
+         }
+      }
+      mid = 0.5 * (n->lo[d] + n->hi[d]);
+      n->leaf = 0;
+      n->dim = d;
+      n->split = mid;
+      leafCount--;
+
+      memcpy(l2, n->lo, sizeof(l2));
+      memcpy(h2, n->hi, sizeof(h2));
+      h2[d] = mid;
+      n->left = newLeaf(l2, h2, n->depth + 1);
+      n = &tree[worst];
+      memcpy(l2, n->lo, sizeof(l2));
+      memcpy(h2, n->hi, sizeof(h2));
+      l2[d] = mid;
+      n->right = newLeaf(l2, h2, n->depth + 1);
+   }
+   return root;
+}
+
+/* interior nodes and leaves are numbered separately for the two arrays */
+static int *nodeIndex;
+
+static unsigned ref(int i) {
+   return (0x8000u * tree[i].leaf) | (unsigned)nodeIndex[i];
+}
+
+/* angles go to counts and rates to counts/s, so every state has the same scale */
+static double unitScale(int dim) {
+   (void)dim;
+   return COUNTS_PER_RAD;
+}
+
+int main(void) {
+   int i, j, inner = 0, leaves = 0, root;
+   double worst = 0;
+
+   buildModel();
+   buildQP();
+
+   tree = calloc(2 * MAX_LEAVES, sizeof(node_t));
+   nodeIndex = calloc(2 * MAX_LEAVES, sizeof(int));
+   root = build();
+   for(i = 0; i < nodeCount; i++) {
+      if(tree[i].leaf) {
+         nodeIndex[i] = leaves++;
+         worst = fmax(worst, tree[i].err);
+      } else {
+         nodeIndex[i] = inner++;
+      }
+   }
+
+   printf("/* Generated by tools/empc_gen.c, do not edit.\n");
+   printf(" * horizon %d x %g s, |u| <= %g Nm, |arm| <= %g rad\n",
+          N, DT, TAU_MAX, ARM_MAX);
+   printf(" * %d regions, depth %d, worst fit error %.1f of 1000 */\n",
+          leafCount, maxDepthSeen, worst / TAU_MAX * 1000.0);
+   printf("#include \"empc.h\"\n\n");
+
+   printf("const uint8_t empcGainShift = %d;\n\n", GAIN_SHIFT);
+   printf("const int32_t empcLower[EMPC_NX] = { ");
+   for(i = 0; i < NX; i++) {
+      printf("%ld%s", lround(lower[i] * unitScale(i)), i < NX - 1 ? ", " : " };\n");
+   }
+   printf("const int32_t empcUpper[EMPC_NX] = { ");
+   for(i = 0; i < NX; i++) {
+      printf("%ld%s", lround(upper[i] * unitScale(i)), i < NX - 1 ? ", " : " };\n\n");
+   }
+
+   printf("const uint16_t empcRoot = 0x%04x;\n\n", ref(root));
+
+   printf("const empcNode_t empcNodes[] = {\n");
+   if(inner == 0) {
+      printf("   { 0, 0, 0, 0 }\n");
+   }
+   for(i = 0; i < nodeCount; i++) {
+      if(!tree[i].leaf) {
+         printf("   { %ld, 0x%04x, 0x%04x, %d },\n",
+                lround(tree[i].split * unitScale(tree[i].dim)),
+                ref(tree[i].left), ref(tree[i].right), tree[i].dim);
+      }
+   }
+   printf("};\n\n");
+
+   printf("const empcLeaf_t empcLeaves[] = {\n");
+   for(i = 0; i < nodeCount; i++) {
+      if(tree[i].leaf) {
+         printf("   { {");
+         for(j = 0; j < NX; j++) {
+            /* Nm per rad -> command per count, then scaled by 2^shift */
+            double g = tree[i].gain[j] / TAU_MAX * 1000.0
+                       / unitScale(j) * (double)(1 << GAIN_SHIFT);
+            printf(" %ld%s", lround(g), j < NX - 1 ? "," : "");
+         }
+         printf(" }, %ld },\n", lround(tree[i].offset / TAU_MAX * 1000.0));
+      }
+   }
+   printf("};\n");
+
+   fprintf(stderr, "empc_gen: %d regions, %d nodes, depth %d, worst error %.1f\n",
+           leafCount, inner, maxDepthSeen, worst / TAU_MAX * 1000.0);
+   return 0;
+}